@@ -47,9 +47,21 @@ SOURCES += \
     src/ArtworkCacheManager.cpp \
     src/MemoryMonitor.cpp \
     src/PodcastIndexClient.cpp \
+    src/PodcastIndexProjection.cpp \
+    src/ReplyParser.cpp \
+    src/ResponseCache.cpp \
+    src/ResponseCacheJob.cpp \
     src/StreamUrlResolver.cpp \
     src/TlsChecker.cpp \
     src/StorageManager.cpp \
+    src/RecentEpisodesModel.cpp \
+    src/SearchHistory.cpp \
+    src/SearchResultsModel.cpp \
+    src/Opml.cpp \
+    src/StatementCache.cpp \
+    src/StatementProfiler.cpp \
+    src/StorageWorker.cpp \
+    src/SubscriptionListModel.cpp \
     src/AudioEngine.cpp
 
 HEADERS += \
@@ -57,10 +69,22 @@ HEADERS += \
     src/MemoryMonitor.h \
     src/PodcastIndexClient.h \
     src/PodcastIndexConfig.h \
+    src/PodcastIndexProjection.h \
+    src/ReplyParser.h \
+    src/ResponseCache.h \
+    src/ResponseCacheJob.h \
     src/StreamUrlResolver.h \
     src/TlsChecker.h \
     src/AppConfig.h \
     src/StorageManager.h \
+    src/RecentEpisodesModel.h \
+    src/SearchHistory.h \
+    src/SearchResultsModel.h \
+    src/Opml.h \
+    src/StatementCache.h \
+    src/StatementProfiler.h \
+    src/StorageWorker.h \
+    src/SubscriptionListModel.h \
     src/AudioEngine.h
 
 RESOURCES += \
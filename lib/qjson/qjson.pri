@@ -16,6 +16,7 @@ PUBLIC_HEADERS += \
     $$PWD/qobjecthelper.h \
     $$PWD/serializer.h \
     $$PWD/serializerrunnable.h \
+    $$PWD/streamreader.h \
     $$PWD/qjson_export.h
 
 HEADERS += $$PRIVATE_HEADERS $$PUBLIC_HEADERS
@@ -27,4 +28,5 @@ SOURCES += \
     $$PWD/parserrunnable.cpp \
     $$PWD/qobjecthelper.cpp \
     $$PWD/serializer.cpp \
-    $$PWD/serializerrunnable.cpp
+    $$PWD/serializerrunnable.cpp \
+    $$PWD/streamreader.cpp
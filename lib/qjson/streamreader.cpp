@@ -0,0 +1,460 @@
+/* This file is part of qjson
+  *
+  * This library is free software; you can redistribute it and/or
+  * modify it under the terms of the GNU Lesser General Public
+  * License version 2.1, as published by the Free Software Foundation.
+  *
+  *
+  * This library is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  * Lesser General Public License for more details.
+  *
+  * You should have received a copy of the GNU Lesser General Public License
+  * along with this library; see the file COPYING.LIB.  If not, write to
+  * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  * Boston, MA 02110-1301, USA.
+  */
+
+#include "streamreader.h"
+
+#include <QtCore/QVarLengthArray>
+
+#include <string.h>
+
+using namespace QJson;
+
+class QJson::StreamReader::Private
+{
+  public:
+    enum State {
+      ExpectValue,
+      ExpectValueOrEnd,   // just after '['
+      ExpectName,         // after ',' in an object
+      ExpectNameOrEnd,    // just after '{'
+      AfterValue
+    };
+
+    explicit Private(const QByteArray& data);
+
+    StreamReader::TokenType setToken(StreamReader::TokenType type);
+    StreamReader::TokenType fail(const char* message);
+    void skipWhitespace();
+    bool scanString();
+    bool scanNumber();
+    bool scanLiteral(const char* literal);
+    StreamReader::TokenType readValue();
+    StreamReader::TokenType closeContainer(char bracket);
+
+    QByteArray m_data;
+    const char* m_pos;
+    const char* m_end;
+    State m_state;
+    // '{' or '[' per open container.
+    QVarLengthArray<char, 32> m_stack;
+
+    StreamReader::TokenType m_type;
+    const char* m_tokenBegin;
+    const char* m_tokenEnd;
+    bool m_hasEscapes;
+    bool m_isInteger;
+
+    QString m_error;
+};
+
+StreamReader::Private::Private(const QByteArray& data)
+  : m_data(data),
+    m_pos(m_data.constData()),
+    m_end(m_data.constData() + m_data.size()),
+    m_state(ExpectValue),
+    m_type(StreamReader::NoToken),
+    m_tokenBegin(0),
+    m_tokenEnd(0),
+    m_hasEscapes(false),
+    m_isInteger(false)
+{
+}
+
+StreamReader::TokenType StreamReader::Private::setToken(StreamReader::TokenType type)
+{
+  m_type = type;
+  return type;
+}
+
+StreamReader::TokenType StreamReader::Private::fail(const char* message)
+{
+  m_error = QString::fromLatin1("%1 at offset %2")
+      .arg(QLatin1String(message))
+      .arg(int(m_pos - m_data.constData()));
+  m_tokenBegin = m_tokenEnd = 0;
+  return setToken(StreamReader::Invalid);
+}
+
+void StreamReader::Private::skipWhitespace()
+{
+  while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+    ++m_pos;
+  }
+}
+
+bool StreamReader::Private::scanString()
+{
+  // m_pos is on the opening quote.
+  ++m_pos;
+  m_tokenBegin = m_pos;
+  m_hasEscapes = false;
+  while (m_pos < m_end) {
+    const char c = *m_pos;
+    if (c == '"') {
+      m_tokenEnd = m_pos;
+      ++m_pos;
+      return true;
+    }
+    if (c == '\\') {
+      m_hasEscapes = true;
+      m_pos += 2;
+      continue;
+    }
+    ++m_pos;
+  }
+  m_pos = m_end;
+  fail("Unterminated string");
+  return false;
+}
+
+bool StreamReader::Private::scanNumber()
+{
+  m_tokenBegin = m_pos;
+  m_isInteger = true;
+  if (m_pos < m_end && *m_pos == '-') {
+    ++m_pos;
+  }
+  const char* digits = m_pos;
+  while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+    ++m_pos;
+  }
+  if (m_pos == digits) {
+    fail("Invalid number");
+    return false;
+  }
+  if (m_pos < m_end && *m_pos == '.') {
+    m_isInteger = false;
+    ++m_pos;
+    digits = m_pos;
+    while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+      ++m_pos;
+    }
+    if (m_pos == digits) {
+      fail("Invalid number");
+      return false;
+    }
+  }
+  if (m_pos < m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+    m_isInteger = false;
+    ++m_pos;
+    if (m_pos < m_end && (*m_pos == '+' || *m_pos == '-')) {
+      ++m_pos;
+    }
+    digits = m_pos;
+    while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+      ++m_pos;
+    }
+    if (m_pos == digits) {
+      fail("Invalid number");
+      return false;
+    }
+  }
+  m_tokenEnd = m_pos;
+  return true;
+}
+
+bool StreamReader::Private::scanLiteral(const char* literal)
+{
+  const int length = int(strlen(literal));
+  if (m_end - m_pos < length || strncmp(m_pos, literal, length) != 0) {
+    fail("Unexpected character");
+    return false;
+  }
+  m_tokenBegin = m_pos;
+  m_pos += length;
+  m_tokenEnd = m_pos;
+  return true;
+}
+
+StreamReader::TokenType StreamReader::Private::readValue()
+{
+  const char c = *m_pos;
+  switch (c) {
+    case '{':
+      ++m_pos;
+      m_stack.append('{');
+      m_state = ExpectNameOrEnd;
+      return setToken(StreamReader::StartObject);
+    case '[':
+      ++m_pos;
+      m_stack.append('[');
+      m_state = ExpectValueOrEnd;
+      return setToken(StreamReader::StartArray);
+    case '"':
+      if (!scanString()) {
+        return m_type;
+      }
+      m_state = AfterValue;
+      return setToken(StreamReader::String);
+    case 't':
+    case 'f':
+      if (!scanLiteral(c == 't' ? "true" : "false")) {
+        return m_type;
+      }
+      m_state = AfterValue;
+      return setToken(StreamReader::Bool);
+    case 'n':
+      if (!scanLiteral("null")) {
+        return m_type;
+      }
+      m_state = AfterValue;
+      return setToken(StreamReader::Null);
+    default:
+      break;
+  }
+  if (c == '-' || (c >= '0' && c <= '9')) {
+    if (!scanNumber()) {
+      return m_type;
+    }
+    m_state = AfterValue;
+    return setToken(StreamReader::Number);
+  }
+  return fail("Unexpected character");
+}
+
+StreamReader::TokenType StreamReader::Private::closeContainer(char bracket)
+{
+  ++m_pos;
+  m_stack.resize(m_stack.size() - 1);
+  m_state = AfterValue;
+  return setToken(bracket == '}' ? StreamReader::EndObject : StreamReader::EndArray);
+}
+
+StreamReader::StreamReader(const QByteArray& data)
+  : d(new Private(data))
+{
+}
+
+StreamReader::~StreamReader()
+{
+  delete d;
+}
+
+StreamReader::TokenType StreamReader::readNext()
+{
+  if (d->m_type == EndDocument || d->m_type == Invalid) {
+    return d->m_type;
+  }
+
+  d->skipWhitespace();
+  if (d->m_state == Private::AfterValue) {
+    if (d->m_stack.isEmpty()) {
+      if (d->m_pos != d->m_end) {
+        return d->fail("Unexpected data after the document");
+      }
+      return d->setToken(EndDocument);
+    }
+    if (d->m_pos == d->m_end) {
+      return d->fail("Unexpected end of data");
+    }
+    const char top = d->m_stack.constData()[d->m_stack.size() - 1];
+    const char c = *d->m_pos;
+    if (c == ',') {
+      ++d->m_pos;
+      d->m_state = top == '{' ? Private::ExpectName : Private::ExpectValue;
+      d->skipWhitespace();
+    } else if ((c == '}' && top == '{') || (c == ']' && top == '[')) {
+      return d->closeContainer(c);
+    } else {
+      return d->fail("Expected ',' or the end of the container");
+    }
+  }
+
+  if (d->m_pos == d->m_end) {
+    return d->fail("Unexpected end of data");
+  }
+  const char c = *d->m_pos;
+  if ((d->m_state == Private::ExpectNameOrEnd && c == '}')
+      || (d->m_state == Private::ExpectValueOrEnd && c == ']')) {
+    return d->closeContainer(c);
+  }
+  if (d->m_state == Private::ExpectName || d->m_state == Private::ExpectNameOrEnd) {
+    if (c != '"') {
+      return d->fail("Expected a member name");
+    }
+    if (!d->scanString()) {
+      return d->m_type;
+    }
+    const char* nameBegin = d->m_tokenBegin;
+    const char* nameEnd = d->m_tokenEnd;
+    d->skipWhitespace();
+    if (d->m_pos == d->m_end || *d->m_pos != ':') {
+      return d->fail("Expected ':'");
+    }
+    ++d->m_pos;
+    d->m_tokenBegin = nameBegin;
+    d->m_tokenEnd = nameEnd;
+    d->m_state = Private::ExpectValue;
+    return d->setToken(Name);
+  }
+  return d->readValue();
+}
+
+StreamReader::TokenType StreamReader::tokenType() const
+{
+  return d->m_type;
+}
+
+bool StreamReader::skipCurrentValue()
+{
+  TokenType type = d->m_type;
+  if (type == Name) {
+    type = readNext();
+  }
+  if (type != StartObject && type != StartArray) {
+    return type != Invalid && type != EndDocument;
+  }
+  // Container tokens are byte ranges, so walking them allocates nothing.
+  int open = 1;
+  while (open > 0) {
+    switch (readNext()) {
+      case StartObject:
+      case StartArray:
+        ++open;
+        break;
+      case EndObject:
+      case EndArray:
+        --open;
+        break;
+      case Invalid:
+      case EndDocument:
+        return false;
+      default:
+        break;
+    }
+  }
+  return true;
+}
+
+int StreamReader::depth() const
+{
+  const int open = d->m_stack.size();
+  // Start tokens are reported after their bracket is pushed.
+  if (d->m_type == StartObject || d->m_type == StartArray) {
+    return open - 1;
+  }
+  return open;
+}
+
+QString StreamReader::text() const
+{
+  if (!d->m_tokenBegin) {
+    return QString();
+  }
+  const int length = int(d->m_tokenEnd - d->m_tokenBegin);
+  if ((d->m_type != Name && d->m_type != String) || !d->m_hasEscapes) {
+    return QString::fromUtf8(d->m_tokenBegin, length);
+  }
+
+  QString result;
+  result.reserve(length);
+  const char* run = d->m_tokenBegin;
+  const char* p = d->m_tokenBegin;
+  while (p < d->m_tokenEnd) {
+    if (*p != '\\') {
+      ++p;
+      continue;
+    }
+    result.append(QString::fromUtf8(run, int(p - run)));
+    ++p;
+    if (p >= d->m_tokenEnd) {
+      break;
+    }
+    const char escape = *p++;
+    switch (escape) {
+      case 'b': result.append(QLatin1Char('\b')); break;
+      case 'f': result.append(QLatin1Char('\f')); break;
+      case 'n': result.append(QLatin1Char('\n')); break;
+      case 'r': result.append(QLatin1Char('\r')); break;
+      case 't': result.append(QLatin1Char('\t')); break;
+      case 'u':
+        if (d->m_tokenEnd - p >= 4) {
+          bool ok = false;
+          const ushort unit = QByteArray(p, 4).toUShort(&ok, 16);
+          if (ok) {
+            // Surrogate pairs arrive as two escapes and combine in QString.
+            result.append(QChar(unit));
+          }
+          p += 4;
+        }
+        break;
+      default:
+        // \" \\ \/ and anything unknown: the character itself.
+        result.append(QLatin1Char(escape));
+        break;
+    }
+    run = p;
+  }
+  result.append(QString::fromUtf8(run, int(d->m_tokenEnd - run)));
+  return result;
+}
+
+bool StreamReader::textEquals(const char* latin1) const
+{
+  if (d->m_type != Name && d->m_type != String) {
+    return false;
+  }
+  if (d->m_hasEscapes) {
+    return text() == QLatin1String(latin1);
+  }
+  const int length = int(d->m_tokenEnd - d->m_tokenBegin);
+  return int(strlen(latin1)) == length && strncmp(d->m_tokenBegin, latin1, length) == 0;
+}
+
+QVariant StreamReader::value() const
+{
+  switch (d->m_type) {
+    case String:
+      return QVariant(text());
+    case Bool:
+      return QVariant(*d->m_tokenBegin == 't');
+    case Null:
+      return QVariant();
+    case Number: {
+      const QByteArray literal = QByteArray::fromRawData(d->m_tokenBegin, int(d->m_tokenEnd - d->m_tokenBegin));
+      bool ok = false;
+      if (d->m_isInteger) {
+        // Same types as Parser: unsigned for non-negative integers.
+        if (*d->m_tokenBegin == '-') {
+          const qlonglong number = literal.toLongLong(&ok);
+          if (ok) {
+            return QVariant(number);
+          }
+        } else {
+          const qulonglong number = literal.toULongLong(&ok);
+          if (ok) {
+            return QVariant(number);
+          }
+        }
+      }
+      return QVariant(literal.toDouble(&ok));
+    }
+    default:
+      return QVariant();
+  }
+}
+
+bool StreamReader::hasError() const
+{
+  return d->m_type == Invalid;
+}
+
+QString StreamReader::errorString() const
+{
+  return d->m_error;
+}
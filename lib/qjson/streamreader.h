@@ -0,0 +1,131 @@
+/* This file is part of qjson
+  *
+  * This library is free software; you can redistribute it and/or
+  * modify it under the terms of the GNU Lesser General Public
+  * License version 2.1, as published by the Free Software Foundation.
+  *
+  *
+  * This library is distributed in the hope that it will be useful,
+  * but WITHOUT ANY WARRANTY; without even the implied warranty of
+  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  * Lesser General Public License for more details.
+  *
+  * You should have received a copy of the GNU Lesser General Public License
+  * along with this library; see the file COPYING.LIB.  If not, write to
+  * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  * Boston, MA 02110-1301, USA.
+  */
+
+#ifndef QJSON_STREAMREADER_H
+#define QJSON_STREAMREADER_H
+
+#include "qjson_export.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+
+namespace QJson {
+
+  /**
+  * @brief Event-based JSON reader that does not build a document tree
+  *
+  * The reader walks a JSON text one token at a time, in the manner of
+  * QXmlStreamReader: each readNext() call reports the next event (start or
+  * end of an object or array, a member name, or a scalar value). Tokens are
+  * kept as byte ranges into the input; text and values are only decoded
+  * when asked for, and skipCurrentValue() steps over a whole subtree without
+  * decoding or allocating anything.
+  *
+  * Scalar values convert to the same QVariant types Parser produces.
+  *
+  * @code
+  * StreamReader reader(data);
+  * while (reader.readNext() != StreamReader::EndDocument) {
+  *   if (reader.tokenType() == StreamReader::Name && reader.textEquals("title")) {
+  *     reader.readNext();
+  *     title = reader.text();
+  *   }
+  * }
+  * @endcode
+  */
+  class QJSON_EXPORT StreamReader
+  {
+    public:
+      enum TokenType {
+        NoToken,
+        Invalid,
+        StartObject,
+        EndObject,
+        StartArray,
+        EndArray,
+        Name,
+        String,
+        Number,
+        Bool,
+        Null,
+        EndDocument
+      };
+
+      /**
+      * The data is shared, not copied; it must stay unchanged while the
+      * reader is used.
+      */
+      explicit StreamReader(const QByteArray& data);
+      ~StreamReader();
+
+      /**
+      * Reads the next token and returns its type. Once EndDocument or
+      * Invalid is reached, every further call returns it again.
+      */
+      TokenType readNext();
+      TokenType tokenType() const;
+
+      /**
+      * Skips the value the reader is positioned on: after a Name token, the
+      * member's value; on StartObject or StartArray, everything up to and
+      * including the matching end token. Scalars are already consumed, so
+      * this does nothing for them.
+      * @returns false if the data ended or was malformed inside the value
+      */
+      bool skipCurrentValue();
+
+      /**
+      * Nesting level of the current token; 0 outside the top-level value,
+      * 1 for the members of the top-level object, and so on.
+      */
+      int depth() const;
+
+      /**
+      * Name and String tokens: the decoded string. Number, Bool and Null
+      * tokens: their literal text.
+      */
+      QString text() const;
+
+      /**
+      * Compares the current Name or String token to a Latin-1 string
+      * without allocating (unless the token contains escapes).
+      */
+      bool textEquals(const char* latin1) const;
+
+      /**
+      * The current scalar as a QVariant: QString, qulonglong or qlonglong
+      * for integers, double otherwise, bool, or a null QVariant. Invalid for
+      * structural tokens.
+      */
+      QVariant value() const;
+
+      bool hasError() const;
+      /**
+      * Error message including the byte offset it was detected at.
+      */
+      QString errorString() const;
+
+    private:
+      Q_DISABLE_COPY(StreamReader)
+      class Private;
+      Private* const d;
+  };
+}
+
+#endif // QJSON_STREAMREADER_H
@@ -238,6 +238,16 @@ PodinPageStackWindow {
         }
     }
 
+    Connections {
+        target: storage
+        // Settings arrive asynchronously from the storage thread
+        onVolumePercentChanged: {
+            if (audioEngine) {
+                audioEngine.volume = storage.volumePercent / 100.0;
+            }
+        }
+    }
+
     PlaybackController {
         id: playback
     }
@@ -16,6 +16,7 @@ Page {
     property string nowPlayingEnclosureType: playback && playback.enclosureType ? playback.enclosureType : ""
     property string nowPlayingEpisodeTitle: playback && playback.episodeTitle ? playback.episodeTitle : ""
     property string nowPlayingEpisodeId: playback && playback.episodeId ? playback.episodeId : ""
+    property variant episodeStates: ({})
 
     function mediaLabelFor(url, enclosureType) {
         var type = enclosureType ? enclosureType.toString().toLowerCase() : "";
@@ -52,6 +53,32 @@ Page {
         return minutes + ":" + (remaining < 10 ? "0" + remaining : remaining);
     }
 
+    function progressLabel(state, durationSeconds) {
+        if (!state || !state.positionMs || state.positionMs <= 0) {
+            return "";
+        }
+        var position = Math.floor(state.positionMs / 1000);
+        var duration = state.durationSeconds > 0 ? state.durationSeconds : durationSeconds;
+        if (duration > 0 && position >= duration - 30) {
+            return qsTr("Played");
+        }
+        return qsTr("Resume at %1").arg(formatDuration(position));
+    }
+
+    // One storage round trip for every episode currently listed.
+    function requestEpisodeStates() {
+        var episodes = apiClient.episodes;
+        var ids = [];
+        for (var i = 0; i < episodes.length; ++i) {
+            if (episodes[i].id) {
+                ids.push(String(episodes[i].id));
+            }
+        }
+        if (storage) {
+            storage.requestEpisodeStates(ids);
+        }
+    }
+
     function formatDate(epoch) {
         if (!epoch || epoch <= 0) {
             return "";
@@ -153,9 +180,20 @@ Page {
         } else if (status === PageStatus.Active && page.hasLoaded) {
             cleanupTimer.stop();
             requestEpisodesIfReady();
+            requestEpisodeStates();
         }
     }
 
+    Connections {
+        target: apiClient
+        onEpisodesChanged: page.requestEpisodeStates()
+    }
+
+    Connections {
+        target: storage
+        onEpisodeStatesLoaded: page.episodeStates = episodeStates
+    }
+
     Rectangle {
         anchors.fill: parent
         color: "#181f33"
@@ -318,6 +356,14 @@ Page {
                     font.pixelSize: 14
                     elide: Text.ElideRight
                 }
+
+                Text {
+                    width: parent.width
+                    text: page.progressLabel(page.episodeStates[String(modelData.id)], modelData.duration)
+                    color: "#7fb2ff"
+                    font.pixelSize: 12
+                    visible: text.length > 0
+                }
             }
 
             MouseArea {
@@ -24,6 +24,10 @@ Item {
     property bool pauseAfterSeek: false
     property int seekTargetMs: -1
     property bool resumeAfterSeek: false
+    // Saved position/play state requested but not delivered yet; playback
+    // waits for it so the resume seek and paused state apply from the start.
+    property bool awaitingSavedState: false
+    property bool playWhenStateLoaded: false
 
     // Sleep timer state
     property int sleepMinutesRemaining: 0
@@ -91,23 +95,20 @@ Item {
         pendingSeekMs = 0;
         resumeApplied = false;
         pauseAfterSeek = false;
+        awaitingSavedState = false;
+        playWhenStateLoaded = false;
         resetFallbackState();
 
-        // Load saved state if available
-        if (storage && episodeId.length > 0) {
-            var stateMap = storage.loadEpisodeState(episodeId);
-            pendingSeekMs = stateMap.positionMs ? stateMap.positionMs : 0;
-            var lastState = stateMap.playState ? stateMap.playState : 0;
-            if (lastState === 2) {
-                pauseAfterSeek = true;
-                manualPaused = true;
-            }
-        }
-
         console.log("PlaybackController: Starting episode:", originalUrl);
 
         var shouldAutoPlay = (autoPlay === undefined) ? true : autoPlay;
-        if (shouldAutoPlay) {
+        // Load saved state if available; applySavedState() starts playback.
+        // The reply may arrive synchronously, so the flags are set first.
+        if (storage && episodeId.length > 0) {
+            awaitingSavedState = true;
+            playWhenStateLoaded = shouldAutoPlay;
+            storage.requestEpisodeState(episodeId);
+        } else if (shouldAutoPlay) {
             resolveAndPlay();
         }
     }
@@ -121,6 +122,11 @@ Item {
             return;
         }
 
+        if (awaitingSavedState) {
+            playWhenStateLoaded = true;
+            return;
+        }
+
         // If streamUrl is empty, resolve first
         var streamUrlStr = streamUrl ? streamUrl.toString() : "";
         var originalUrlStr = originalUrl ? originalUrl.toString() : "";
@@ -453,9 +459,28 @@ Item {
         }
     }
 
+    function applySavedState(epId, savedState) {
+        // Ignore late results for a previous episode and repeat deliveries
+        if (epId !== episodeId || !awaitingSavedState) {
+            return;
+        }
+        awaitingSavedState = false;
+        pendingSeekMs = savedState.positionMs ? savedState.positionMs : 0;
+        var lastState = savedState.playState ? savedState.playState : 0;
+        if (lastState === 2) {
+            pauseAfterSeek = true;
+            manualPaused = true;
+        }
+        if (playWhenStateLoaded) {
+            playWhenStateLoaded = false;
+            resolveAndPlay();
+        }
+    }
+
     Connections {
         target: storage
         ignoreUnknownSignals: true
+        onEpisodeStateLoaded: playback.applySavedState(episodeId, episodeState)
         onSleepTimerMinutesChanged: {
             if (storage.sleepTimerMinutes <= 0) {
                 playback.sleepMinutesRemaining = 0;
@@ -23,6 +23,7 @@ Page {
     property bool hasArtwork: storage && storage.enableArtworkLoading &&
                               cachedArtworkPath && cachedArtworkPath.length > 0
     property string storageError: ""
+    property string statementStats: ""
 
     function stripHtml(html) {
         if (!html) return "";
@@ -46,6 +47,9 @@ Page {
                 page.lastRequestedFeedId = page.feedId;
                 page.lastRequestedGuid = "";
                 apiClient.fetchPodcast(page.feedId);
+                // Runs alongside the detail request, so the episodes page
+                // opens with its list already loaded.
+                apiClient.fetchEpisodes(page.feedId);
             }
             return;
         }
@@ -294,7 +298,7 @@ Page {
                         storage.unsubscribe(page.feedId);
                     } else {
                         storage.subscribe(page.feedId, page.podcastTitle, page.podcastImage.toString(),
-                                          page.podcastGuid, page.imageUrlHash);
+                                          page.podcastGuid, page.imageUrlHash, page.podcastUrl);
                     }
                     page.storageError = storage.lastError ? storage.lastError : "";
                     page.refreshSubscriptionState();
@@ -355,7 +359,7 @@ Page {
 
                 Text {
                     width: parent.width
-                    text: "Subscriptions count: " + (storage && storage.subscriptions ? storage.subscriptions.length : 0)
+                    text: "Subscriptions count: " + (storage ? storage.subscriptionModel.count : 0)
                     color: "#b7c4e0"
                     font.pixelSize: 14
                 }
@@ -402,6 +406,39 @@ Page {
                     font.pixelSize: 14
                     wrapMode: Text.WrapAnywhere
                 }
+
+                Button {
+                    width: parent.width
+                    text: "Dump SQL timings"
+                    enabled: storage !== null
+                    onClicked: storage.dumpStatementStats()
+                }
+
+                Text {
+                    width: parent.width
+                    text: page.statementStats
+                    visible: page.statementStats.length > 0
+                    color: "#b7c4e0"
+                    font.pixelSize: 12
+                    wrapMode: Text.WrapAnywhere
+                }
+
+                Text {
+                    width: parent.width
+                    property variant stats: apiClient.cacheStats
+                    text: "API cache: " + stats.hits + " hits, " + stats.revalidated + " revalidated, "
+                          + stats.misses + " misses, " + stats.coalesced + " coalesced, "
+                          + stats.entries + " entries"
+                    color: "#b7c4e0"
+                    font.pixelSize: 14
+                    wrapMode: Text.WrapAnywhere
+                }
+
+                Button {
+                    width: parent.width
+                    text: "Clear API cache"
+                    onClicked: apiClient.clearResponseCache()
+                }
             }
 
             Item {
@@ -501,5 +538,16 @@ Page {
         onLastErrorChanged: {
             page.storageError = storage.lastError ? storage.lastError : "";
         }
+        onStatementStatsDumped: {
+            // Top statements by total time; the full table is in podin.log.
+            var lines = [];
+            for (var i = 0; i < stats.length && i < 8; i++) {
+                var row = stats[i];
+                lines.push((row.connection === "podin-read" ? "R " : "W ") + row.count + "x " + row.totalMs.toFixed(1) + " ms, max "
+                           + row.maxMs.toFixed(1) + ", p95 " + row.p95Ms.toFixed(1)
+                           + ": " + row.sql.substring(0, 60));
+            }
+            page.statementStats = lines.length > 0 ? lines.join("\n") : "No statements timed yet";
+        }
     }
 }
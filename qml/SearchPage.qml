@@ -16,13 +16,17 @@ Page {
     property int lastTotalCount: 0
     property bool canLoadMore: false
     property bool isLoadingMore: false
-    property real restoreContentY: 0
     property variant imageSizeSeen: ({})
     property int imageSizeCount: 0
     property int imageTotalWidth: 0
     property int imageTotalHeight: 0
     property int imageTotalPixels: 0
     property string imageSizeSummary: ""
+    property variant subscribedFlags: []
+    // Matches from the on-device index, shown above the network results.
+    property variant localResults: []
+    // Previous searches matching what is being typed.
+    property variant suggestions: []
 
     function resetSearchState() {
         page.searchOffset = 0;
@@ -30,7 +34,6 @@ Page {
         page.lastTotalCount = 0;
         page.canLoadMore = false;
         page.isLoadingMore = false;
-        page.restoreContentY = 0;
         page.resetImageStats();
     }
 
@@ -62,7 +65,12 @@ Page {
         if (page.lastSearchTerm.length > 0 && storage) {
             storage.addSearchHistory(page.lastSearchTerm);
         }
+        page.suggestions = [];
         page.resetSearchState();
+        page.localResults = [];
+        if (page.lastSearchTerm.length > 0 && storage) {
+            storage.searchLocal(page.lastSearchTerm);
+        }
         apiClient.search(page.lastSearchTerm);
     }
 
@@ -71,13 +79,12 @@ Page {
             return;
         }
         page.isLoadingMore = true;
-        page.restoreContentY = podcastList.contentY;
-        page.searchOffset = apiClient.podcasts.length;
+        page.searchOffset = apiClient.searchResults.count;
         var nextMax = page.searchOffset + page.searchPageSize;
         if (page.searchMaxResults > 0 && nextMax > page.searchMaxResults) {
             nextMax = page.searchMaxResults;
         }
-        if (nextMax <= apiClient.podcasts.length) {
+        if (nextMax <= apiClient.searchResults.count) {
             page.isLoadingMore = false;
             page.canLoadMore = false;
             return;
@@ -109,14 +116,6 @@ Page {
         page.imageSizeSummary = "Avg cover: " + avgW + "x" + avgH + " px (~" + avgBytes + " KB decoded)";
     }
 
-    Timer {
-        id: restoreScrollTimer
-        interval: 1
-        running: false
-        repeat: false
-        onTriggered: podcastList.contentY = page.restoreContentY
-    }
-
     function proxyImageUrl(item) {
         if (item.guid && item.imageUrlHash) {
             return "https://podcastimage.liya.design/hash/"
@@ -125,6 +124,11 @@ Page {
         return item.image ? item.image : "";
     }
 
+    function refreshSubscribedFlags() {
+        var feedIds = apiClient.searchResults.feedIds();
+        page.subscribedFlags = storage ? storage.subscribedStates(feedIds) : [];
+    }
+
     function openPodcastDetails(podcast) {
         if (!pageStack || !podcast) {
             return;
@@ -194,6 +198,15 @@ Page {
                     platformRightMargin: 36
                     inputMethodHints: Qt.ImhNoPredictiveText
                     Keys.onReturnPressed: page.startSearch()
+                    onTextChanged: {
+                        page.suggestions = storage && activeFocus
+                                ? storage.searchSuggestions(text, 5) : [];
+                    }
+                    onActiveFocusChanged: {
+                        if (!activeFocus) {
+                            page.suggestions = [];
+                        }
+                    }
                 }
 
                 Image {
@@ -273,6 +286,47 @@ Page {
         }
     }
 
+    Column {
+        id: suggestionList
+        z: 2
+        anchors.top: headerBar.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.leftMargin: 16
+        anchors.rightMargin: 16
+        visible: page.suggestions.length > 0
+
+        Repeater {
+            model: page.suggestions
+
+            delegate: Rectangle {
+                width: suggestionList.width
+                height: 40
+                color: index % 2 === 0 ? "#2b354a" : "#263044"
+
+                Text {
+                    anchors.left: parent.left
+                    anchors.right: parent.right
+                    anchors.verticalCenter: parent.verticalCenter
+                    anchors.leftMargin: 12
+                    anchors.rightMargin: 12
+                    text: modelData
+                    color: "#b7c4e0"
+                    font.pixelSize: 16
+                    elide: Text.ElideRight
+                }
+
+                MouseArea {
+                    anchors.fill: parent
+                    onClicked: {
+                        searchField.text = modelData;
+                        page.startSearch();
+                    }
+                }
+            }
+        }
+    }
+
     ListView {
         id: podcastList
         anchors.top: headerBar.bottom
@@ -284,7 +338,79 @@ Page {
         anchors.topMargin: 8
         anchors.bottomMargin: 16
         spacing: 8
-        model: apiClient.podcasts
+        model: apiClient.searchResults
+
+        header: Column {
+            width: podcastList.width
+            spacing: 8
+            visible: page.localResults.length > 0
+
+            Text {
+                width: parent.width
+                text: qsTr("On this device")
+                font.pixelSize: 16
+                color: "#9fb0d3"
+                visible: page.localResults.length > 0
+            }
+
+            Repeater {
+                model: page.localResults
+
+                delegate: Rectangle {
+                    width: podcastList.width
+                    height: localTextCol.height + 16
+                    radius: 6
+                    color: "#24304a"
+
+                    Column {
+                        id: localTextCol
+                        anchors.left: parent.left
+                        anchors.right: parent.right
+                        anchors.top: parent.top
+                        anchors.margins: 8
+                        spacing: 2
+
+                        Text {
+                            width: parent.width
+                            text: modelData.title
+                            color: platformStyle.colorNormalLight
+                            font.pixelSize: 18
+                            elide: Text.ElideRight
+                            maximumLineCount: 1
+                        }
+
+                        Text {
+                            width: parent.width
+                            text: modelData.kind === "episode"
+                                  ? (modelData.podcastTitle ? qsTr("Episode of %1").arg(modelData.podcastTitle) : qsTr("Episode"))
+                                  : qsTr("Subscribed")
+                            color: "#7fb2ff"
+                            font.pixelSize: 12
+                            elide: Text.ElideRight
+                            maximumLineCount: 1
+                        }
+                    }
+
+                    MouseArea {
+                        anchors.fill: parent
+                        onClicked: {
+                            var item = modelData;
+                            page.openPodcastDetails({
+                                feedId: item.feedId,
+                                guid: item.guid,
+                                title: item.kind === "episode" ? item.podcastTitle : item.title
+                            });
+                        }
+                    }
+                }
+            }
+
+            Item {
+                width: parent.width
+                height: 4
+                visible: page.localResults.length > 0
+            }
+        }
 
         footer: Item {
             width: podcastList.width
@@ -295,7 +421,7 @@ Page {
                 width: parent.width
                 text: apiClient.busy ? qsTr("Loading...") : qsTr("Load More")
                 enabled: !apiClient.busy
-                visible: page.hasSearched && apiClient.podcasts.length > 0 && page.canLoadMore
+                visible: page.hasSearched && apiClient.searchResults.count > 0 && page.canLoadMore
                 onClicked: page.loadMore()
             }
         }
@@ -322,7 +448,7 @@ Page {
                 Image {
                     anchors.fill: parent
                     anchors.margins: 2
-                    source: storage && storage.enableArtworkLoading ? page.proxyImageUrl(modelData) : ""
+                    source: storage && storage.enableArtworkLoading ? page.proxyImageUrl(model) : ""
                     fillMode: Image.PreserveAspectFit
                     smooth: true
                     asynchronous: true
@@ -332,7 +458,7 @@ Page {
                     visible: storage && storage.enableArtworkLoading && source.toString().length > 0
                     onStatusChanged: {
                         if (status === Image.Ready) {
-                            page.recordImageSize(modelData.feedId, implicitWidth, implicitHeight);
+                            page.recordImageSize(model.feedId, implicitWidth, implicitHeight);
                         }
                     }
                 }
@@ -350,7 +476,7 @@ Page {
 
                 Text {
                     width: parent.width
-                    text: modelData.title
+                    text: model.title
                     color: platformStyle.colorNormalLight
                     font.pixelSize: 18
                     elide: Text.ElideRight
@@ -359,18 +485,25 @@ Page {
 
                 Text {
                     width: parent.width
-                    text: modelData.description ? modelData.description : ""
+                    text: model.description ? model.description : ""
                     color: "#b7c4e0"
                     font.pixelSize: 14
                     wrapMode: Text.WordWrap
                     maximumLineCount: 3
                     elide: Text.ElideRight
                 }
+
+                Text {
+                    text: qsTr("Subscribed")
+                    color: "#7fb2ff"
+                    font.pixelSize: 12
+                    visible: page.subscribedFlags[index] === true
+                }
             }
 
             MouseArea {
                 anchors.fill: parent
-                onClicked: page.openPodcastDetails(modelData)
+                onClicked: page.openPodcastDetails(apiClient.searchResults.get(index))
             }
         }
     }
@@ -380,7 +513,8 @@ Page {
         text: qsTr("No results.")
         color: platformStyle.colorNormalLight
         font.pixelSize: 18
-        visible: page.hasSearched && !apiClient.busy && apiClient.podcasts.length === 0 && apiClient.errorMessage.length === 0
+        visible: page.hasSearched && !apiClient.busy && apiClient.searchResults.count === 0 &&
+                 page.localResults.length === 0 && apiClient.errorMessage.length === 0
     }
 
     Item {
@@ -393,7 +527,8 @@ Page {
         anchors.rightMargin: 16
         anchors.topMargin: 8
         anchors.bottomMargin: 16
-        visible: apiClient.podcasts.length === 0 && !apiClient.busy && storage && storage.searchHistory.length > 0
+        visible: apiClient.searchResults.count === 0 && page.localResults.length === 0 && !apiClient.busy &&
+                 storage && storage.searchHistory.length > 0
 
         Column {
             id: historyHeader
@@ -489,7 +624,8 @@ Page {
     Connections {
         target: apiClient
         onPodcastsChanged: {
-            var total = apiClient.podcasts.length;
+            page.refreshSubscribedFlags();
+            var total = apiClient.searchResults.count;
             if (page.searchOffset === 0) {
                 page.lastBatchCount = total;
             } else {
@@ -501,11 +637,9 @@ Page {
             page.lastTotalCount = total;
             page.canLoadMore = page.lastBatchCount >= page.searchPageSize &&
                                (!page.searchMaxResults || total < page.searchMaxResults);
-            if (page.isLoadingMore) {
-                page.isLoadingMore = false;
-                restoreScrollTimer.stop();
-                restoreScrollTimer.start();
-            }
+            // Rows are inserted below the existing ones, so the view keeps
+            // its scroll position.
+            page.isLoadingMore = false;
         }
     }
 
@@ -528,6 +662,13 @@ Page {
         onSearchHistoryChanged: {
             historyList.model = storage.searchHistory;
         }
+        onSubscriptionsChanged: page.refreshSubscribedFlags()
+        onLocalSearchFinished: {
+            // A newer search may have started while this one ran.
+            if (page.hasSearched && term === page.lastSearchTerm) {
+                page.localResults = results;
+            }
+        }
     }
 
     Timer {
@@ -537,6 +678,7 @@ Page {
         onTriggered: {
             page.resetSearchState();
             page.hasSearched = false;
+            page.localResults = [];
             apiClient.clearPodcasts();
         }
     }
@@ -7,6 +7,8 @@ Page {
     orientationLock: PageOrientation.LockPortrait
 
     property QtObject playback: null
+    property bool opmlBusy: false
+    property string opmlStatus: ""
 
     function sleepTimerLabel() {
         var mins = storage ? storage.sleepTimerMinutes : 0;
@@ -277,6 +279,92 @@ Page {
                     }
                 }
             }
+
+            Column {
+                width: parent.width
+                spacing: 10
+
+                Text {
+                    width: parent.width
+                    text: qsTr("Subscriptions")
+                    font.pixelSize: 18
+                    color: platformStyle.colorNormalLight
+                }
+
+                Rectangle {
+                    width: parent.width
+                    height: 1
+                    color: "#3a4a6a"
+                }
+
+                Column {
+                    width: parent.width
+                    spacing: 6
+
+                    Text {
+                        width: parent.width
+                        text: storage ? qsTr("OPML file: %1").arg(storage.defaultOpmlPath()) : ""
+                        font.pixelSize: 14
+                        color: "#b7c4e0"
+                        wrapMode: Text.WrapAnywhere
+                    }
+
+                    Button {
+                        width: parent.width
+                        text: qsTr("Import OPML")
+                        enabled: storage !== null && !page.opmlBusy
+                        onClicked: {
+                            page.opmlBusy = true;
+                            page.opmlStatus = qsTr("Importing...");
+                            storage.importOpml(storage.defaultOpmlPath());
+                        }
+                    }
+
+                    Button {
+                        width: parent.width
+                        text: qsTr("Export OPML")
+                        enabled: storage !== null && !page.opmlBusy
+                        onClicked: {
+                            page.opmlBusy = true;
+                            page.opmlStatus = qsTr("Exporting...");
+                            storage.exportOpml(storage.defaultOpmlPath());
+                        }
+                    }
+
+                    Text {
+                        width: parent.width
+                        text: page.opmlStatus
+                        visible: page.opmlStatus.length > 0
+                        font.pixelSize: 12
+                        color: "#9fb0d3"
+                        wrapMode: Text.WordWrap
+                    }
+                }
+            }
+        }
+    }
+
+    Connections {
+        target: storage
+        onSubscriptionsImported: {
+            page.opmlBusy = pending > 0;
+            if (pending > 0) {
+                page.opmlStatus = qsTr("Added %1 podcasts, looking up %2 more...").arg(added).arg(pending);
+            } else if (failed > 0) {
+                page.opmlStatus = qsTr("Added %1 podcasts; %2 could not be found.").arg(added).arg(failed);
+            } else {
+                page.opmlStatus = qsTr("Added %1 podcasts.").arg(added);
+            }
+        }
+        onOpmlExported: {
+            page.opmlBusy = false;
+            page.opmlStatus = qsTr("Exported %1 podcasts to %2").arg(count).arg(path);
+        }
+        onLastErrorChanged: {
+            if (page.opmlBusy && storage.lastError.length > 0) {
+                page.opmlBusy = false;
+                page.opmlStatus = storage.lastError;
+            }
         }
     }
 }
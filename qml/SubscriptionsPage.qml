@@ -6,7 +6,6 @@ Page {
     objectName: "SubscriptionsPage"
     orientationLock: PageOrientation.LockPortrait
 
-    property bool hasLoaded: false
     property QtObject playback: null
 
     function proxyImageUrl(item) {
@@ -83,7 +82,7 @@ Page {
         anchors.topMargin: 8
         anchors.bottomMargin: 16
         spacing: 8
-        model: storage.subscriptions
+        model: storage.subscriptionModel
 
         delegate: Rectangle {
             width: subscriptionList.width
@@ -114,7 +113,7 @@ Page {
                         Image {
                             anchors.fill: parent
                             anchors.margins: 2
-                            source: storage && storage.enableArtworkLoading ? page.proxyImageUrl(modelData) : ""
+                            source: storage && storage.enableArtworkLoading ? page.proxyImageUrl(model) : ""
                             fillMode: Image.PreserveAspectFit
                             smooth: true
                             asynchronous: true
@@ -131,7 +130,7 @@ Page {
 
                         Text {
                             width: parent.width
-                            text: modelData.title
+                            text: model.title
                             color: platformStyle.colorNormalLight
                             font.pixelSize: 18
                             maximumLineCount: 1
@@ -140,11 +139,11 @@ Page {
 
                         Text {
                             width: parent.width
-                            text: modelData.feedId ? qsTr("Feed ID: %1").arg(modelData.feedId) : ""
+                            text: model.feedId ? qsTr("Feed ID: %1").arg(model.feedId) : ""
                             color: "#93a3c4"
                             font.pixelSize: 12
                             elide: Text.ElideRight
-                            visible: modelData.feedId
+                            visible: model.feedId > 0
                         }
                     }
                 }
@@ -171,13 +170,13 @@ Page {
 
                 MouseArea {
                     anchors.fill: parent
-                    onClicked: storage.unsubscribe(modelData.feedId)
+                    onClicked: storage.unsubscribe(model.feedId)
                 }
             }
 
             MouseArea {
                 anchors.fill: contentArea
-                onClicked: page.openPodcastDetail(modelData.feedId, modelData.title, modelData.image, modelData.guid, modelData.imageUrlHash)
+                onClicked: page.openPodcastDetail(model.feedId, model.title, model.image, model.guid, model.imageUrlHash)
             }
         }
     }
@@ -187,17 +186,6 @@ Page {
         text: qsTr("No subscriptions yet.")
         color: platformStyle.colorNormalLight
         font.pixelSize: 18
-        visible: storage.subscriptions.length === 0
-    }
-
-    Component.onCompleted: {
-        page.hasLoaded = true;
-        storage.refreshSubscriptions();
-    }
-
-    onStatusChanged: {
-        if (status === PageStatus.Active && page.hasLoaded) {
-            storage.refreshSubscriptions();
-        }
+        visible: storage.subscriptionModel.count === 0
     }
 }
@@ -15,5 +15,6 @@ static const char *const kPhoneBase      = "C:/Data/Podin";
 
 // Subdirectories
 static const char *const kLogsSubdir     = "logs";
+static const char *const kHttpCacheSubdir = "http-cache";
 
 } // namespace AppConfig
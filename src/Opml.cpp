@@ -0,0 +1,129 @@
+#include "Opml.h"
+
+#include <QtCore/QDateTime>
+#include <QtCore/QIODevice>
+#include <QtCore/QLocale>
+
+namespace {
+// Non-standard outline attributes Podin writes so its own exports import
+// without a network lookup. Other readers ignore them.
+const char *const kFeedIdAttribute = "podcastIndexId";
+const char *const kGuidAttribute = "podcastGuid";
+const char *const kImageAttribute = "imageUrl";
+
+// Attribute lookup that tolerates the lower-case spellings (xmlurl) some
+// exporters use.
+QString attribute(const QXmlStreamAttributes &attributes, const char *name)
+{
+    const QString key = QLatin1String(name);
+    for (int i = 0; i < attributes.size(); ++i) {
+        if (attributes.at(i).name().toString().compare(key, Qt::CaseInsensitive) == 0) {
+            return attributes.at(i).value().toString().trimmed();
+        }
+    }
+    return QString();
+}
+}
+
+OpmlReader::OpmlReader(QIODevice *device)
+    : m_xml(device)
+{
+}
+
+bool OpmlReader::readNextFeed(QVariantMap *feed)
+{
+    while (!m_xml.atEnd()) {
+        if (m_xml.readNext() != QXmlStreamReader::StartElement
+            || m_xml.name() != QLatin1String("outline")) {
+            continue;
+        }
+
+        const QXmlStreamAttributes attributes = m_xml.attributes();
+        const QString feedUrl = attribute(attributes, "xmlUrl");
+        const int feedId = attribute(attributes, kFeedIdAttribute).toInt();
+        if (feedUrl.isEmpty() && feedId <= 0) {
+            // A category; its children are visited by the next calls.
+            continue;
+        }
+
+        QString title = attribute(attributes, "title");
+        if (title.isEmpty()) {
+            title = attribute(attributes, "text");
+        }
+        feed->clear();
+        feed->insert(QString::fromLatin1("title"), title);
+        feed->insert(QString::fromLatin1("feedUrl"), feedUrl);
+        feed->insert(QString::fromLatin1("feedId"), feedId);
+        feed->insert(QString::fromLatin1("guid"), attribute(attributes, kGuidAttribute));
+        feed->insert(QString::fromLatin1("image"), attribute(attributes, kImageAttribute));
+        return true;
+    }
+    return false;
+}
+
+bool OpmlReader::hasError() const
+{
+    return m_xml.hasError();
+}
+
+QString OpmlReader::errorString() const
+{
+    if (!m_xml.hasError()) {
+        return QString();
+    }
+    return QString::fromLatin1("%1 (line %2)").arg(m_xml.errorString()).arg(m_xml.lineNumber());
+}
+
+OpmlWriter::OpmlWriter(QIODevice *device)
+    : m_xml(device)
+{
+    m_xml.setAutoFormatting(true);
+}
+
+void OpmlWriter::writeStart(const QString &title)
+{
+    m_xml.writeStartDocument();
+    m_xml.writeStartElement(QLatin1String("opml"));
+    m_xml.writeAttribute(QLatin1String("version"), QLatin1String("2.0"));
+    m_xml.writeStartElement(QLatin1String("head"));
+    m_xml.writeTextElement(QLatin1String("title"), title);
+    // RFC 822 date, as the OPML spec asks for.
+    m_xml.writeTextElement(QLatin1String("dateCreated"),
+                           QLocale::c().toString(QDateTime::currentDateTimeUtc(),
+                                                 QLatin1String("ddd, dd MMM yyyy hh:mm:ss 'GMT'")));
+    m_xml.writeEndElement();
+    m_xml.writeStartElement(QLatin1String("body"));
+}
+
+void OpmlWriter::writeFeed(const QVariantMap &feed)
+{
+    const QString title = feed.value(QString::fromLatin1("title")).toString();
+    const QString feedUrl = feed.value(QString::fromLatin1("feedUrl")).toString();
+    const int feedId = feed.value(QString::fromLatin1("feedId")).toInt();
+    const QString guid = feed.value(QString::fromLatin1("guid")).toString();
+    const QString image = feed.value(QString::fromLatin1("image")).toString();
+
+    m_xml.writeEmptyElement(QLatin1String("outline"));
+    m_xml.writeAttribute(QLatin1String("type"), QLatin1String("rss"));
+    m_xml.writeAttribute(QLatin1String("text"), title);
+    m_xml.writeAttribute(QLatin1String("title"), title);
+    if (!feedUrl.isEmpty()) {
+        m_xml.writeAttribute(QLatin1String("xmlUrl"), feedUrl);
+    }
+    if (feedId > 0) {
+        m_xml.writeAttribute(QLatin1String(kFeedIdAttribute), QString::number(feedId));
+    }
+    if (!guid.isEmpty()) {
+        m_xml.writeAttribute(QLatin1String(kGuidAttribute), guid);
+    }
+    if (!image.isEmpty()) {
+        m_xml.writeAttribute(QLatin1String(kImageAttribute), image);
+    }
+}
+
+void OpmlWriter::writeEnd()
+{
+    m_xml.writeEndElement(); // body
+    m_xml.writeEndElement(); // opml
+    m_xml.writeEndDocument();
+}
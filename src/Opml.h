@@ -0,0 +1,47 @@
+#ifndef OPML_H
+#define OPML_H
+
+#include <QtCore/QString>
+#include <QtCore/QVariantMap>
+#include <QtCore/QXmlStreamReader>
+#include <QtCore/QXmlStreamWriter>
+
+class QIODevice;
+
+// Pull reader for OPML subscription lists. Feeds come out one at a time
+// while the device is read, so memory use does not grow with the file; the
+// category nesting other podcatchers use is flattened.
+//
+// Feed maps carry title, feedUrl and, when the file came from Podin (or
+// another client that writes them), feedId, guid and image.
+class OpmlReader
+{
+public:
+    explicit OpmlReader(QIODevice *device);
+
+    // Next outline with a feed URL or feed ID; false at the end or on error.
+    bool readNextFeed(QVariantMap *feed);
+    bool hasError() const;
+    QString errorString() const;
+
+private:
+    QXmlStreamReader m_xml;
+};
+
+// Writes an OPML 2.0 document one feed at a time. Qt 4.7's writer has no
+// error state; callers check the device.
+class OpmlWriter
+{
+public:
+    explicit OpmlWriter(QIODevice *device);
+
+    void writeStart(const QString &title);
+    // Same map shape OpmlReader produces.
+    void writeFeed(const QVariantMap &feed);
+    void writeEnd();
+
+private:
+    QXmlStreamWriter m_xml;
+};
+
+#endif // OPML_H
@@ -2,6 +2,7 @@
 
 #include <QtCore/QByteArray>
 #include <QtCore/QDateTime>
+#include <QtCore/QDir>
 #include <QtCore/QStringList>
 #include <QtCore/QTextStream>
 #include <QtCore/QUrl>
@@ -11,89 +12,118 @@
 #include <QtNetwork/QSslError>
 #include <QtNetwork/QSslSocket>
 #include <QtCore/QCryptographicHash>
+#include <QtGui/QDesktopServices>
 
+#include "AppConfig.h"
 #include "PodcastIndexConfig.h"
-#include "parser.h"
+#include "PodcastIndexProjection.h"
+#include "ReplyParser.h"
+#include "ResponseCacheJob.h"
+#include "SearchResultsModel.h"
 
 namespace {
-QString trimText(const QString &text, int maxChars)
-{
-    if (maxChars <= 0 || text.isEmpty()) {
-        return QString();
-    }
-    if (text.size() <= maxChars) {
-        return text;
-    }
-    QString trimmed = text.left(maxChars);
-    trimmed.append(QString::fromLatin1("..."));
-    return trimmed;
-}
+// Per-type request timeouts. Detail lookups are a single small object;
+// search and episode lists can be large on a slow link.
+const int kSearchTimeoutMs = 15000;
+const int kPodcastTimeoutMs = 10000;
+const int kEpisodesTimeoutMs = 15000;
+
+// How long a cached response is served without asking the server. Feed
+// metadata rarely changes; search rankings and episode lists move faster.
+// Past this age the entry is revalidated with If-None-Match /
+// If-Modified-Since when the server sent validators.
+const int kSearchMaxAgeSecs = 10 * 60;
+const int kPodcastMaxAgeSecs = 6 * 60 * 60;
+const int kEpisodesMaxAgeSecs = 15 * 60;
+
+// A result just delivered is handed straight to repeat requests for the
+// same URL within this window (back-and-forth navigation between the
+// subscription, detail and episode pages), without a cache file read.
+const uint kMemoWindowSecs = 30;
 
-QString pickString(const QVariantMap &map, const char *primary, const char *fallback = 0)
+// OPML feed lookups run this many requests side by side, and a batch is
+// given this long before its stragglers are counted as failed.
+const int kResolveBatchSize = 8;
+const int kResolveTimeoutMs = 15000;
+
+QString responseCacheDirectory()
 {
-    QString value = map.value(QLatin1String(primary)).toString();
-    if (value.isEmpty() && fallback) {
-        value = map.value(QLatin1String(fallback)).toString();
+    QString base = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+    if (base.isEmpty()) {
+        base = QDir::homePath() + QLatin1String("/.podin");
     }
-    return value;
+    return base + QLatin1Char('/') + QLatin1String(AppConfig::kHttpCacheSubdir);
 }
 
-QVariant pickValue(const QVariantMap &map, const char *primary, const char *fallback = 0)
+uint currentTime()
 {
-    QVariant value = map.value(QLatin1String(primary));
-    if ((!value.isValid() || value.isNull()) && fallback) {
-        value = map.value(QLatin1String(fallback));
-    }
-    return value;
+    return QDateTime::currentDateTimeUtc().toTime_t();
 }
 
-QString extractErrorDetail(const QByteArray &payload)
+// True if both lists show the same episodes in the same order. Cached rows
+// come back from SQLite with different QVariant types than parsed JSON.
+bool sameEpisodeList(const QVariantList &left, const QVariantList &right)
 {
-    if (payload.isEmpty()) {
-        return QString();
+    if (left.size() != right.size()) {
+        return false;
     }
-
-    QJson::Parser parser;
-    bool ok = false;
-    const QVariant parsed = parser.parse(payload, &ok);
-    if (ok) {
-        const QVariantMap map = parsed.toMap();
-        if (!map.isEmpty()) {
-            QString detail = pickString(map, "description", "message");
-            if (detail.isEmpty()) {
-                detail = pickString(map, "error");
-            }
-            if (detail.isEmpty()) {
-                detail = pickString(map, "status");
-            }
-            if (!detail.isEmpty()) {
-                return detail;
+    static const char *const kTextKeys[] = {
+        "id", "title", "enclosureUrl", "enclosureType", "description", 0
+    };
+    for (int i = 0; i < left.size(); ++i) {
+        const QVariantMap a = left.at(i).toMap();
+        const QVariantMap b = right.at(i).toMap();
+        for (int k = 0; kTextKeys[k]; ++k) {
+            const QString key = QLatin1String(kTextKeys[k]);
+            if (a.value(key).toString() != b.value(key).toString()) {
+                return false;
             }
         }
+        if (a.value(QString::fromLatin1("duration")).toInt() != b.value(QString::fromLatin1("duration")).toInt()
+            || a.value(QString::fromLatin1("datePublished")).toLongLong()
+               != b.value(QString::fromLatin1("datePublished")).toLongLong()) {
+            return false;
+        }
     }
+    return true;
+}
+}
 
-    QString text = QString::fromUtf8(payload).trimmed();
-    if (text.isEmpty()) {
-        return QString();
-    }
-    const int kMax = 240;
-    if (text.size() > kMax) {
-        text = text.left(kMax) + QString::fromLatin1("...");
-    }
-    return text;
+PodcastIndexClient::RequestSlot::RequestSlot()
+    : appendResults(false)
+{
 }
+
+PodcastIndexClient::Transfer::Transfer()
+    : type(SearchRequest)
+    , cacheTicket(0)
+    , reply(0)
+    , timeout(0)
+    , parseTicket(0)
+    , firstEntry(0)
+    , feedId(0)
+{
 }
 
 PodcastIndexClient::PodcastIndexClient(QObject *parent)
     : QObject(parent)
     , m_nam(new QNetworkAccessManager(this))
-    , m_reply(0)
+    , m_coalesced(0)
     , m_busy(false)
-    , m_requestType(NoneRequest)
+    , m_searchResults(new SearchResultsModel(this))
+    , m_episodesFeedId(0)
+    , m_requestedEpisodesFeedId(0)
     , m_loggedSslInfo(false)
+    , m_cache(responseCacheDirectory())
+    , m_cacheEntries(-1)
+    , m_nextParseTicket(1)
+    , m_resolveFailed(0)
 {
-    m_timeout.setSingleShot(true);
-    connect(&m_timeout, SIGNAL(timeout()), this, SLOT(onTimeout()));
+    m_parsePool.setMaxThreadCount(1);
+    m_resolveTimeout.setSingleShot(true);
+    connect(&m_resolveTimeout, SIGNAL(timeout()), this, SLOT(onResolveTimeout()));
+    // Lists the cache directory once, for the entry count in cacheStats.
+    startCacheJob(new ResponseCacheJob(&m_cache, ResponseCacheJob::Count, 0));
 }
 
 bool PodcastIndexClient::busy() const
@@ -106,9 +136,14 @@ QString PodcastIndexClient::errorMessage() const
     return m_errorMessage;
 }
 
+QObject *PodcastIndexClient::searchResults() const
+{
+    return m_searchResults;
+}
+
 QVariantList PodcastIndexClient::podcasts() const
 {
-    return m_podcasts;
+    return m_searchResults->toVariantList();
 }
 
 QVariantList PodcastIndexClient::episodes() const
@@ -121,6 +156,18 @@ QVariantMap PodcastIndexClient::podcastDetail() const
     return m_podcastDetail;
 }
 
+QVariantMap PodcastIndexClient::cacheStats() const
+{
+    // Not m_cache.stats(): that may list the cache directory.
+    QVariantMap stats;
+    stats.insert(QString::fromLatin1("hits"), m_cache.hits());
+    stats.insert(QString::fromLatin1("revalidated"), m_cache.revalidated());
+    stats.insert(QString::fromLatin1("misses"), m_cache.misses());
+    stats.insert(QString::fromLatin1("entries"), qMax(0, m_cacheEntries));
+    stats.insert(QString::fromLatin1("coalesced"), m_coalesced);
+    return stats;
+}
+
 void PodcastIndexClient::search(const QString &term)
 {
     startSearchRequest(term, 10, false);
@@ -202,6 +249,11 @@ void PodcastIndexClient::fetchEpisodes(int feedId)
         return;
     }
 
+    // Stale-while-revalidate: the stored list (if any) renders while the
+    // request below runs, and stays up if the network is unavailable.
+    m_requestedEpisodesFeedId = feedId;
+    emit cachedEpisodesRequested(feedId);
+
     if (apiKey().isEmpty() || apiSecret().isEmpty()) {
         setErrorMessage(QString::fromLatin1("Missing API credentials. Set PODIN_API_KEY/PODIN_API_SECRET or defaults in PodcastIndexConfig.h."));
         return;
@@ -216,18 +268,132 @@ void PodcastIndexClient::fetchEpisodes(int feedId)
 
 void PodcastIndexClient::clearPodcasts()
 {
-    if (!m_podcasts.isEmpty()) {
-        setPodcasts(QVariantList());
+    // A "Load More" still running would append its page to the emptied list.
+    if (!m_requests[SearchRequest].key.isEmpty()) {
+        detachRequest(SearchRequest);
+        updateBusy();
+    }
+    if (m_searchResults->count() > 0) {
+        setSearchResults(QVariantList(), false);
     }
 }
 
 void PodcastIndexClient::clearEpisodes()
 {
+    m_episodesFeedId = 0;
     if (!m_episodes.isEmpty()) {
         setEpisodes(QVariantList());
     }
 }
 
+void PodcastIndexClient::applyCachedEpisodes(int feedId, const QVariantList &episodes)
+{
+    if (feedId != m_requestedEpisodesFeedId || m_episodesFeedId == feedId || episodes.isEmpty()) {
+        return;
+    }
+    m_episodesFeedId = feedId;
+    setEpisodes(episodes);
+}
+
+void PodcastIndexClient::resolveFeeds(const QVariantList &feeds)
+{
+    if (feeds.isEmpty()) {
+        return;
+    }
+    if (apiKey().isEmpty() || apiSecret().isEmpty() || !QSslSocket::supportsSsl()) {
+        emit feedsResolved(QVariantList(), feeds.size());
+        return;
+    }
+    m_resolveQueue += feeds;
+    if (m_resolveReplies.isEmpty()) {
+        startResolveBatch();
+    }
+}
+
+void PodcastIndexClient::startResolveBatch()
+{
+    for (int i = 0; i < kResolveBatchSize && !m_resolveQueue.isEmpty(); ++i) {
+        const QVariantMap feed = m_resolveQueue.takeFirst().toMap();
+        QUrl url = PodcastIndexConfig::buildUrl(QString::fromLatin1("podcasts/byfeedurl"));
+        url.addQueryItem(QString::fromLatin1("url"), feed.value(QString::fromLatin1("feedUrl")).toString());
+        QNetworkReply *reply = m_nam->get(buildRequest(url));
+        connect(reply, SIGNAL(finished()), this, SLOT(onResolveReplyFinished()));
+        connect(reply, SIGNAL(sslErrors(const QList<QSslError> &)),
+                this, SLOT(onSslErrors(const QList<QSslError> &)));
+        m_resolveReplies.insert(reply, feed);
+    }
+    if (!m_resolveReplies.isEmpty()) {
+        m_resolveTimeout.start(kResolveTimeoutMs);
+        return;
+    }
+
+    // Queue drained: report the whole run at once so storage writes it in
+    // one transaction.
+    m_resolveTimeout.stop();
+    const QVariantList resolved = m_resolvedFeeds;
+    const int failed = m_resolveFailed;
+    m_resolvedFeeds.clear();
+    m_resolveFailed = 0;
+    emit feedsResolved(resolved, failed);
+}
+
+void PodcastIndexClient::onResolveReplyFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply || !m_resolveReplies.contains(reply)) {
+        return;
+    }
+    const QVariantMap requested = m_resolveReplies.take(reply);
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const bool ok = reply->error() == QNetworkReply::NoError && statusCode >= 200 && statusCode < 300;
+    const QByteArray payload = ok ? reply->readAll() : QByteArray();
+    reply->deleteLater();
+
+    QVariantMap feed;
+    if (ok) {
+        QVariant result;
+        QString errorMessage;
+        if (PodcastIndexProjection::podcastDetail(payload, &result, &errorMessage)) {
+            feed = result.toMap();
+        }
+    }
+    if (feed.value(QString::fromLatin1("feedId")).toInt() > 0) {
+        // Keep the OPML URL and title where the index has none.
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("feedId"), feed.value(QString::fromLatin1("feedId")));
+        QString title = feed.value(QString::fromLatin1("title")).toString();
+        if (title.isEmpty()) {
+            title = requested.value(QString::fromLatin1("title")).toString();
+        }
+        QString feedUrl = feed.value(QString::fromLatin1("url")).toString();
+        if (feedUrl.isEmpty()) {
+            feedUrl = requested.value(QString::fromLatin1("feedUrl")).toString();
+        }
+        entry.insert(QString::fromLatin1("title"), title);
+        entry.insert(QString::fromLatin1("feedUrl"), feedUrl);
+        entry.insert(QString::fromLatin1("image"), feed.value(QString::fromLatin1("image")));
+        entry.insert(QString::fromLatin1("guid"), feed.value(QString::fromLatin1("guid")));
+        entry.insert(QString::fromLatin1("imageUrlHash"), feed.value(QString::fromLatin1("imageUrlHash")));
+        m_resolvedFeeds.append(entry);
+    } else {
+        ++m_resolveFailed;
+    }
+
+    if (m_resolveReplies.isEmpty()) {
+        startResolveBatch();
+    }
+}
+
+void PodcastIndexClient::onResolveTimeout()
+{
+    // abort() finishes each reply synchronously; onResolveReplyFinished()
+    // counts it as failed and starts the next batch after the last one.
+    const QList<QNetworkReply *> replies = m_resolveReplies.keys();
+    for (int i = 0; i < replies.size(); ++i) {
+        replies.at(i)->abort();
+    }
+}
+
 void PodcastIndexClient::clearPodcastDetail()
 {
     if (!m_podcastDetail.isEmpty()) {
@@ -237,54 +403,268 @@ void PodcastIndexClient::clearPodcastDetail()
 
 void PodcastIndexClient::clearAll()
 {
+    for (int i = 0; i < RequestTypeCount; ++i) {
+        detachRequest(static_cast<RequestType>(i));
+    }
+    const QStringList keys = m_transfers.keys();
+    for (int i = 0; i < keys.size(); ++i) {
+        dropTransfer(keys.at(i));
+    }
     clearPodcasts();
     clearEpisodes();
     clearPodcastDetail();
     setErrorMessage(QString());
-    setBusy(false);
+    updateBusy();
+}
+
+void PodcastIndexClient::clearResponseCache()
+{
+    // Runs after any store already queued; the count arrives with the result.
+    startCacheJob(new ResponseCacheJob(&m_cache, ResponseCacheJob::Clear, 0));
+    m_memo.clear();
 }
 
 void PodcastIndexClient::startRequest(RequestType type, const QUrl &url, bool appendResults)
 {
-    abortActiveRequest();
+    RequestSlot &slot = m_requests[type];
+    const QString key = ResponseCache::canonicalKey(url);
+    if (slot.key == key) {
+        // Already waiting for it (e.g. the episodes page asking for what
+        // the detail page prefetched); it is answered once.
+        return;
+    }
+    detachRequest(type);
     setErrorMessage(QString());
-    setBusy(true);
-    m_requestType = type;
+    slot.appendResults = type == SearchRequest && appendResults;
+
+    QVariant recent;
+    if (recentResult(key, &recent)) {
+        ++m_coalesced;
+        emit cacheStatsChanged();
+        applyResult(type, recent, m_requestedEpisodesFeedId);
+        updateBusy();
+        return;
+    }
+    if (m_transfers.contains(key)) {
+        // A page left moments ago started this download; wait for it
+        // instead of starting another.
+        ++m_coalesced;
+        emit cacheStatsChanged();
+        slot.key = key;
+        showLoading(type);
+        updateBusy();
+        return;
+    }
+
+    // The cache file is read on the parse pool; finishCacheLookup() goes
+    // on from there. Busy is left alone so a fresh hit does not flash the
+    // busy indicator. Requests for key arriving meanwhile join the transfer.
+    Transfer transfer;
+    transfer.type = type;
+    transfer.url = url;
+    transfer.cacheTicket = m_nextParseTicket++;
+    transfer.firstEntry = slot.appendResults ? m_searchResults->count() : 0;
+    transfer.feedId = type == EpisodesRequest ? m_requestedEpisodesFeedId : 0;
+    m_transfers.insert(key, transfer);
+    slot.key = key;
+    startCacheJob(new ResponseCacheJob(&m_cache, ResponseCacheJob::Load, transfer.cacheTicket, key));
+}
+
+void PodcastIndexClient::finishCacheLookup(const QString &key, bool found, const ResponseCache::Entry &cached)
+{
+    const RequestType type = m_transfers.value(key).type;
+    const int ticket = m_transfers.value(key).cacheTicket;
+    int maxAgeSecs = kEpisodesMaxAgeSecs;
+    if (type == SearchRequest) {
+        maxAgeSecs = kSearchMaxAgeSecs;
+    } else if (type == PodcastRequest) {
+        maxAgeSecs = kPodcastMaxAgeSecs;
+    }
+    if (found && cached.isFresh(maxAgeSecs, currentTime())) {
+        const int feedId = m_transfers.value(key).feedId;
+        dropTransfer(key);
+        const QList<RequestType> waiters = takeWaiters(key);
+        m_cache.recordHit();
+        emit cacheStatsChanged();
+        remember(key, cached.data);
+        for (int i = 0; i < waiters.size(); ++i) {
+            applyResult(waiters.at(i), cached.data, feedId);
+        }
+        updateBusy();
+        return;
+    }
+
     logSslInfo();
     if (!QSslSocket::supportsSsl()) {
-        setErrorMessage(QString::fromLatin1("SSL not supported at runtime."));
-        setBusy(false);
+        dropTransfer(key);
+        if (!takeWaiters(key).isEmpty()) {
+            setErrorMessage(QString::fromLatin1("SSL not supported at runtime."));
+        }
+        updateBusy();
+        return;
+    }
+    for (int i = 0; i < RequestTypeCount; ++i) {
+        if (m_requests[i].key == key) {
+            showLoading(static_cast<RequestType>(i));
+        }
+    }
+    // A view emptied above may have started another request.
+    if (!m_transfers.contains(key) || m_transfers.value(key).cacheTicket != ticket) {
+        return;
+    }
+    updateBusy();
+
+    Transfer &transfer = m_transfers[key];
+    transfer.cacheTicket = 0;
+    QNetworkRequest request = buildRequest(transfer.url);
+    if (found && (!cached.etag.isEmpty() || !cached.lastModified.isEmpty())) {
+        if (!cached.etag.isEmpty()) {
+            request.setRawHeader("If-None-Match", cached.etag);
+        }
+        if (!cached.lastModified.isEmpty()) {
+            request.setRawHeader("If-Modified-Since", cached.lastModified);
+        }
+        transfer.cachedResult = cached.data;
+    }
+    transfer.reply = m_nam->get(request);
+    connect(transfer.reply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
+    connect(transfer.reply, SIGNAL(sslErrors(const QList<QSslError> &)),
+            this, SLOT(onSslErrors(const QList<QSslError> &)));
+    transfer.timeout = new QTimer(this);
+    transfer.timeout->setSingleShot(true);
+    connect(transfer.timeout, SIGNAL(timeout()), this, SLOT(onRequestTimeout()));
+    if (type == SearchRequest) {
+        transfer.timeout->start(kSearchTimeoutMs);
+    } else if (type == PodcastRequest) {
+        transfer.timeout->start(kPodcastTimeoutMs);
+    } else {
+        transfer.timeout->start(kEpisodesTimeoutMs);
+    }
+}
+
+void PodcastIndexClient::detachRequest(RequestType type)
+{
+    RequestSlot &slot = m_requests[type];
+    const QString key = slot.key;
+    slot.key.clear();
+    // An old search is not coming back; detail and episode transfers run
+    // on into the cache for when the user does.
+    if (type == SearchRequest && !key.isEmpty()) {
+        dropTransfer(key);
+    }
+}
+
+void PodcastIndexClient::dropTransfer(const QString &key)
+{
+    QHash<QString, Transfer>::iterator it = m_transfers.find(key);
+    if (it == m_transfers.end()) {
         return;
     }
+    // A parse still running for it is ignored when it lands.
+    const Transfer transfer = it.value();
+    m_transfers.erase(it);
+    if (transfer.timeout) {
+        transfer.timeout->stop();
+        transfer.timeout->deleteLater();
+    }
+    if (transfer.reply) {
+        disconnect(transfer.reply, 0, this, 0);
+        transfer.reply->abort();
+        transfer.reply->deleteLater();
+    }
+}
+
+QList<PodcastIndexClient::RequestType> PodcastIndexClient::takeWaiters(const QString &key)
+{
+    QList<RequestType> waiters;
+    for (int i = 0; i < RequestTypeCount; ++i) {
+        if (m_requests[i].key == key) {
+            m_requests[i].key.clear();
+            waiters.append(static_cast<RequestType>(i));
+        }
+    }
+    return waiters;
+}
+
+QString PodcastIndexClient::transferKeyOf(const QObject *replyOrTimer) const
+{
+    for (QHash<QString, Transfer>::const_iterator it = m_transfers.constBegin();
+         it != m_transfers.constEnd(); ++it) {
+        if (replyOrTimer && (it.value().reply == replyOrTimer || it.value().timeout == replyOrTimer)) {
+            return it.key();
+        }
+    }
+    return QString();
+}
+
+QString PodcastIndexClient::transferKeyOf(int ticket) const
+{
+    if (ticket <= 0) {
+        return QString();
+    }
+    for (QHash<QString, Transfer>::const_iterator it = m_transfers.constBegin();
+         it != m_transfers.constEnd(); ++it) {
+        if (it.value().parseTicket == ticket || it.value().cacheTicket == ticket) {
+            return it.key();
+        }
+    }
+    return QString();
+}
+
+void PodcastIndexClient::remember(const QString &key, const QVariant &result)
+{
+    const uint now = currentTime();
+    QHash<QString, Memo>::iterator it = m_memo.begin();
+    while (it != m_memo.end()) {
+        if (now < it.value().storedAt || now - it.value().storedAt >= kMemoWindowSecs) {
+            it = m_memo.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    Memo memo;
+    memo.result = result;
+    memo.storedAt = now;
+    m_memo.insert(key, memo);
+}
+
+bool PodcastIndexClient::recentResult(const QString &key, QVariant *result)
+{
+    QHash<QString, Memo>::iterator it = m_memo.find(key);
+    if (it == m_memo.end()) {
+        return false;
+    }
+    const uint now = currentTime();
+    if (now < it.value().storedAt || now - it.value().storedAt >= kMemoWindowSecs) {
+        m_memo.erase(it);
+        return false;
+    }
+    *result = it.value().result;
+    return true;
+}
+
+void PodcastIndexClient::showLoading(RequestType type)
+{
     if (type == SearchRequest) {
-        if (!appendResults) {
-            setPodcasts(QVariantList());
+        if (!m_requests[SearchRequest].appendResults) {
+            setSearchResults(QVariantList(), false);
         }
     } else if (type == PodcastRequest) {
         setPodcastDetail(QVariantMap());
-    } else if (type == EpisodesRequest) {
+    } else if (type == EpisodesRequest && m_episodesFeedId != m_requestedEpisodesFeedId) {
+        m_episodesFeedId = 0;
         setEpisodes(QVariantList());
     }
-
-    QNetworkRequest request = buildRequest(url);
-    m_reply = m_nam->get(request);
-    connect(m_reply, SIGNAL(finished()), this, SLOT(onReplyFinished()));
-    connect(m_reply, SIGNAL(sslErrors(const QList<QSslError> &)),
-            this, SLOT(onSslErrors(const QList<QSslError> &)));
-    m_timeout.start(15000);
 }
 
-void PodcastIndexClient::abortActiveRequest()
+void PodcastIndexClient::updateBusy()
 {
-    if (!m_reply) {
-        return;
+    // Transfers nobody waits for run in the background.
+    bool busy = false;
+    for (int i = 0; i < RequestTypeCount && !busy; ++i) {
+        busy = !m_requests[i].key.isEmpty();
     }
-    disconnect(m_reply, 0, this, 0);
-    m_reply->abort();
-    m_reply->deleteLater();
-    m_reply = 0;
-    m_timeout.stop();
-    m_requestType = NoneRequest;
+    setBusy(busy);
 }
 
 void PodcastIndexClient::setBusy(bool busy)
@@ -305,9 +685,13 @@ void PodcastIndexClient::setErrorMessage(const QString &message)
     emit errorMessageChanged();
 }
 
-void PodcastIndexClient::setPodcasts(const QVariantList &podcasts)
+void PodcastIndexClient::setSearchResults(const QVariantList &results, bool append)
 {
-    m_podcasts = podcasts;
+    if (append) {
+        m_searchResults->appendResults(results);
+    } else {
+        m_searchResults->setResults(results);
+    }
     emit podcastsChanged();
 }
 
@@ -350,103 +734,6 @@ QByteArray PodcastIndexClient::buildAuthorizationHeader(const QByteArray &apiKey
     return digest.toHex();
 }
 
-QVariantList PodcastIndexClient::parseFeedList(const QVariant &root) const
-{
-    const QVariantMap map = root.toMap();
-    const QVariantList feeds = map.value(QString::fromLatin1("feeds")).toList();
-
-    QVariantList results;
-    results.reserve(feeds.size());
-
-    for (int i = 0; i < feeds.size(); ++i) {
-        const QVariantMap feed = feeds.at(i).toMap();
-        const int feedId = pickValue(feed, "id", "feedId").toInt();
-        const QString guid = pickString(feed, "podcastGuid", "guid");
-        const QString title = pickString(feed, "title");
-        const QString image = pickString(feed, "image");
-        const QVariant imageUrlHashRaw = pickValue(feed, "imageUrlHash");
-        const QString imageUrlHash = imageUrlHashRaw.isValid() && !imageUrlHashRaw.isNull()
-            ? QString::number(imageUrlHashRaw.toLongLong()) : QString();
-        const QString description = trimText(pickString(feed, "description"), 240);
-
-        QVariantMap entry;
-        entry.insert(QString::fromLatin1("feedId"), feedId);
-        entry.insert(QString::fromLatin1("guid"), guid);
-        entry.insert(QString::fromLatin1("title"), title);
-        entry.insert(QString::fromLatin1("image"), image);
-        entry.insert(QString::fromLatin1("imageUrlHash"), imageUrlHash);
-        entry.insert(QString::fromLatin1("description"), description);
-        results.append(entry);
-    }
-
-    return results;
-}
-
-QVariantList PodcastIndexClient::parseEpisodeList(const QVariant &root) const
-{
-    const QVariantMap map = root.toMap();
-    const QVariantList items = map.value(QString::fromLatin1("items")).toList();
-
-    QVariantList results;
-    results.reserve(items.size());
-
-    for (int i = 0; i < items.size(); ++i) {
-        const QVariantMap item = items.at(i).toMap();
-        const QVariant idValue = pickValue(item, "id", "guid");
-        const QString title = pickString(item, "title");
-        const QVariant dateValue = pickValue(item, "datePublished");
-        const QVariant durationValue = pickValue(item, "duration");
-        const QString enclosureUrl = pickString(item, "enclosureUrl");
-        const QString enclosureType = pickString(item, "enclosureType");
-        const QString description = trimText(pickString(item, "description"), 500);
-
-        QVariantMap entry;
-        entry.insert(QString::fromLatin1("id"), idValue);
-        entry.insert(QString::fromLatin1("title"), title);
-        entry.insert(QString::fromLatin1("datePublished"), dateValue);
-        entry.insert(QString::fromLatin1("duration"), durationValue);
-        entry.insert(QString::fromLatin1("enclosureUrl"), enclosureUrl);
-        entry.insert(QString::fromLatin1("enclosureType"), enclosureType);
-        entry.insert(QString::fromLatin1("description"), description);
-        results.append(entry);
-    }
-
-    return results;
-}
-
-QVariantMap PodcastIndexClient::parsePodcastDetail(const QVariant &root) const
-{
-    const QVariantMap map = root.toMap();
-    const QVariantMap feed = map.value(QString::fromLatin1("feed")).toMap();
-
-    if (feed.isEmpty()) {
-        return QVariantMap();
-    }
-
-    const int feedId = pickValue(feed, "id", "feedId").toInt();
-    const QString guid = pickString(feed, "podcastGuid", "guid");
-    const QString title = pickString(feed, "title");
-    const QString description = trimText(pickString(feed, "description"), 1200);
-    const QString image = pickString(feed, "image");
-    const QVariant imageUrlHashRaw = pickValue(feed, "imageUrlHash");
-    const QString imageUrlHash = imageUrlHashRaw.isValid() && !imageUrlHashRaw.isNull()
-        ? QString::number(imageUrlHashRaw.toLongLong()) : QString();
-    const QString author = pickString(feed, "author", "ownerName");
-    const QString url = pickString(feed, "url", "link");
-
-    QVariantMap entry;
-    entry.insert(QString::fromLatin1("feedId"), feedId);
-    entry.insert(QString::fromLatin1("guid"), guid);
-    entry.insert(QString::fromLatin1("title"), title);
-    entry.insert(QString::fromLatin1("description"), description);
-    entry.insert(QString::fromLatin1("image"), image);
-    entry.insert(QString::fromLatin1("imageUrlHash"), imageUrlHash);
-    entry.insert(QString::fromLatin1("author"), author);
-    entry.insert(QString::fromLatin1("url"), url);
-
-    return entry;
-}
-
 QByteArray PodcastIndexClient::apiKey() const
 {
     return PodcastIndexConfig::apiKey();
@@ -459,80 +746,187 @@ QByteArray PodcastIndexClient::apiSecret() const
 
 void PodcastIndexClient::onReplyFinished()
 {
-    m_timeout.stop();
-
-    if (!m_reply) {
-        setBusy(false);
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    const QString key = transferKeyOf(reply);
+    if (key.isEmpty()) {
         return;
     }
+    Transfer &transfer = m_transfers[key];
+    transfer.reply = 0;
+    transfer.timeout->stop();
+    // Deleted once control returns to the event loop; used below until then.
+    reply->deleteLater();
 
-    QNetworkReply *reply = m_reply;
-    m_reply = 0;
-    const QByteArray payload = reply->readAll();
     const QNetworkReply::NetworkError netError = reply->error();
-    const QString netErrorString = reply->errorString();
     const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    const QString detail = extractErrorDetail(payload);
-    reply->deleteLater();
 
-    if (netError != QNetworkReply::NoError) {
-        QString message = QString::fromLatin1("Network error: %1").arg(netErrorString);
-        if (statusCode > 0) {
-            message += QString::fromLatin1(" (HTTP %1)").arg(statusCode);
-        }
-        if (!detail.isEmpty()) {
-            message += QString::fromLatin1(" - %1").arg(detail);
-        }
-        setErrorMessage(message);
-        setBusy(false);
-        m_requestType = NoneRequest;
+    if (netError == QNetworkReply::NoError && statusCode >= 200 && statusCode < 300) {
+        m_cache.recordMiss();
+        emit cacheStatsChanged();
+        transfer.pendingEntry.etag = reply->rawHeader("ETag");
+        transfer.pendingEntry.lastModified = reply->rawHeader("Last-Modified");
+        transfer.pendingEntry.fetchedAt = currentTime();
+        startParse(key, reply->readAll());
         return;
     }
 
-    if (statusCode < 200 || statusCode >= 300) {
-        QString message = QString::fromLatin1("HTTP error %1").arg(statusCode);
+    const QVariant cachedResult = transfer.cachedResult;
+    const RequestType type = transfer.type;
+    const int feedId = transfer.feedId;
+    dropTransfer(key);
+    const QList<RequestType> waiters = takeWaiters(key);
+    if (netError == QNetworkReply::NoError && statusCode == 304 && cachedResult.isValid()) {
+        // Not modified: no body to download or parse.
+        ResponseCache::Entry confirmed;
+        confirmed.etag = reply->rawHeader("ETag");
+        confirmed.lastModified = reply->rawHeader("Last-Modified");
+        confirmed.fetchedAt = currentTime();
+        startCacheJob(new ResponseCacheJob(&m_cache, ResponseCacheJob::Touch, 0, key, confirmed));
+        m_cache.recordRevalidated();
+        emit cacheStatsChanged();
+        remember(key, cachedResult);
+        for (int i = 0; i < waiters.size(); ++i) {
+            applyResult(waiters.at(i), cachedResult, feedId);
+        }
+        if (type == EpisodesRequest) {
+            emit episodesFetched(feedId, cachedResult.toList());
+        }
+    } else if (!waiters.isEmpty()) {
+        // Only a view still waiting hears of the failure; the next request
+        // for a detached transfer simply tries again.
+        const QString detail = PodcastIndexProjection::errorDetail(reply->readAll());
+        QString message;
+        if (netError != QNetworkReply::NoError) {
+            message = QString::fromLatin1("Network error: %1").arg(reply->errorString());
+            if (statusCode > 0) {
+                message += QString::fromLatin1(" (HTTP %1)").arg(statusCode);
+            }
+        } else {
+            message = QString::fromLatin1("HTTP error %1").arg(statusCode);
+        }
         if (!detail.isEmpty()) {
             message += QString::fromLatin1(" - %1").arg(detail);
         }
         setErrorMessage(message);
-        setBusy(false);
-        m_requestType = NoneRequest;
+    }
+    // After the result is set, so views never see "idle and empty".
+    updateBusy();
+}
+
+void PodcastIndexClient::startParse(const QString &key, const QByteArray &payload)
+{
+    Transfer &transfer = m_transfers[key];
+    ReplyParser::Projection projection = PodcastIndexProjection::episodeList;
+    if (transfer.type == SearchRequest) {
+        projection = PodcastIndexProjection::feedList;
+    } else if (transfer.type == PodcastRequest) {
+        projection = PodcastIndexProjection::podcastDetail;
+    }
+    transfer.parseTicket = m_nextParseTicket++;
+    ReplyParser *parser = transfer.firstEntry > 0
+        ? new ReplyParser(transfer.parseTicket, PodcastIndexProjection::feedListFrom, transfer.firstEntry, payload)
+        : new ReplyParser(transfer.parseTicket, projection, payload);
+    connect(parser, SIGNAL(projected(int,QVariant,bool,QString)),
+            this, SLOT(onReplyProjected(int,QVariant,bool,QString)));
+    m_parsePool.start(parser);
+}
+
+void PodcastIndexClient::onReplyProjected(int ticket, const QVariant &result, bool ok,
+                                          const QString &errorMessage)
+{
+    const QString key = transferKeyOf(ticket);
+    if (key.isEmpty()) {
+        // Superseded search, or cleared.
         return;
     }
+    const Transfer transfer = m_transfers.value(key);
+    dropTransfer(key);
+    const QList<RequestType> waiters = takeWaiters(key);
 
-    QJson::Parser parser;
-    bool ok = false;
-    const QVariant result = parser.parse(payload, &ok);
     if (!ok) {
-        setErrorMessage(QString::fromLatin1("JSON parse error: %1").arg(parser.errorString()));
-        setBusy(false);
-        m_requestType = NoneRequest;
+        if (!waiters.isEmpty()) {
+            setErrorMessage(errorMessage);
+        }
+        updateBusy();
         return;
     }
 
-    if (m_requestType == SearchRequest) {
-        setPodcasts(parseFeedList(result));
-    } else if (m_requestType == PodcastRequest) {
-        setPodcastDetail(parsePodcastDetail(result));
-    } else if (m_requestType == EpisodesRequest) {
-        setEpisodes(parseEpisodeList(result));
+    for (int i = 0; i < waiters.size(); ++i) {
+        applyResult(waiters.at(i), result, transfer.feedId);
     }
+    // Also when nobody waits any more, so the stored list a later (or
+    // offline) visit shows first is the latest one.
+    if (transfer.type == EpisodesRequest) {
+        emit episodesFetched(transfer.feedId, result.toList());
+    }
+    ResponseCache::Entry entry = transfer.pendingEntry;
+    // A "Load More" projected only the new page, but the entry stands for
+    // the whole response: the rows shown before it plus the new ones. (A
+    // search transfer is dropped once nobody waits for it.)
+    entry.data = transfer.firstEntry > 0 ? QVariant(m_searchResults->toVariantList()) : result;
+    startCacheJob(new ResponseCacheJob(&m_cache, ResponseCacheJob::Store, 0, key, entry));
+    remember(key, entry.data);
+    updateBusy();
+}
 
-    setBusy(false);
-    m_requestType = NoneRequest;
+void PodcastIndexClient::startCacheJob(ResponseCacheJob *job)
+{
+    connect(job, SIGNAL(finished(int,bool,ResponseCache::Entry,int)),
+            this, SLOT(onCacheJobFinished(int,bool,ResponseCache::Entry,int)));
+    m_parsePool.start(job);
 }
 
-void PodcastIndexClient::onTimeout()
+void PodcastIndexClient::onCacheJobFinished(int ticket, bool ok, const ResponseCache::Entry &entry,
+                                            int entryCount)
 {
-    abortActiveRequest();
-    setErrorMessage(QString::fromLatin1("Request timed out."));
-    setBusy(false);
-    m_requestType = NoneRequest;
+    if (m_cacheEntries != entryCount) {
+        m_cacheEntries = entryCount;
+        emit cacheStatsChanged();
+    }
+    const QString key = transferKeyOf(ticket);
+    if (key.isEmpty()) {
+        // A write, or a lookup for a superseded search or cleared transfer.
+        return;
+    }
+    finishCacheLookup(key, ok, entry);
+}
+
+void PodcastIndexClient::applyResult(RequestType type, const QVariant &result, int feedId)
+{
+    if (type == SearchRequest) {
+        // Cached and revalidated "Load More" results hold every page; the
+        // model only inserts the feeds it does not list yet.
+        setSearchResults(result.toList(), m_requests[SearchRequest].appendResults);
+    } else if (type == PodcastRequest) {
+        setPodcastDetail(result.toMap());
+    } else if (type == EpisodesRequest) {
+        const QVariantList episodes = result.toList();
+        // Only touch the view if the network list differs from what is shown
+        // (typically the cached copy).
+        if (m_episodesFeedId != feedId || !sameEpisodeList(m_episodes, episodes)) {
+            m_episodesFeedId = feedId;
+            setEpisodes(episodes);
+        }
+    }
+}
+
+void PodcastIndexClient::onRequestTimeout()
+{
+    const QString key = transferKeyOf(sender());
+    if (key.isEmpty()) {
+        return;
+    }
+    dropTransfer(key);
+    if (!takeWaiters(key).isEmpty()) {
+        setErrorMessage(QString::fromLatin1("Request timed out."));
+    }
+    updateBusy();
 }
 
 void PodcastIndexClient::onSslErrors(const QList<QSslError> &errors)
 {
-    if (!m_reply) {
+    QNetworkReply *reply = qobject_cast<QNetworkReply *>(sender());
+    if (!reply) {
         return;
     }
 
@@ -546,7 +940,7 @@ void PodcastIndexClient::onSslErrors(const QList<QSslError> &errors)
     ts.flush();
 
     // MVP: ignore SSL errors to keep feasibility testing unblocked.
-    m_reply->ignoreSslErrors();
+    reply->ignoreSslErrors();
 }
 
 void PodcastIndexClient::logSslInfo()
@@ -1,31 +1,47 @@
 #ifndef PODCASTINDEXCLIENT_H
 #define PODCASTINDEXCLIENT_H
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
+#include <QtCore/QThreadPool>
 #include <QtCore/QTimer>
+#include <QtCore/QUrl>
 #include <QtCore/QVariantMap>
 #include <QtCore/QVariantList>
 #include <QtNetwork/QNetworkAccessManager>
 #include <QtNetwork/QNetworkReply>
 #include <QtNetwork/QSslError>
 
+#include "ResponseCache.h"
+
+class ResponseCacheJob;
+class SearchResultsModel;
+
 class PodcastIndexClient : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(bool busy READ busy NOTIFY busyChanged)
     Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorMessageChanged)
+    Q_PROPERTY(QObject *searchResults READ searchResults CONSTANT)
     Q_PROPERTY(QVariantList podcasts READ podcasts NOTIFY podcastsChanged)
     Q_PROPERTY(QVariantList episodes READ episodes NOTIFY episodesChanged)
     Q_PROPERTY(QVariantMap podcastDetail READ podcastDetail NOTIFY podcastDetailChanged)
+    Q_PROPERTY(QVariantMap cacheStats READ cacheStats NOTIFY cacheStatsChanged)
 
 public:
     explicit PodcastIndexClient(QObject *parent = 0);
 
     bool busy() const;
     QString errorMessage() const;
+    QObject *searchResults() const;
+    // Built on demand from the model; prefer searchResults in views.
     QVariantList podcasts() const;
     QVariantList episodes() const;
     QVariantMap podcastDetail() const;
+    // Response cache counters: { hits, revalidated, misses, entries,
+    // coalesced }; coalesced counts requests answered by another request's
+    // download (joined while running, or from the short-lived memo).
+    QVariantMap cacheStats() const;
 
     Q_INVOKABLE void search(const QString &term);
     Q_INVOKABLE void searchMore(const QString &term, int maxResults);
@@ -36,33 +52,124 @@ public:
     Q_INVOKABLE void clearEpisodes();
     Q_INVOKABLE void clearPodcastDetail();
     Q_INVOKABLE void clearAll();
+    Q_INVOKABLE void clearResponseCache();
+
+public slots:
+    // Shows a stored list for feedId while its network request is still
+    // running; ignored once fresher data for that feed is on screen.
+    void applyCachedEpisodes(int feedId, const QVariantList &episodes);
+    // Looks up { feedUrl, title } maps (OPML entries) on Podcast Index a
+    // batch at a time, independently of the search/detail/episodes request.
+    void resolveFeeds(const QVariantList &feeds);
 
 signals:
     void busyChanged();
     void errorMessageChanged();
+    // After every search response is applied, and when results are cleared.
     void podcastsChanged();
     void episodesChanged();
     void podcastDetailChanged();
+    void cacheStatsChanged();
+    // Episode list cache hooks (wired to StorageManager in main.cpp).
+    void cachedEpisodesRequested(int feedId);
+    // Every episodes/byfeedid response (or 304), also for a feed whose page
+    // was left before it arrived; not for lists served from memory or disk.
+    void episodesFetched(int feedId, const QVariantList &episodes);
+    // Once per resolveFeeds() run: every feed found, in subscription shape.
+    void feedsResolved(const QVariantList &feeds, int failed);
 
 private slots:
     void onReplyFinished();
-    void onTimeout();
+    void onRequestTimeout();
     void onSslErrors(const QList<QSslError> &errors);
+    void onResolveReplyFinished();
+    void onResolveTimeout();
+    void onReplyProjected(int ticket, const QVariant &result, bool ok, const QString &errorMessage);
+    void onCacheJobFinished(int ticket, bool ok, const ResponseCache::Entry &entry, int entryCount);
 
 private:
     enum RequestType {
-        NoneRequest,
         SearchRequest,
         PodcastRequest,
-        EpisodesRequest
+        EpisodesRequest,
+        RequestTypeCount
+    };
+
+    // What each result property is waiting for, one request per type. A new
+    // request replaces the one of its type but never touches the other
+    // types, so a detail page loads its podcast and its episodes side by side.
+    struct RequestSlot {
+        RequestSlot();
+        // Canonical URL of the transfer it waits for; empty when idle.
+        QString key;
+        // Search only: a "Load More" request appends to the shown results.
+        bool appendResults;
+    };
+
+    // One network reply per canonical URL, however many requests ask for
+    // it. A transfer nobody waits for any more (the user navigated on) still
+    // finishes into the cache and memo, so coming back does not download it
+    // again; only a superseded search is aborted.
+    struct Transfer {
+        Transfer();
+        RequestType type;
+        QUrl url;
+        // Nonzero while the cache entry is read off the GUI thread; the
+        // network request only starts once it is known to be missing or stale.
+        int cacheTicket;
+        QNetworkReply *reply;
+        QTimer *timeout;
+        // Result of the stale cache entry a conditional request is
+        // revalidating; invalid for unconditional requests.
+        QVariant cachedResult;
+        // Nonzero while the downloaded body is being parsed off the GUI
+        // thread; the entry's validators are stored with the result.
+        int parseTicket;
+        ResponseCache::Entry pendingEntry;
+        // "Load More": the response repeats the firstEntry rows already
+        // shown before the new page, so projection starts after them.
+        int firstEntry;
+        // Episodes only: the feed the list belongs to.
+        int feedId;
+    };
+
+    // A result just delivered, served again to repeat requests within
+    // kMemoWindowSecs without touching the disk cache.
+    struct Memo {
+        QVariant result;
+        uint storedAt;
     };
 
     void startRequest(RequestType type, const QUrl &url, bool appendResults);
     void startSearchRequest(const QString &term, int maxResults, bool appendResults);
-    void abortActiveRequest();
+    // Stops type waiting for its transfer; a search transfer is aborted.
+    void detachRequest(RequestType type);
+    // Removes the transfer for key, aborting its reply if still running.
+    void dropTransfer(const QString &key);
+    // Clears and returns the requests waiting for key.
+    QList<RequestType> takeWaiters(const QString &key);
+    // Key of the transfer owning reply, timer or parse/cache ticket, or empty.
+    QString transferKeyOf(const QObject *replyOrTimer) const;
+    QString transferKeyOf(int ticket) const;
+    // Answers the waiters of key from a fresh cache entry, or sends the
+    // network request, conditional if the stale entry has validators.
+    void finishCacheLookup(const QString &key, bool found, const ResponseCache::Entry &cached);
+    // Queues a cache file operation on the parse pool.
+    void startCacheJob(ResponseCacheJob *job);
+    // Queues payload on the parse pool; onReplyProjected() receives a list
+    // for search and episodes, a map for podcast detail.
+    void startParse(const QString &key, const QByteArray &payload);
+    void remember(const QString &key, const QVariant &result);
+    bool recentResult(const QString &key, QVariant *result);
+    // Empties the property a network request is about to refill.
+    void showLoading(RequestType type);
+    // feedId: the feed an episode list belongs to; unused for other types.
+    void applyResult(RequestType type, const QVariant &result, int feedId);
+    void startResolveBatch();
+    void updateBusy();
     void setBusy(bool busy);
     void setErrorMessage(const QString &message);
-    void setPodcasts(const QVariantList &podcasts);
+    void setSearchResults(const QVariantList &results, bool append);
     void setEpisodes(const QVariantList &episodes);
     void setPodcastDetail(const QVariantMap &podcastDetail);
 
@@ -71,24 +178,40 @@ private:
                                         const QByteArray &apiSecret,
                                         const QByteArray &timestamp) const;
 
-    QVariantList parseFeedList(const QVariant &root) const;
-    QVariantMap parsePodcastDetail(const QVariant &root) const;
-    QVariantList parseEpisodeList(const QVariant &root) const;
     void logSslInfo();
 
     QByteArray apiKey() const;
     QByteArray apiSecret() const;
 
     QNetworkAccessManager *m_nam;
-    QNetworkReply *m_reply;
-    QTimer m_timeout;
+    RequestSlot m_requests[RequestTypeCount];
+    QHash<QString, Transfer> m_transfers;
+    QHash<QString, Memo> m_memo;
+    int m_coalesced;
     bool m_busy;
     QString m_errorMessage;
-    QVariantList m_podcasts;
+    SearchResultsModel *m_searchResults;
     QVariantList m_episodes;
+    int m_episodesFeedId;
+    int m_requestedEpisodesFeedId;
     QVariantMap m_podcastDetail;
-    RequestType m_requestType;
     bool m_loggedSslInfo;
+    // Only touched on the parse pool thread, apart from its counters.
+    ResponseCache m_cache;
+    // Cache files, as reported by the last cache job; -1 until the first.
+    int m_cacheEntries;
+    // One thread: replies are parsed one at a time, which bounds the
+    // transient parse trees on the heap to a single response. Cache file
+    // reads and writes run here too, in the order they were started.
+    QThreadPool m_parsePool;
+    // Shared by parse and cache jobs.
+    int m_nextParseTicket;
+
+    QVariantList m_resolveQueue;
+    QHash<QNetworkReply *, QVariantMap> m_resolveReplies;
+    QVariantList m_resolvedFeeds;
+    int m_resolveFailed;
+    QTimer m_resolveTimeout;
 };
 
 #endif // PODCASTINDEXCLIENT_H
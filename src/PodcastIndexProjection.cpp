@@ -0,0 +1,272 @@
+#include "PodcastIndexProjection.h"
+
+#include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
+
+#include "streamreader.h"
+
+using QJson::StreamReader;
+
+namespace {
+// Members read from each entry; anything else is skipped unread.
+const char *const kFeedFields[] = {
+    "id", "feedId", "podcastGuid", "guid", "title", "image", "imageUrlHash", "description", 0
+};
+const char *const kDetailFields[] = {
+    "id", "feedId", "podcastGuid", "guid", "title", "description", "image", "imageUrlHash",
+    "author", "ownerName", "url", "link", 0
+};
+const char *const kEpisodeFields[] = {
+    "id", "guid", "title", "datePublished", "duration", "enclosureUrl", "enclosureType",
+    "description", 0
+};
+const char *const kErrorFields[] = {
+    "description", "message", "error", "status", 0
+};
+
+QString trimText(const QString &text, int maxChars)
+{
+    if (maxChars <= 0 || text.isEmpty()) {
+        return QString();
+    }
+    if (text.size() <= maxChars) {
+        return text;
+    }
+    QString trimmed = text.left(maxChars);
+    trimmed.append(QString::fromLatin1("..."));
+    return trimmed;
+}
+
+QString pickString(const QVariantMap &map, const char *primary, const char *fallback = 0)
+{
+    QString value = map.value(QLatin1String(primary)).toString();
+    if (value.isEmpty() && fallback) {
+        value = map.value(QLatin1String(fallback)).toString();
+    }
+    return value;
+}
+
+QVariant pickValue(const QVariantMap &map, const char *primary, const char *fallback = 0)
+{
+    QVariant value = map.value(QLatin1String(primary));
+    if ((!value.isValid() || value.isNull()) && fallback) {
+        value = map.value(QLatin1String(fallback));
+    }
+    return value;
+}
+
+QString imageUrlHashText(const QVariantMap &map)
+{
+    const QVariant raw = pickValue(map, "imageUrlHash");
+    return raw.isValid() && !raw.isNull() ? QString::number(raw.toLongLong()) : QString();
+}
+
+QVariantMap feedEntry(const QVariantMap &feed)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("feedId"), pickValue(feed, "id", "feedId").toInt());
+    entry.insert(QString::fromLatin1("guid"), pickString(feed, "podcastGuid", "guid"));
+    entry.insert(QString::fromLatin1("title"), pickString(feed, "title"));
+    entry.insert(QString::fromLatin1("image"), pickString(feed, "image"));
+    entry.insert(QString::fromLatin1("imageUrlHash"), imageUrlHashText(feed));
+    entry.insert(QString::fromLatin1("description"), trimText(pickString(feed, "description"), 240));
+    return entry;
+}
+
+QVariantMap detailEntry(const QVariantMap &feed)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("feedId"), pickValue(feed, "id", "feedId").toInt());
+    entry.insert(QString::fromLatin1("guid"), pickString(feed, "podcastGuid", "guid"));
+    entry.insert(QString::fromLatin1("title"), pickString(feed, "title"));
+    entry.insert(QString::fromLatin1("description"), trimText(pickString(feed, "description"), 1200));
+    entry.insert(QString::fromLatin1("image"), pickString(feed, "image"));
+    entry.insert(QString::fromLatin1("imageUrlHash"), imageUrlHashText(feed));
+    entry.insert(QString::fromLatin1("author"), pickString(feed, "author", "ownerName"));
+    entry.insert(QString::fromLatin1("url"), pickString(feed, "url", "link"));
+    return entry;
+}
+
+QVariantMap episodeEntry(const QVariantMap &item)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("id"), pickValue(item, "id", "guid"));
+    entry.insert(QString::fromLatin1("title"), pickString(item, "title"));
+    entry.insert(QString::fromLatin1("datePublished"), pickValue(item, "datePublished"));
+    entry.insert(QString::fromLatin1("duration"), pickValue(item, "duration"));
+    entry.insert(QString::fromLatin1("enclosureUrl"), pickString(item, "enclosureUrl"));
+    entry.insert(QString::fromLatin1("enclosureType"), pickString(item, "enclosureType"));
+    entry.insert(QString::fromLatin1("description"), trimText(pickString(item, "description"), 500));
+    return entry;
+}
+
+const char *wantedName(const StreamReader &reader, const char *const *wanted)
+{
+    for (int i = 0; wanted[i]; ++i) {
+        if (reader.textEquals(wanted[i])) {
+            return wanted[i];
+        }
+    }
+    return 0;
+}
+
+// With the reader on StartObject, collects the wanted scalar members and
+// skips the rest through the matching EndObject. A wanted name holding an
+// object or array is skipped too.
+bool readFields(StreamReader &reader, const char *const *wanted, QVariantMap *fields)
+{
+    for (;;) {
+        const StreamReader::TokenType type = reader.readNext();
+        if (type == StreamReader::EndObject) {
+            return true;
+        }
+        if (type != StreamReader::Name) {
+            return false;
+        }
+        const char *name = wantedName(reader, wanted);
+        if (!name) {
+            if (!reader.skipCurrentValue()) {
+                return false;
+            }
+            continue;
+        }
+        const StreamReader::TokenType valueType = reader.readNext();
+        if (valueType == StreamReader::StartObject || valueType == StreamReader::StartArray) {
+            if (!reader.skipCurrentValue()) {
+                return false;
+            }
+        } else if (valueType == StreamReader::Invalid || valueType == StreamReader::EndDocument) {
+            return false;
+        } else {
+            fields->insert(QLatin1String(name), reader.value());
+        }
+    }
+}
+
+// Moves to the value of the top-level member `name`, skipping the members
+// before it. False if the document is not an object or has no such member.
+bool seekMember(StreamReader &reader, const char *name)
+{
+    if (reader.readNext() != StreamReader::StartObject) {
+        return false;
+    }
+    while (reader.readNext() == StreamReader::Name) {
+        if (reader.textEquals(name)) {
+            reader.readNext();
+            return true;
+        }
+        if (!reader.skipCurrentValue()) {
+            return false;
+        }
+    }
+    return false;
+}
+
+bool finish(const StreamReader &reader, QString *errorMessage)
+{
+    if (reader.hasError()) {
+        *errorMessage = QString::fromLatin1("JSON parse error: %1").arg(reader.errorString());
+        return false;
+    }
+    return true;
+}
+
+// Entries before firstEntry are stepped over undecoded.
+bool readList(const QByteArray &payload, const char *listName, const char *const *wanted,
+              QVariantMap (*makeEntry)(const QVariantMap &), int firstEntry,
+              QVariant *result, QString *errorMessage)
+{
+    StreamReader reader(payload);
+    QVariantList results;
+    if (seekMember(reader, listName) && reader.tokenType() == StreamReader::StartArray) {
+        for (int index = 0;; ++index) {
+            const StreamReader::TokenType type = reader.readNext();
+            if (type == StreamReader::StartObject && index < firstEntry) {
+                if (!reader.skipCurrentValue()) {
+                    break;
+                }
+            } else if (type == StreamReader::StartObject) {
+                QVariantMap fields;
+                if (!readFields(reader, wanted, &fields)) {
+                    break;
+                }
+                results.append(makeEntry(fields));
+            } else if (type == StreamReader::EndArray || !reader.skipCurrentValue()) {
+                break;
+            }
+        }
+    }
+    // The rest of the document is not needed and is never read.
+    if (!finish(reader, errorMessage)) {
+        return false;
+    }
+    *result = results;
+    return true;
+}
+}
+
+namespace PodcastIndexProjection {
+
+bool feedList(const QByteArray &payload, QVariant *result, QString *errorMessage)
+{
+    return readList(payload, "feeds", kFeedFields, feedEntry, 0, result, errorMessage);
+}
+
+bool feedListFrom(const QByteArray &payload, int firstEntry, QVariant *result, QString *errorMessage)
+{
+    return readList(payload, "feeds", kFeedFields, feedEntry, firstEntry, result, errorMessage);
+}
+
+bool episodeList(const QByteArray &payload, QVariant *result, QString *errorMessage)
+{
+    return readList(payload, "items", kEpisodeFields, episodeEntry, 0, result, errorMessage);
+}
+
+bool podcastDetail(const QByteArray &payload, QVariant *result, QString *errorMessage)
+{
+    StreamReader reader(payload);
+    QVariantMap fields;
+    if (seekMember(reader, "feed") && reader.tokenType() == StreamReader::StartObject) {
+        readFields(reader, kDetailFields, &fields);
+    }
+    if (!finish(reader, errorMessage)) {
+        return false;
+    }
+    // byfeedurl answers an unknown feed with "feed": [].
+    *result = fields.isEmpty() ? QVariantMap() : detailEntry(fields);
+    return true;
+}
+
+QString errorDetail(const QByteArray &payload)
+{
+    if (payload.isEmpty()) {
+        return QString();
+    }
+
+    StreamReader reader(payload);
+    QVariantMap fields;
+    if (reader.readNext() == StreamReader::StartObject && readFields(reader, kErrorFields, &fields)) {
+        QString detail = pickString(fields, "description", "message");
+        if (detail.isEmpty()) {
+            detail = pickString(fields, "error");
+        }
+        if (detail.isEmpty()) {
+            detail = pickString(fields, "status");
+        }
+        if (!detail.isEmpty()) {
+            return detail;
+        }
+    }
+
+    QString text = QString::fromUtf8(payload).trimmed();
+    if (text.isEmpty()) {
+        return QString();
+    }
+    const int kMax = 240;
+    if (text.size() > kMax) {
+        text = text.left(kMax) + QString::fromLatin1("...");
+    }
+    return text;
+}
+
+} // namespace PodcastIndexProjection
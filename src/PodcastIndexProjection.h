@@ -0,0 +1,36 @@
+#ifndef PODCASTINDEXPROJECTION_H
+#define PODCASTINDEXPROJECTION_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+
+// Builds the compact lists and maps the views bind to straight from a
+// Podcast Index response. The body is read with QJson::StreamReader: only
+// the members listed for each entry are decoded, and everything else
+// (categories, funding, value blocks, transcripts, ...) is stepped over
+// without being allocated, so no document tree is ever built.
+//
+// Reentrant; PodcastIndexClient runs these on its parse pool thread.
+namespace PodcastIndexProjection {
+
+// search/byterm: [{ feedId, guid, title, image, imageUrlHash, description }]
+bool feedList(const QByteArray &payload, QVariant *result, QString *errorMessage);
+// As feedList(), for the feeds from index firstEntry on; the ones before it
+// are skipped without being decoded (a "Load More" response repeats the
+// pages already shown).
+bool feedListFrom(const QByteArray &payload, int firstEntry, QVariant *result, QString *errorMessage);
+// podcasts/byfeedid, byguid, byfeedurl: { feedId, guid, title, description,
+// image, imageUrlHash, author, url }, or an empty map when there is no feed.
+bool podcastDetail(const QByteArray &payload, QVariant *result, QString *errorMessage);
+// episodes/byfeedid: [{ id, title, datePublished, duration, enclosureUrl,
+// enclosureType, description }]
+bool episodeList(const QByteArray &payload, QVariant *result, QString *errorMessage);
+
+// Human-readable reason from an error body: its description/message/error/
+// status member, else the (shortened) text itself.
+QString errorDetail(const QByteArray &payload);
+
+} // namespace PodcastIndexProjection
+
+#endif // PODCASTINDEXPROJECTION_H
@@ -0,0 +1,290 @@
+#include "RecentEpisodesModel.h"
+
+#include <QtCore/QHash>
+#include <QtCore/QtAlgorithms>
+
+namespace {
+// Cursor that sorts after every real row, used for the first page.
+const int kNewestCursor = 2147483647;
+
+// Tokens are unique across all instances; StorageManager fans every page
+// out to each model and only the requester accepts it.
+int nextToken()
+{
+    static int token = 0;
+    return ++token;
+}
+}
+
+RecentEpisodesModel::RecentEpisodesModel(bool inProgressOnly, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_inProgressOnly(inProgressOnly)
+    , m_started(false)
+    , m_exhausted(false)
+    , m_pendingToken(0)
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(EpisodeIdRole, "episodeId");
+    roles.insert(FeedIdRole, "feedId");
+    roles.insert(TitleRole, "title");
+    roles.insert(AudioUrlRole, "audioUrl");
+    roles.insert(DurationSecondsRole, "durationSeconds");
+    roles.insert(PositionMsRole, "positionMs");
+    roles.insert(LastPlayedAtRole, "lastPlayedAt");
+    roles.insert(EnclosureTypeRole, "enclosureType");
+    roles.insert(PublishedAtRole, "publishedAt");
+    roles.insert(PlayStateRole, "playState");
+    setRoleNames(roles);
+}
+
+int RecentEpisodesModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant RecentEpisodesModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+    case EpisodeIdRole:
+        return entry.episodeId;
+    case FeedIdRole:
+        return entry.feedId;
+    case Qt::DisplayRole:
+    case TitleRole:
+        return entry.title;
+    case AudioUrlRole:
+        return entry.audioUrl;
+    case DurationSecondsRole:
+        return entry.durationSeconds;
+    case PositionMsRole:
+        return entry.positionMs;
+    case LastPlayedAtRole:
+        return entry.lastPlayedAt;
+    case EnclosureTypeRole:
+        return entry.enclosureType;
+    case PublishedAtRole:
+        return entry.publishedAt;
+    case PlayStateRole:
+        return entry.playState;
+    default:
+        return QVariant();
+    }
+}
+
+bool RecentEpisodesModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && canLoadMore();
+}
+
+void RecentEpisodesModel::fetchMore(const QModelIndex &parent)
+{
+    if (!parent.isValid()) {
+        loadMore();
+    }
+}
+
+int RecentEpisodesModel::count() const
+{
+    return m_entries.size();
+}
+
+bool RecentEpisodesModel::canLoadMore() const
+{
+    return !m_exhausted && m_pendingToken == 0;
+}
+
+bool RecentEpisodesModel::loading() const
+{
+    return m_pendingToken != 0;
+}
+
+bool RecentEpisodesModel::inProgressOnly() const
+{
+    return m_inProgressOnly;
+}
+
+void RecentEpisodesModel::loadMore()
+{
+    if (!canLoadMore()) {
+        return;
+    }
+    m_started = true;
+    requestPage();
+}
+
+void RecentEpisodesModel::reload()
+{
+    const bool hadRows = !m_entries.isEmpty();
+
+    // A page still in flight belongs to the old cursor; its token is
+    // forgotten here so appendPage() drops it.
+    beginResetModel();
+    m_entries.clear();
+    m_exhausted = false;
+    m_pendingToken = 0;
+    endResetModel();
+
+    if (hadRows) {
+        emit countChanged();
+    }
+    if (m_started) {
+        requestPage();
+    } else {
+        emit loadingChanged();
+        emit canLoadMoreChanged();
+    }
+}
+
+void RecentEpisodesModel::applyProgress(const QVariantList &entries)
+{
+    if (!m_started) {
+        return;
+    }
+    // An empty model has no rows to patch, and a page in flight was read
+    // before these entries were committed; both start over instead.
+    if (m_entries.isEmpty() || m_pendingToken != 0) {
+        reload();
+        return;
+    }
+
+    // Oldest first, so the newest entry ends up in row 0.
+    QList<Entry> touched;
+    for (int i = 0; i < entries.size(); ++i) {
+        touched.append(entryFromMap(entries.at(i).toMap()));
+    }
+    qSort(touched.begin(), touched.end(), entryBefore);
+
+    const int oldCount = m_entries.size();
+    for (int i = 0; i < touched.size(); ++i) {
+        const Entry &entry = touched.at(i);
+        const int row = rowOf(entry.episodeId);
+        if (!accepts(entry)) {
+            if (row >= 0) {
+                beginRemoveRows(QModelIndex(), row, row);
+                m_entries.removeAt(row);
+                endRemoveRows();
+            }
+            continue;
+        }
+        if (row < 0) {
+            beginInsertRows(QModelIndex(), 0, 0);
+            m_entries.prepend(entry);
+            endInsertRows();
+            continue;
+        }
+        if (row > 0) {
+            beginMoveRows(QModelIndex(), row, row, QModelIndex(), 0);
+            m_entries.move(row, 0);
+            endMoveRows();
+        }
+        m_entries[0] = entry;
+        emit dataChanged(index(0), index(0));
+    }
+
+    if (m_entries.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+QVariantMap RecentEpisodesModel::get(int row) const
+{
+    QVariantMap map;
+    if (row < 0 || row >= m_entries.size()) {
+        return map;
+    }
+    const QHash<int, QByteArray> roles = roleNames();
+    QHash<int, QByteArray>::const_iterator it = roles.constBegin();
+    for (; it != roles.constEnd(); ++it) {
+        map.insert(QString::fromLatin1(it.value()), data(index(row), it.key()));
+    }
+    return map;
+}
+
+void RecentEpisodesModel::appendPage(int token, const QVariantList &page)
+{
+    if (token == 0 || token != m_pendingToken) {
+        return;
+    }
+
+    m_exhausted = page.size() < PageSize;
+    if (!page.isEmpty()) {
+        const int first = m_entries.size();
+        beginInsertRows(QModelIndex(), first, first + page.size() - 1);
+        for (int i = 0; i < page.size(); ++i) {
+            m_entries.append(entryFromMap(page.at(i).toMap()));
+        }
+        endInsertRows();
+        emit countChanged();
+    }
+    m_pendingToken = 0;
+    emit loadingChanged();
+    emit canLoadMoreChanged();
+}
+
+RecentEpisodesModel::Entry RecentEpisodesModel::entryFromMap(const QVariantMap &map)
+{
+    Entry entry;
+    entry.episodeId = map.value(QString::fromLatin1("episodeId")).toString();
+    entry.feedId = map.value(QString::fromLatin1("feedId")).toInt();
+    entry.title = map.value(QString::fromLatin1("title")).toString();
+    entry.audioUrl = map.value(QString::fromLatin1("audioUrl")).toString();
+    entry.durationSeconds = map.value(QString::fromLatin1("durationSeconds")).toInt();
+    entry.positionMs = map.value(QString::fromLatin1("positionMs")).toInt();
+    entry.lastPlayedAt = map.value(QString::fromLatin1("lastPlayedAt")).toInt();
+    entry.enclosureType = map.value(QString::fromLatin1("enclosureType")).toString();
+    entry.publishedAt = map.value(QString::fromLatin1("publishedAt")).toInt();
+    entry.playState = map.value(QString::fromLatin1("playState")).toInt();
+    return entry;
+}
+
+// Ascending (lastPlayedAt, episodeId): the reverse of the page order.
+bool RecentEpisodesModel::entryBefore(const Entry &left, const Entry &right)
+{
+    if (left.lastPlayedAt != right.lastPlayedAt) {
+        return left.lastPlayedAt < right.lastPlayedAt;
+    }
+    return left.episodeId < right.episodeId;
+}
+
+// Mirrors the in-progress filter of StorageWorker::readRecentEpisodes().
+bool RecentEpisodesModel::accepts(const Entry &entry) const
+{
+    if (!m_inProgressOnly) {
+        return true;
+    }
+    if (entry.positionMs <= 0) {
+        return false;
+    }
+    return entry.durationSeconds <= 0
+            || entry.positionMs < (entry.durationSeconds - 30) * 1000;
+}
+
+int RecentEpisodesModel::rowOf(const QString &episodeId) const
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries.at(i).episodeId == episodeId) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void RecentEpisodesModel::requestPage()
+{
+    int beforePlayedAt = kNewestCursor;
+    QString beforeEpisodeId;
+    if (!m_entries.isEmpty()) {
+        beforePlayedAt = m_entries.last().lastPlayedAt;
+        beforeEpisodeId = m_entries.last().episodeId;
+    }
+
+    m_pendingToken = nextToken();
+    emit loadingChanged();
+    emit canLoadMoreChanged();
+    emit pageRequested(m_pendingToken, beforePlayedAt, beforeEpisodeId, PageSize, m_inProgressOnly);
+}
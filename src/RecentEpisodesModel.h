@@ -0,0 +1,99 @@
+#ifndef RECENTEPISODESMODEL_H
+#define RECENTEPISODESMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
+
+// Recently played (or only in-progress) episodes, newest first. Rows are
+// fetched a page at a time with a (lastPlayedAt, episodeId) keyset cursor;
+// the model only asks for pages, StorageManager runs them on the storage
+// thread and hands the result back through appendPage().
+class RecentEpisodesModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(bool canLoadMore READ canLoadMore NOTIFY canLoadMoreChanged)
+    Q_PROPERTY(bool loading READ loading NOTIFY loadingChanged)
+
+public:
+    enum Roles {
+        EpisodeIdRole = Qt::UserRole + 1,
+        FeedIdRole,
+        TitleRole,
+        AudioUrlRole,
+        DurationSecondsRole,
+        PositionMsRole,
+        LastPlayedAtRole,
+        EnclosureTypeRole,
+        PublishedAtRole,
+        PlayStateRole
+    };
+
+    static const int PageSize = 20;
+
+    explicit RecentEpisodesModel(bool inProgressOnly, QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+
+    int count() const;
+    bool canLoadMore() const;
+    bool loading() const;
+    bool inProgressOnly() const;
+
+    // QML 1 views do not call fetchMore() themselves; ListViews call this
+    // when they reach the end.
+    Q_INVOKABLE void loadMore();
+    // Drops all rows and, if the model has been used, loads the first page
+    // again. Called when stored history changes.
+    Q_INVOKABLE void reload();
+    // Patches rows for progress entries that were just committed: a
+    // touched episode moves to the top (or leaves the in-progress list)
+    // without resetting the model.
+    void applyProgress(const QVariantList &entries);
+    Q_INVOKABLE QVariantMap get(int row) const;
+
+public slots:
+    // Ignores pages for a token other than the outstanding request.
+    void appendPage(int token, const QVariantList &page);
+
+signals:
+    void countChanged();
+    void canLoadMoreChanged();
+    void loadingChanged();
+    void pageRequested(int token, int beforePlayedAt, const QString &beforeEpisodeId,
+                       int limit, bool inProgressOnly);
+
+private:
+    struct Entry {
+        QString episodeId;
+        int feedId;
+        QString title;
+        QString audioUrl;
+        int durationSeconds;
+        int positionMs;
+        int lastPlayedAt;
+        QString enclosureType;
+        int publishedAt;
+        int playState;
+    };
+
+    static Entry entryFromMap(const QVariantMap &map);
+    static bool entryBefore(const Entry &left, const Entry &right);
+    bool accepts(const Entry &entry) const;
+    int rowOf(const QString &episodeId) const;
+    void requestPage();
+
+    QList<Entry> m_entries;
+    bool m_inProgressOnly;
+    bool m_started;
+    bool m_exhausted;
+    int m_pendingToken;
+};
+
+#endif // RECENTEPISODESMODEL_H
@@ -0,0 +1,31 @@
+#include "ReplyParser.h"
+
+ReplyParser::ReplyParser(int ticket, Projection projection, const QByteArray &payload)
+    : m_ticket(ticket)
+    , m_projection(projection)
+    , m_listProjection(0)
+    , m_firstEntry(0)
+    , m_payload(payload)
+{
+}
+
+ReplyParser::ReplyParser(int ticket, ListProjection projection, int firstEntry, const QByteArray &payload)
+    : m_ticket(ticket)
+    , m_projection(0)
+    , m_listProjection(projection)
+    , m_firstEntry(firstEntry)
+    , m_payload(payload)
+{
+}
+
+void ReplyParser::run()
+{
+    QVariant result;
+    QString errorMessage;
+    const bool ok = m_listProjection
+        ? m_listProjection(m_payload, m_firstEntry, &result, &errorMessage)
+        : m_projection(m_payload, &result, &errorMessage);
+    // The body is not needed any more; free it before the result is queued.
+    m_payload.clear();
+    emit projected(m_ticket, result, ok, errorMessage);
+}
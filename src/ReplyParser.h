@@ -0,0 +1,45 @@
+#ifndef REPLYPARSER_H
+#define REPLYPARSER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+
+// Projects an API reply on a QThreadPool thread, so neither the parse nor
+// its transient allocations touch the GUI thread; only projected() crosses
+// back, carrying the compact result.
+//
+// The ticket identifies the request; the receiver drops results whose
+// ticket it no longer waits for.
+class ReplyParser : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    // Called on the pool thread; must not touch GUI-thread state.
+    typedef bool (*Projection)(const QByteArray &payload, QVariant *result, QString *errorMessage);
+    // A list projection that starts at entry firstEntry.
+    typedef bool (*ListProjection)(const QByteArray &payload, int firstEntry,
+                                   QVariant *result, QString *errorMessage);
+
+    ReplyParser(int ticket, Projection projection, const QByteArray &payload);
+    ReplyParser(int ticket, ListProjection projection, int firstEntry, const QByteArray &payload);
+
+    void run();
+
+signals:
+    void projected(int ticket, const QVariant &result, bool ok, const QString &errorMessage);
+
+private:
+    Q_DISABLE_COPY(ReplyParser)
+
+    int m_ticket;
+    Projection m_projection;
+    ListProjection m_listProjection;
+    int m_firstEntry;
+    QByteArray m_payload;
+};
+
+#endif // REPLYPARSER_H
@@ -0,0 +1,245 @@
+#include "ResponseCache.h"
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QUrl>
+#include <QtCore/QtAlgorithms>
+
+namespace {
+const quint32 kFileMagic = 0x50524331; // "PRC1"
+const char *const kFileSuffix = ".cache";
+}
+
+ResponseCache::Entry::Entry()
+    : fetchedAt(0)
+{
+}
+
+bool ResponseCache::Entry::isFresh(int maxAgeSecs, uint now) const
+{
+    // A clock set backwards makes every entry stale rather than fresh forever.
+    return maxAgeSecs > 0 && fetchedAt > 0 && now >= fetchedAt
+        && now - fetchedAt < uint(maxAgeSecs);
+}
+
+ResponseCache::ResponseCache(const QString &directory, int maxEntries)
+    : m_directory(directory)
+    , m_maxEntries(maxEntries < 1 ? 1 : maxEntries)
+    , m_entryCount(-1)
+    , m_hits(0)
+    , m_revalidated(0)
+    , m_misses(0)
+{
+}
+
+QString ResponseCache::canonicalKey(const QUrl &url)
+{
+    QList<QPair<QString, QString> > items = url.queryItems();
+    qSort(items.begin(), items.end());
+
+    QString key = url.scheme().toLower();
+    key += QLatin1String("://");
+    key += url.host().toLower();
+    if (url.port() != -1) {
+        key += QLatin1Char(':') + QString::number(url.port());
+    }
+    key += url.path();
+    for (int i = 0; i < items.size(); ++i) {
+        key += QLatin1Char(i == 0 ? '?' : '&');
+        key += QString::fromLatin1(QUrl::toPercentEncoding(items.at(i).first));
+        key += QLatin1Char('=');
+        key += QString::fromLatin1(QUrl::toPercentEncoding(items.at(i).second));
+    }
+    return key;
+}
+
+bool ResponseCache::load(const QString &key, Entry *entry) const
+{
+    QFile file(filePath(key));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_7);
+    quint32 magic = 0;
+    in >> magic;
+    if (magic != kFileMagic) {
+        return false;
+    }
+    Entry loaded;
+    in >> loaded.url >> loaded.etag >> loaded.lastModified >> loaded.fetchedAt >> loaded.data;
+    // A hash collision or a truncated write reads back as a miss.
+    if (in.status() != QDataStream::Ok || loaded.url != key) {
+        return false;
+    }
+    *entry = loaded;
+    return true;
+}
+
+bool ResponseCache::store(const QString &key, const Entry &entry)
+{
+    if (!ensureDirectory()) {
+        return false;
+    }
+    const QString path = filePath(key);
+    const bool existed = QFile::exists(path);
+    const QString tempPath = path + QLatin1String(".part");
+
+    QFile file(tempPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_7);
+    out << kFileMagic << key << entry.etag << entry.lastModified << entry.fetchedAt << entry.data;
+    file.close();
+    if (out.status() != QDataStream::Ok || file.error() != QFile::NoError) {
+        QFile::remove(tempPath);
+        return false;
+    }
+    // QFile::rename() does not replace an existing file.
+    QFile::remove(path);
+    if (!QFile::rename(tempPath, path)) {
+        QFile::remove(tempPath);
+        return false;
+    }
+
+    if (!existed) {
+        if (m_entryCount < 0) {
+            m_entryCount = countEntries();
+        } else {
+            ++m_entryCount;
+        }
+        if (m_entryCount > m_maxEntries) {
+            prune();
+        }
+    }
+    return true;
+}
+
+bool ResponseCache::touch(const QString &key, const QByteArray &etag,
+                          const QByteArray &lastModified, uint now)
+{
+    Entry entry;
+    if (!load(key, &entry)) {
+        return false;
+    }
+    if (!etag.isEmpty()) {
+        entry.etag = etag;
+    }
+    if (!lastModified.isEmpty()) {
+        entry.lastModified = lastModified;
+    }
+    entry.fetchedAt = now;
+    return store(key, entry);
+}
+
+int ResponseCache::entryCount()
+{
+    if (m_entryCount < 0) {
+        m_entryCount = countEntries();
+    }
+    return m_entryCount;
+}
+
+void ResponseCache::remove(const QString &key)
+{
+    if (QFile::remove(filePath(key)) && m_entryCount > 0) {
+        --m_entryCount;
+    }
+}
+
+void ResponseCache::clear()
+{
+    QDir dir(m_directory);
+    const QStringList files = dir.entryList(QStringList() << (QLatin1Char('*') + QLatin1String(kFileSuffix)),
+                                            QDir::Files);
+    for (int i = 0; i < files.size(); ++i) {
+        dir.remove(files.at(i));
+    }
+    m_entryCount = 0;
+}
+
+int ResponseCache::hits() const
+{
+    return m_hits;
+}
+
+int ResponseCache::revalidated() const
+{
+    return m_revalidated;
+}
+
+int ResponseCache::misses() const
+{
+    return m_misses;
+}
+
+void ResponseCache::recordHit()
+{
+    ++m_hits;
+}
+
+void ResponseCache::recordRevalidated()
+{
+    ++m_revalidated;
+}
+
+void ResponseCache::recordMiss()
+{
+    ++m_misses;
+}
+
+QVariantMap ResponseCache::stats() const
+{
+    QVariantMap map;
+    map.insert(QString::fromLatin1("hits"), m_hits);
+    map.insert(QString::fromLatin1("revalidated"), m_revalidated);
+    map.insert(QString::fromLatin1("misses"), m_misses);
+    map.insert(QString::fromLatin1("entries"), m_entryCount < 0 ? countEntries() : m_entryCount);
+    return map;
+}
+
+QString ResponseCache::filePath(const QString &key) const
+{
+    const QByteArray digest = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1);
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(digest.toHex()) + QLatin1String(kFileSuffix);
+}
+
+bool ResponseCache::ensureDirectory()
+{
+    if (m_directory.isEmpty()) {
+        return false;
+    }
+    QDir dir(m_directory);
+    return dir.exists() || dir.mkpath(QLatin1String("."));
+}
+
+int ResponseCache::countEntries() const
+{
+    return QDir(m_directory).entryList(QStringList() << (QLatin1Char('*') + QLatin1String(kFileSuffix)),
+                                       QDir::Files).size();
+}
+
+void ResponseCache::prune()
+{
+    QDir dir(m_directory);
+    // Oldest first; store() and touch() rewrite the file, so the time is
+    // when the server last confirmed the entry.
+    const QFileInfoList files = dir.entryInfoList(QStringList() << (QLatin1Char('*') + QLatin1String(kFileSuffix)),
+                                                  QDir::Files, QDir::Time | QDir::Reversed);
+    const int target = m_maxEntries - m_maxEntries / 4;
+    int remaining = files.size();
+    for (int i = 0; i < files.size() && remaining > target; ++i) {
+        if (QFile::remove(files.at(i).absoluteFilePath())) {
+            --remaining;
+        }
+    }
+    m_entryCount = remaining;
+}
@@ -0,0 +1,83 @@
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+#include <QtCore/QVariantMap>
+
+class QUrl;
+
+// On-disk cache of API responses, one file per canonical URL. An entry
+// holds the projected result (the compact list or map the views bind to,
+// not the raw JSON) plus the ETag/Last-Modified validators, so a fresh hit
+// or a 304 never runs the JSON parser again.
+//
+// Freshness is decided by the caller's max age per lookup; the cache only
+// records when each entry was last confirmed by the server.
+//
+// Not thread-safe. The file operations (load, store, touch, remove, clear,
+// entryCount, stats) must all run on one thread; PodcastIndexClient runs
+// them through ResponseCacheJob. The hit/revalidated/miss counters do no
+// I/O and are kept by the thread that records them.
+class ResponseCache
+{
+public:
+    static const int DefaultMaxEntries = 256;
+
+    struct Entry {
+        Entry();
+        bool isFresh(int maxAgeSecs, uint now) const;
+
+        QString url;
+        QByteArray etag;
+        QByteArray lastModified;
+        uint fetchedAt;
+        QVariant data;
+    };
+
+    explicit ResponseCache(const QString &directory, int maxEntries = DefaultMaxEntries);
+
+    // Scheme, host and path plus the query items sorted by name, so the
+    // same request built in a different order maps to the same entry.
+    // Podcast Index credentials travel in headers and never enter the key.
+    static QString canonicalKey(const QUrl &url);
+
+    bool load(const QString &key, Entry *entry) const;
+    bool store(const QString &key, const Entry &entry);
+    // Marks the entry as confirmed by a 304, keeping its data. Validators
+    // are replaced when the server sent new ones.
+    bool touch(const QString &key, const QByteArray &etag,
+               const QByteArray &lastModified, uint now);
+    void remove(const QString &key);
+    void clear();
+
+    // Number of cache files; the directory is only listed the first time.
+    int entryCount();
+
+    int hits() const;
+    int revalidated() const;
+    int misses() const;
+    void recordHit();
+    void recordRevalidated();
+    void recordMiss();
+    // { hits, revalidated, misses, entries } for the debug view.
+    QVariantMap stats() const;
+
+private:
+    QString filePath(const QString &key) const;
+    bool ensureDirectory();
+    int countEntries() const;
+    // Drops the least recently confirmed files until a quarter of the
+    // budget is free again.
+    void prune();
+
+    QString m_directory;
+    int m_maxEntries;
+    int m_entryCount;
+    int m_hits;
+    int m_revalidated;
+    int m_misses;
+};
+
+#endif // RESPONSECACHE_H
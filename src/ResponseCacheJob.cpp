@@ -0,0 +1,37 @@
+#include "ResponseCacheJob.h"
+
+ResponseCacheJob::ResponseCacheJob(ResponseCache *cache, Operation operation, int ticket,
+                                   const QString &key, const ResponseCache::Entry &entry)
+    : m_cache(cache)
+    , m_operation(operation)
+    , m_ticket(ticket)
+    , m_key(key)
+    , m_entry(entry)
+{
+    qRegisterMetaType<ResponseCache::Entry>("ResponseCache::Entry");
+}
+
+void ResponseCacheJob::run()
+{
+    ResponseCache::Entry loaded;
+    bool ok = true;
+    switch (m_operation) {
+    case Load:
+        ok = m_cache->load(m_key, &loaded);
+        break;
+    case Store:
+        ok = m_cache->store(m_key, m_entry);
+        break;
+    case Touch:
+        ok = m_cache->touch(m_key, m_entry.etag, m_entry.lastModified, m_entry.fetchedAt);
+        break;
+    case Clear:
+        m_cache->clear();
+        break;
+    case Count:
+        break;
+    }
+    // Stored data is not needed any more; free it before the result is queued.
+    m_entry = ResponseCache::Entry();
+    emit finished(m_ticket, ok, loaded, m_cache->entryCount());
+}
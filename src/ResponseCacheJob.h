@@ -0,0 +1,55 @@
+#ifndef RESPONSECACHEJOB_H
+#define RESPONSECACHEJOB_H
+
+#include <QtCore/QMetaType>
+#include <QtCore/QObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QString>
+
+#include "ResponseCache.h"
+
+// Runs one ResponseCache file operation on a QThreadPool thread, so reading
+// and writing cache files never blocks the GUI thread; finished() carries
+// the outcome back.
+//
+// The cache is not thread-safe: every job for one cache must go to the same
+// single-thread pool, which also keeps them in the order they were started.
+class ResponseCacheJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    enum Operation {
+        Load,
+        Store,
+        // Refreshes validators and fetchedAt from the given entry.
+        Touch,
+        Clear,
+        // Only reports the entry count.
+        Count
+    };
+
+    ResponseCacheJob(ResponseCache *cache, Operation operation, int ticket,
+                     const QString &key = QString(),
+                     const ResponseCache::Entry &entry = ResponseCache::Entry());
+
+    void run();
+
+signals:
+    // entry is the loaded entry for Load and empty otherwise; entryCount is
+    // the number of cache files after the operation.
+    void finished(int ticket, bool ok, const ResponseCache::Entry &entry, int entryCount);
+
+private:
+    Q_DISABLE_COPY(ResponseCacheJob)
+
+    ResponseCache *m_cache;
+    Operation m_operation;
+    int m_ticket;
+    QString m_key;
+    ResponseCache::Entry m_entry;
+};
+
+Q_DECLARE_METATYPE(ResponseCache::Entry)
+
+#endif // RESPONSECACHEJOB_H
@@ -0,0 +1,163 @@
+#include "SearchHistory.h"
+
+#include <QtCore/QPair>
+#include <QtCore/QVariantMap>
+#include <QtCore/QtAlgorithms>
+
+namespace {
+bool newerFirst(const QPair<int, QString> &left, const QPair<int, QString> &right)
+{
+    return left.first > right.first;
+}
+}
+
+SearchHistory::SearchHistory()
+    : m_slots(Capacity)
+    , m_head(0)
+    , m_count(0)
+    , m_nextSequence(0)
+{
+}
+
+int SearchHistory::count() const
+{
+    return m_count;
+}
+
+bool SearchHistory::isEmpty() const
+{
+    return m_count == 0;
+}
+
+QString SearchHistory::termAt(int index) const
+{
+    if (index < 0 || index >= m_count) {
+        return QString();
+    }
+    return m_slots.at(slot(index)).term;
+}
+
+void SearchHistory::add(const QString &term, int searchedAt)
+{
+    const QString trimmed = term.trimmed();
+    if (trimmed.isEmpty()) {
+        return;
+    }
+    const QString folded = fold(trimmed);
+    const int existing = indexOf(folded);
+    if (existing >= 0) {
+        removeAt(existing);
+    } else if (m_count == Capacity) {
+        removeAt(m_count - 1);
+    }
+
+    Entry entry;
+    entry.term = trimmed;
+    entry.searchedAt = searchedAt;
+    entry.sequence = m_nextSequence++;
+    m_head = (m_head + Capacity - 1) % Capacity;
+    m_slots[m_head] = entry;
+    ++m_count;
+    m_prefixIndex.insert(folded, entry);
+}
+
+bool SearchHistory::remove(const QString &term)
+{
+    const int index = indexOf(fold(term.trimmed()));
+    if (index < 0) {
+        return false;
+    }
+    removeAt(index);
+    return true;
+}
+
+void SearchHistory::clear()
+{
+    m_slots.fill(Entry());
+    m_head = 0;
+    m_count = 0;
+    m_prefixIndex.clear();
+}
+
+QStringList SearchHistory::suggestions(const QString &prefix, int limit) const
+{
+    QStringList result;
+    const QString folded = fold(prefix.trimmed());
+    if (folded.isEmpty() || limit <= 0) {
+        return result;
+    }
+
+    // Keys sharing the prefix are contiguous in the sorted map.
+    QList<QPair<int, QString> > matches;
+    QMap<QString, Entry>::const_iterator it = m_prefixIndex.lowerBound(folded);
+    for (; it != m_prefixIndex.constEnd() && it.key().startsWith(folded); ++it) {
+        if (it.key() != folded) {
+            matches.append(qMakePair(it.value().sequence, it.value().term));
+        }
+    }
+    qSort(matches.begin(), matches.end(), newerFirst);
+    for (int i = 0; i < matches.size() && i < limit; ++i) {
+        result << matches.at(i).second;
+    }
+    return result;
+}
+
+QVariantList SearchHistory::toVariantList() const
+{
+    QVariantList list;
+    for (int i = 0; i < m_count; ++i) {
+        const Entry &entry = m_slots.at(slot(i));
+        QVariantMap map;
+        map.insert(QString::fromLatin1("term"), entry.term);
+        map.insert(QString::fromLatin1("searchedAt"), entry.searchedAt);
+        list.append(map);
+    }
+    return list;
+}
+
+void SearchHistory::setEntries(const QVariantList &entries)
+{
+    clear();
+    // Oldest first, so the newest row ends up at the front.
+    const int size = entries.size() < Capacity ? entries.size() : Capacity;
+    for (int i = size - 1; i >= 0; --i) {
+        const QVariantMap map = entries.at(i).toMap();
+        add(map.value(QString::fromLatin1("term")).toString(),
+            map.value(QString::fromLatin1("searchedAt")).toInt());
+    }
+}
+
+QString SearchHistory::fold(const QString &term)
+{
+    return term.toCaseFolded();
+}
+
+int SearchHistory::slot(int index) const
+{
+    return (m_head + index) % Capacity;
+}
+
+int SearchHistory::indexOf(const QString &folded) const
+{
+    QMap<QString, Entry>::const_iterator it = m_prefixIndex.constFind(folded);
+    if (it == m_prefixIndex.constEnd()) {
+        return -1;
+    }
+    for (int i = 0; i < m_count; ++i) {
+        if (m_slots.at(slot(i)).sequence == it.value().sequence) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void SearchHistory::removeAt(int index)
+{
+    m_prefixIndex.remove(fold(m_slots.at(slot(index)).term));
+    // Close the gap by pulling the older entries one slot forward.
+    for (int i = index; i < m_count - 1; ++i) {
+        m_slots[slot(i)] = m_slots.at(slot(i + 1));
+    }
+    m_slots[slot(m_count - 1)] = Entry();
+    --m_count;
+}
@@ -0,0 +1,62 @@
+#ifndef SEARCHHISTORY_H
+#define SEARCHHISTORY_H
+
+#include <QtCore/QMap>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantList>
+#include <QtCore/QVector>
+
+// Recent search terms, newest first, in a ring of Capacity slots. Terms
+// compare case-insensitively, like the NOCASE key of the search_history
+// table. A map of case-folded terms, sorted by QMap, answers prefix lookups
+// for as-you-type suggestions without touching SQLite.
+class SearchHistory
+{
+public:
+    static const int Capacity = 20;
+
+    SearchHistory();
+
+    int count() const;
+    bool isEmpty() const;
+    // Newest first; empty outside [0, count()).
+    QString termAt(int index) const;
+
+    // Moves an existing term to the front or inserts it there, dropping the
+    // oldest entry when the ring is full.
+    void add(const QString &term, int searchedAt);
+    bool remove(const QString &term);
+    void clear();
+
+    // Up to limit stored terms starting with prefix (case-insensitive),
+    // newest first. The prefix itself is never suggested back.
+    QStringList suggestions(const QString &prefix, int limit) const;
+
+    // [{ term, searchedAt }], newest first: the QML property shape and what
+    // StorageWorker::saveSearchHistory() persists.
+    QVariantList toVariantList() const;
+    // Replaces the contents with rows in the same shape, newest first.
+    void setEntries(const QVariantList &entries);
+
+private:
+    struct Entry {
+        QString term;
+        int searchedAt;
+        // Insertion order; larger is newer. Survives shifts in the ring.
+        int sequence;
+    };
+
+    static QString fold(const QString &term);
+    int slot(int index) const;
+    int indexOf(const QString &folded) const;
+    void removeAt(int index);
+
+    QVector<Entry> m_slots;
+    int m_head;
+    int m_count;
+    int m_nextSequence;
+    QMap<QString, Entry> m_prefixIndex;
+};
+
+#endif // SEARCHHISTORY_H
@@ -0,0 +1,165 @@
+#include "SearchResultsModel.h"
+
+SearchResultsModel::SearchResultsModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(FeedIdRole, "feedId");
+    roles.insert(GuidRole, "guid");
+    roles.insert(TitleRole, "title");
+    roles.insert(ImageRole, "image");
+    roles.insert(ImageUrlHashRole, "imageUrlHash");
+    roles.insert(DescriptionRole, "description");
+    setRoleNames(roles);
+}
+
+int SearchResultsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant SearchResultsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+    case FeedIdRole:
+        return entry.feedId;
+    case GuidRole:
+        return entry.guid;
+    case Qt::DisplayRole:
+    case TitleRole:
+        return entry.title;
+    case ImageRole:
+        return entry.image;
+    case ImageUrlHashRole:
+        return entry.imageUrlHash;
+    case DescriptionRole:
+        return entry.description;
+    default:
+        return QVariant();
+    }
+}
+
+int SearchResultsModel::count() const
+{
+    return m_entries.size();
+}
+
+bool SearchResultsModel::contains(int feedId) const
+{
+    return m_feedIds.contains(feedId);
+}
+
+QVariantMap SearchResultsModel::get(int row) const
+{
+    if (row < 0 || row >= m_entries.size()) {
+        return QVariantMap();
+    }
+    return entryToMap(m_entries.at(row));
+}
+
+QVariantList SearchResultsModel::feedIds() const
+{
+    QVariantList ids;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        ids.append(m_entries.at(i).feedId);
+    }
+    return ids;
+}
+
+QVariantList SearchResultsModel::toVariantList() const
+{
+    QVariantList list;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        list.append(entryToMap(m_entries.at(i)));
+    }
+    return list;
+}
+
+void SearchResultsModel::setResults(const QVariantList &results)
+{
+    const int oldCount = m_entries.size();
+
+    beginResetModel();
+    m_entries.clear();
+    m_feedIds.clear();
+    for (int i = 0; i < results.size(); ++i) {
+        const Entry entry = entryFromMap(results.at(i).toMap());
+        if (entry.feedId <= 0 || m_feedIds.contains(entry.feedId)) {
+            continue;
+        }
+        m_entries.append(entry);
+        m_feedIds.insert(entry.feedId);
+    }
+    endResetModel();
+
+    if (m_entries.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+int SearchResultsModel::appendResults(const QVariantList &results)
+{
+    // Collected first: beginInsertRows() needs the final row range.
+    QList<Entry> added;
+    QSet<int> addedIds;
+    for (int i = 0; i < results.size(); ++i) {
+        const Entry entry = entryFromMap(results.at(i).toMap());
+        if (entry.feedId <= 0 || m_feedIds.contains(entry.feedId) || addedIds.contains(entry.feedId)) {
+            continue;
+        }
+        added.append(entry);
+        addedIds.insert(entry.feedId);
+    }
+    if (added.isEmpty()) {
+        return 0;
+    }
+
+    const int first = m_entries.size();
+    beginInsertRows(QModelIndex(), first, first + added.size() - 1);
+    m_entries += added;
+    m_feedIds += addedIds;
+    endInsertRows();
+    emit countChanged();
+    return added.size();
+}
+
+void SearchResultsModel::clear()
+{
+    if (m_entries.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    m_entries.clear();
+    m_feedIds.clear();
+    endResetModel();
+    emit countChanged();
+}
+
+SearchResultsModel::Entry SearchResultsModel::entryFromMap(const QVariantMap &map)
+{
+    Entry entry;
+    entry.feedId = map.value(QString::fromLatin1("feedId")).toInt();
+    entry.guid = map.value(QString::fromLatin1("guid")).toString();
+    entry.title = map.value(QString::fromLatin1("title")).toString();
+    entry.image = map.value(QString::fromLatin1("image")).toString();
+    entry.imageUrlHash = map.value(QString::fromLatin1("imageUrlHash")).toString();
+    entry.description = map.value(QString::fromLatin1("description")).toString();
+    return entry;
+}
+
+QVariantMap SearchResultsModel::entryToMap(const Entry &entry)
+{
+    QVariantMap map;
+    map.insert(QString::fromLatin1("feedId"), entry.feedId);
+    map.insert(QString::fromLatin1("guid"), entry.guid);
+    map.insert(QString::fromLatin1("title"), entry.title);
+    map.insert(QString::fromLatin1("image"), entry.image);
+    map.insert(QString::fromLatin1("imageUrlHash"), entry.imageUrlHash);
+    map.insert(QString::fromLatin1("description"), entry.description);
+    return map;
+}
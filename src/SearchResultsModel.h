@@ -0,0 +1,68 @@
+#ifndef SEARCHRESULTSMODEL_H
+#define SEARCHRESULTSMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
+
+// Podcast Index search results in server order. "Load More" pages are
+// appended as a single row insert holding only feeds not already listed,
+// so the rows (and delegates) for earlier pages are never rebuilt.
+class SearchResultsModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Roles {
+        FeedIdRole = Qt::UserRole + 1,
+        GuidRole,
+        TitleRole,
+        ImageRole,
+        ImageUrlHashRole,
+        DescriptionRole
+    };
+
+    explicit SearchResultsModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    int count() const;
+    bool contains(int feedId) const;
+    Q_INVOKABLE QVariantMap get(int row) const;
+    // Feed IDs of every row, in order.
+    Q_INVOKABLE QVariantList feedIds() const;
+    QVariantList toVariantList() const;
+
+    // Replaces the whole list (a new search).
+    void setResults(const QVariantList &results);
+    // Appends the results whose feedId is not listed yet; returns how many
+    // rows were added.
+    int appendResults(const QVariantList &results);
+    void clear();
+
+signals:
+    void countChanged();
+
+private:
+    struct Entry {
+        int feedId;
+        QString guid;
+        QString title;
+        QString image;
+        QString imageUrlHash;
+        QString description;
+    };
+
+    static Entry entryFromMap(const QVariantMap &map);
+    static QVariantMap entryToMap(const Entry &entry);
+
+    QList<Entry> m_entries;
+    QSet<int> m_feedIds;
+};
+
+#endif // SEARCHRESULTSMODEL_H
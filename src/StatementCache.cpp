@@ -0,0 +1,108 @@
+#include "StatementCache.h"
+
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+#include <QtCore/qglobal.h>
+
+StatementCache::StatementCache()
+{
+}
+
+StatementCache::~StatementCache()
+{
+    clear();
+    StatementProfiler::detach(m_db.connectionName(), &m_profiler);
+}
+
+void StatementCache::setDatabase(const QSqlDatabase &db)
+{
+    clear();
+    StatementProfiler::detach(m_db.connectionName(), &m_profiler);
+    m_db = db;
+    StatementProfiler::attach(m_db.connectionName(), &m_profiler);
+}
+
+QSqlDatabase StatementCache::database() const
+{
+    return m_db;
+}
+
+QSqlQuery *StatementCache::query(const QString &sql)
+{
+    QHash<QString, QSqlQuery *>::const_iterator it = m_queries.constFind(sql);
+    if (it != m_queries.constEnd()) {
+        return it.value();
+    }
+
+    if (!m_db.isValid() || !m_db.isOpen()) {
+        return 0;
+    }
+
+    QSqlQuery *query = new QSqlQuery(m_db);
+    query->setForwardOnly(true);
+    if (!query->prepare(sql)) {
+        qWarning("Storage error (prepare): %s - %s",
+                 qPrintable(sql),
+                 qPrintable(query->lastError().text()));
+        delete query;
+        return 0;
+    }
+    m_queries.insert(sql, query);
+    return query;
+}
+
+bool StatementCache::exec(QSqlQuery *query)
+{
+    QElapsedTimer timer;
+    timer.start();
+    // A read that was never finished: its time is unknown, drop it.
+    m_running.remove(query);
+    const bool ok = query->exec();
+    if (ok && query->isSelect()) {
+        m_running.insert(query, timer);
+    } else {
+        m_profiler.record(query->lastQuery(), StatementProfiler::elapsedUs(timer));
+    }
+    return ok;
+}
+
+void StatementCache::finish(QSqlQuery *query)
+{
+    query->finish();
+    QHash<QSqlQuery *, QElapsedTimer>::iterator it = m_running.find(query);
+    if (it == m_running.end()) {
+        return;
+    }
+    m_profiler.record(query->lastQuery(), StatementProfiler::elapsedUs(it.value()));
+    m_running.erase(it);
+}
+
+bool StatementCache::transaction()
+{
+    StatementTimer timer(&m_profiler, QLatin1String("BEGIN"));
+    return m_db.transaction();
+}
+
+bool StatementCache::commit()
+{
+    StatementTimer timer(&m_profiler, QLatin1String("COMMIT"));
+    return m_db.commit();
+}
+
+bool StatementCache::rollback()
+{
+    StatementTimer timer(&m_profiler, QLatin1String("ROLLBACK"));
+    return m_db.rollback();
+}
+
+StatementProfiler *StatementCache::profiler()
+{
+    return &m_profiler;
+}
+
+void StatementCache::clear()
+{
+    m_running.clear();
+    qDeleteAll(m_queries);
+    m_queries.clear();
+}
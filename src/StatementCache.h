@@ -0,0 +1,57 @@
+#ifndef STATEMENTCACHE_H
+#define STATEMENTCACHE_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtSql/QSqlDatabase>
+
+#include "StatementProfiler.h"
+
+class QSqlQuery;
+
+// Keeps one prepared QSqlQuery per SQL text for a single connection so hot
+// statements are compiled once instead of on every call. All cached queries
+// are forward-only; callers bind with bindValue(index, ...) and call finish()
+// after reading so the statement is reset for the next user.
+//
+// Statements run through exec()/finish() are timed by the profiler: writes
+// for the exec() call, reads from exec() until finish(), so stepping through
+// the rows counts too. The profiler is attached under the connection name,
+// so StatementTimer can time raw queries on the same connection.
+class StatementCache
+{
+public:
+    StatementCache();
+    ~StatementCache();
+
+    void setDatabase(const QSqlDatabase &db);
+    QSqlDatabase database() const;
+
+    // Returns the cached statement for sql, preparing it on first use.
+    // Returns 0 (and logs) if the statement fails to prepare.
+    QSqlQuery *query(const QString &sql);
+
+    // Timed replacements for query->exec(), query->finish() and
+    // database().transaction()/commit()/rollback().
+    bool exec(QSqlQuery *query);
+    void finish(QSqlQuery *query);
+    bool transaction();
+    bool commit();
+    bool rollback();
+
+    StatementProfiler *profiler();
+
+    void clear();
+
+private:
+    Q_DISABLE_COPY(StatementCache)
+
+    QSqlDatabase m_db;
+    QHash<QString, QSqlQuery *> m_queries;
+    // Reads between exec() and finish().
+    QHash<QSqlQuery *, QElapsedTimer> m_running;
+    StatementProfiler m_profiler;
+};
+
+#endif // STATEMENTCACHE_H
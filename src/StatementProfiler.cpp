@@ -0,0 +1,175 @@
+#include "StatementProfiler.h"
+
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QVariantMap>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/qglobal.h>
+
+namespace {
+struct Row {
+    QString sql;
+    qint64 totalUs;
+    QVariantMap map;
+};
+
+bool largerTotalFirst(const Row &left, const Row &right)
+{
+    return left.totalUs > right.totalUs;
+}
+
+double toMs(qint64 us)
+{
+    return us / 1000.0;
+}
+
+// The read and write connections live on different threads.
+QMutex gConnectionsMutex;
+QHash<QString, StatementProfiler *> gConnections;
+}
+
+StatementProfiler::Stats::Stats()
+    : count(0)
+    , totalUs(0)
+    , maxUs(0)
+    , nextSample(0)
+{
+}
+
+StatementProfiler::StatementProfiler()
+    : m_slowThresholdMs(DefaultSlowThresholdMs)
+{
+}
+
+void StatementProfiler::setSlowThresholdMs(int ms)
+{
+    m_slowThresholdMs = ms < 0 ? 0 : ms;
+}
+
+int StatementProfiler::slowThresholdMs() const
+{
+    return m_slowThresholdMs;
+}
+
+void StatementProfiler::record(const QString &sql, qint64 elapsedUs)
+{
+    Stats &stats = m_stats[sql];
+    ++stats.count;
+    stats.totalUs += elapsedUs;
+    if (elapsedUs > stats.maxUs) {
+        stats.maxUs = elapsedUs;
+    }
+    const int sample = elapsedUs > 0x7fffffff ? 0x7fffffff : int(elapsedUs);
+    if (stats.samples.size() < SampleWindow) {
+        stats.samples.append(sample);
+    } else {
+        stats.samples[stats.nextSample] = sample;
+    }
+    stats.nextSample = (stats.nextSample + 1) % SampleWindow;
+
+    if (m_slowThresholdMs > 0 && elapsedUs >= qint64(m_slowThresholdMs) * 1000) {
+        qWarning("Slow statement (%.1f ms): %s", toMs(elapsedUs), qPrintable(sql.simplified()));
+    }
+}
+
+QVariantList StatementProfiler::snapshot() const
+{
+    QList<Row> rows;
+    QHash<QString, Stats>::const_iterator it = m_stats.constBegin();
+    for (; it != m_stats.constEnd(); ++it) {
+        const Stats &stats = it.value();
+        Row row;
+        row.sql = it.key();
+        row.totalUs = stats.totalUs;
+        row.map.insert(QString::fromLatin1("sql"), it.key().simplified());
+        row.map.insert(QString::fromLatin1("count"), stats.count);
+        row.map.insert(QString::fromLatin1("totalMs"), toMs(stats.totalUs));
+        row.map.insert(QString::fromLatin1("maxMs"), toMs(stats.maxUs));
+        row.map.insert(QString::fromLatin1("p95Ms"), toMs(percentileUs(stats, 95)));
+        rows.append(row);
+    }
+    qSort(rows.begin(), rows.end(), largerTotalFirst);
+
+    QVariantList result;
+    for (int i = 0; i < rows.size(); ++i) {
+        result.append(rows.at(i).map);
+    }
+    return result;
+}
+
+void StatementProfiler::reset()
+{
+    m_stats.clear();
+}
+
+void StatementProfiler::attach(const QString &connectionName, StatementProfiler *profiler)
+{
+    if (connectionName.isEmpty()) {
+        return;
+    }
+    QMutexLocker locker(&gConnectionsMutex);
+    if (profiler) {
+        gConnections.insert(connectionName, profiler);
+    } else {
+        gConnections.remove(connectionName);
+    }
+}
+
+void StatementProfiler::detach(const QString &connectionName, StatementProfiler *profiler)
+{
+    QMutexLocker locker(&gConnectionsMutex);
+    if (gConnections.value(connectionName) == profiler) {
+        gConnections.remove(connectionName);
+    }
+}
+
+StatementProfiler *StatementProfiler::forConnection(const QString &connectionName)
+{
+    QMutexLocker locker(&gConnectionsMutex);
+    return gConnections.value(connectionName);
+}
+
+qint64 StatementProfiler::elapsedUs(const QElapsedTimer &timer)
+{
+#if (QT_VERSION >= 0x040800)
+    return timer.nsecsElapsed() / 1000;
+#else
+    return timer.elapsed() * 1000;
+#endif
+}
+
+qint64 StatementProfiler::percentileUs(const Stats &stats, int percent)
+{
+    if (stats.samples.isEmpty()) {
+        return 0;
+    }
+    // Nearest rank over the sample window.
+    QVector<int> sorted = stats.samples;
+    qSort(sorted.begin(), sorted.end());
+    int rank = (percent * sorted.size() + 99) / 100;
+    if (rank < 1) {
+        rank = 1;
+    }
+    return sorted.at(rank - 1);
+}
+
+StatementTimer::StatementTimer(StatementProfiler *profiler, const QString &sql)
+    : m_profiler(profiler)
+    , m_sql(sql)
+{
+    m_timer.start();
+}
+
+StatementTimer::StatementTimer(const QString &connectionName, const QString &sql)
+    : m_profiler(StatementProfiler::forConnection(connectionName))
+    , m_sql(sql)
+{
+    m_timer.start();
+}
+
+StatementTimer::~StatementTimer()
+{
+    if (m_profiler) {
+        m_profiler->record(m_sql, StatementProfiler::elapsedUs(m_timer));
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef STATEMENTPROFILER_H
+#define STATEMENTPROFILER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QString>
+#include <QtCore/QVariantList>
+#include <QtCore/QVector>
+
+// Per-statement timing keyed by SQL text: call count, total, max and p95
+// over the most recent SampleWindow runs. Statements slower than the
+// threshold are logged with qWarning(), which main.cpp routes to podin.log.
+// Not thread-safe; each connection's owner keeps its own profiler and
+// attaches it under the connection name so raw QSqlQuery calls on that
+// connection can be timed too (see StatementTimer).
+class StatementProfiler
+{
+public:
+    static const int SampleWindow = 64;
+    static const int DefaultSlowThresholdMs = 50;
+
+    StatementProfiler();
+
+    // 0 disables the slow-statement log; timings are still collected.
+    void setSlowThresholdMs(int ms);
+    int slowThresholdMs() const;
+
+    void record(const QString &sql, qint64 elapsedUs);
+
+    // [{ sql, count, totalMs, maxMs, p95Ms }], largest total first.
+    QVariantList snapshot() const;
+    void reset();
+
+    // Registers profiler for a QSqlDatabase connection name; attaching 0
+    // removes the entry. detach() only removes it if it is still profiler.
+    static void attach(const QString &connectionName, StatementProfiler *profiler);
+    static void detach(const QString &connectionName, StatementProfiler *profiler);
+    // The profiler attached for connectionName, or 0.
+    static StatementProfiler *forConnection(const QString &connectionName);
+
+    // Microseconds since timer was started; nanosecond-based on Qt 4.8
+    // (device), millisecond resolution on Qt 4.7 (simulator).
+    static qint64 elapsedUs(const QElapsedTimer &timer);
+
+private:
+    struct Stats {
+        Stats();
+        int count;
+        qint64 totalUs;
+        qint64 maxUs;
+        // Ring of the last SampleWindow durations, in microseconds.
+        QVector<int> samples;
+        int nextSample;
+    };
+
+    static qint64 percentileUs(const Stats &stats, int percent);
+
+    QHash<QString, Stats> m_stats;
+    int m_slowThresholdMs;
+};
+
+// Times one statement from construction to destruction and records it.
+// The connection-name form is for raw QSqlQuery/QSqlDatabase calls; it
+// records nothing if no profiler is attached for that connection.
+class StatementTimer
+{
+public:
+    StatementTimer(StatementProfiler *profiler, const QString &sql);
+    StatementTimer(const QString &connectionName, const QString &sql);
+    ~StatementTimer();
+
+private:
+    Q_DISABLE_COPY(StatementTimer)
+
+    StatementProfiler *m_profiler;
+    QString m_sql;
+    QElapsedTimer m_timer;
+};
+
+#endif // STATEMENTPROFILER_H
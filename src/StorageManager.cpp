@@ -1,35 +1,64 @@
 #include "StorageManager.h"
 
-#include "AppConfig.h"
+#include "RecentEpisodesModel.h"
+#include "StorageWorker.h"
+#include "SubscriptionListModel.h"
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
 #include <QtCore/QDir>
-#include <QtCore/QFile>
-#include <QtCore/QTextStream>
+#include <QtCore/QMetaObject>
+#include <QtCore/QtAlgorithms>
 #include <QtCore/QDebug>
 #include <QtGui/QDesktopServices>
-#include <QtSql/QSqlDatabase>
-#include <QtSql/QSqlError>
-#include <QtSql/QSqlQuery>
 #include <QtCore/qglobal.h>
 
 namespace {
-const char *const kConnectionName = "podin";
+// Progress saves are held in memory and written in one batch at most this often
+// while playing. Pause, stop and exit flush immediately.
+const int kProgressFlushIntervalMs = 5 * 60 * 1000;
 
-void logError(const QString &context, const QSqlError &error)
+// Setting changes are coalesced (e.g. a dragged volume slider) and written
+// in one transaction once they settle.
+const int kSettingsFlushDelayMs = 1000;
+
+// Search history is rewritten as a whole (at most 20 rows) once searching
+// pauses for this long.
+const int kSearchHistoryFlushDelayMs = 5000;
+
+// Quiet period after the last write before a WAL checkpoint is requested.
+const int kCheckpointDelayMs = 3000;
+
+// Maintenance starts a while after startup and pauses between vacuum steps
+// so queued reads and writes get the storage thread in between.
+const int kMaintenanceDelayMs = 2 * 60 * 1000;
+const int kVacuumStepIntervalMs = 500;
+
+const char *const kForwardSkipKey = "forward_skip_seconds";
+const char *const kBackwardSkipKey = "backward_skip_seconds";
+const char *const kArtworkLoadingKey = "enable_artwork_loading";
+const char *const kVolumePercentKey = "volume_percent";
+const char *const kSleepTimerKey = "sleep_timer_minutes";
+
+bool largerTotalFirst(const QVariant &left, const QVariant &right)
 {
-    if (error.type() == QSqlError::NoError) {
-        return;
-    }
-    qWarning("Storage error (%s): %s",
-             qPrintable(context),
-             qPrintable(error.text()));
+    return left.toMap().value(QString::fromLatin1("totalMs")).toDouble()
+        > right.toMap().value(QString::fromLatin1("totalMs")).toDouble();
 }
 }
 
 StorageManager::StorageManager(QObject *parent)
     : QObject(parent)
+    , m_searchHistoryDirty(false)
+    , m_playbackActive(false)
+    , m_maintenancePruned(false)
+    , m_worker(new StorageWorker(StorageWorker::ReadWrite))
+    , m_reader(new StorageWorker(StorageWorker::ReadOnly))
+    , m_readerReady(false)
+    , m_statementDumpsPending(0)
+    , m_subscriptionModel(new SubscriptionListModel(this))
+    , m_recentEpisodes(new RecentEpisodesModel(false, this))
+    , m_inProgressEpisodes(new RecentEpisodesModel(true, this))
     , m_forwardSkipSeconds(30)
     , m_backwardSkipSeconds(15)
     , m_enableArtworkLoading(false)
@@ -37,20 +66,136 @@ StorageManager::StorageManager(QObject *parent)
     , m_sleepTimerMinutes(0)
     , m_dbStatus(QLatin1String("not initialized"))
 {
-    initDb();
-    loadSettings();
-    refreshSubscriptions();
-    refreshSearchHistory();
+    m_lastSavedProgress.setMaxCost(LastSavedProgressCapacity);
+    m_progressFlushTimer.setSingleShot(true);
+    m_progressFlushTimer.setInterval(kProgressFlushIntervalMs);
+    connect(&m_progressFlushTimer, SIGNAL(timeout()), this, SLOT(flushPendingProgress()));
+    m_settingsFlushTimer.setSingleShot(true);
+    m_settingsFlushTimer.setInterval(kSettingsFlushDelayMs);
+    connect(&m_settingsFlushTimer, SIGNAL(timeout()), this, SLOT(flushSettings()));
+    m_searchHistoryFlushTimer.setSingleShot(true);
+    m_searchHistoryFlushTimer.setInterval(kSearchHistoryFlushDelayMs);
+    connect(&m_searchHistoryFlushTimer, SIGNAL(timeout()), this, SLOT(flushSearchHistory()));
+    m_checkpointTimer.setSingleShot(true);
+    m_checkpointTimer.setInterval(kCheckpointDelayMs);
+    connect(&m_checkpointTimer, SIGNAL(timeout()), this, SLOT(onCheckpointTimeout()));
+    m_maintenanceTimer.setSingleShot(true);
+    connect(&m_maintenanceTimer, SIGNAL(timeout()), this, SLOT(onMaintenanceTimeout()));
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(flushPendingProgress()));
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(flushSettings()));
+        connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(flushSearchHistory()));
+    }
+
+    m_worker->moveToThread(&m_thread);
+    m_reader->moveToThread(&m_readThread);
+    connect(m_worker, SIGNAL(opened(QString,QString,QString)),
+            this, SLOT(onOpened(QString,QString,QString)));
+    connect(m_worker, SIGNAL(settingsLoaded(QVariantMap)),
+            this, SLOT(onSettingsLoaded(QVariantMap)));
+    connect(m_worker, SIGNAL(subscriptionSaved(QVariantMap)),
+            this, SLOT(onSubscriptionSaved(QVariantMap)));
+    connect(m_worker, SIGNAL(subscriptionRemoved(int)),
+            this, SLOT(onSubscriptionRemoved(int)));
+    connect(m_worker, SIGNAL(subscriptionsImported(int,QVariantList,int)),
+            this, SLOT(onSubscriptionsImported(int,QVariantList,int)));
+    connect(m_worker, SIGNAL(progressSaved()),
+            this, SLOT(onProgressSaved()));
+    connect(m_worker, SIGNAL(pruneStepFinished(bool)),
+            this, SLOT(onPruneStepFinished(bool)));
+    connect(m_worker, SIGNAL(vacuumStepFinished(bool)),
+            this, SLOT(onVacuumStepFinished(bool)));
+    // Subscription reads stay on the writer: queued behind subscribe and
+    // unsubscribe, they never see the list from before a change.
+    connect(m_worker, SIGNAL(subscriptionsLoaded(QVariantList)),
+            this, SLOT(onSubscriptionsLoaded(QVariantList)));
+    connect(m_worker, SIGNAL(opmlExported(int,QString)),
+            this, SIGNAL(opmlExported(int,QString)));
+    connect(m_reader, SIGNAL(readOnlyOpened(bool)),
+            this, SLOT(onReaderOpened(bool)));
+    connectReadSignals(m_worker);
+    connectReadSignals(m_reader);
+    connect(m_recentEpisodes, SIGNAL(pageRequested(int,int,QString,int,bool)),
+            this, SLOT(onRecentPageRequested(int,int,QString,int,bool)));
+    connect(m_inProgressEpisodes, SIGNAL(pageRequested(int,int,QString,int,bool)),
+            this, SLOT(onRecentPageRequested(int,int,QString,int,bool)));
+    m_thread.start();
+    m_readThread.start();
+
+    // Opens the database, then delivers settings, subscriptions and history.
+    QMetaObject::invokeMethod(m_worker, "open", Qt::QueuedConnection);
+}
+
+StorageManager::~StorageManager()
+{
+    flushPendingProgress();
+    flushSettings();
+    flushSearchHistory();
+    if (m_readThread.isRunning()) {
+        QMetaObject::invokeMethod(m_reader, "close", Qt::BlockingQueuedConnection);
+        m_readThread.quit();
+        m_readThread.wait();
+    }
+    if (m_thread.isRunning()) {
+        // Runs after every queued write, so nothing is lost on shutdown.
+        QMetaObject::invokeMethod(m_worker, "close", Qt::BlockingQueuedConnection);
+        m_thread.quit();
+        m_thread.wait();
+    }
+    delete m_reader;
+    delete m_worker;
+}
+
+void StorageManager::connectReadSignals(StorageWorker *worker)
+{
+    connect(worker, SIGNAL(searchHistoryLoaded(QVariantList)),
+            this, SLOT(onSearchHistoryLoaded(QVariantList)));
+    connect(worker, SIGNAL(episodeStateLoaded(QString,QVariantMap)),
+            this, SIGNAL(episodeStateLoaded(QString,QVariantMap)));
+    connect(worker, SIGNAL(episodeStatesLoaded(QStringList,QVariantMap)),
+            this, SLOT(onEpisodeStatesLoaded(QStringList,QVariantMap)));
+    connect(worker, SIGNAL(cachedEpisodesLoaded(int,QVariantList)),
+            this, SIGNAL(cachedEpisodesLoaded(int,QVariantList)));
+    connect(worker, SIGNAL(localSearchFinished(QString,QVariantList)),
+            this, SIGNAL(localSearchFinished(QString,QVariantList)));
+    connect(worker, SIGNAL(operationFailed(QString)),
+            this, SLOT(onOperationFailed(QString)));
+    connect(worker, SIGNAL(statementStatsDumped(QVariantList)),
+            this, SLOT(onStatementStatsDumped(QVariantList)));
+    connect(worker, SIGNAL(recentEpisodesLoaded(int,QVariantList)),
+            m_recentEpisodes, SLOT(appendPage(int,QVariantList)));
+    connect(worker, SIGNAL(recentEpisodesLoaded(int,QVariantList)),
+            m_inProgressEpisodes, SLOT(appendPage(int,QVariantList)));
+}
+
+StorageWorker *StorageManager::reader() const
+{
+    return m_readerReady ? m_reader : m_worker;
 }
 
 QVariantList StorageManager::subscriptions() const
 {
-    return m_subscriptions;
+    return m_subscriptionModel->toVariantList();
+}
+
+QObject *StorageManager::subscriptionModel() const
+{
+    return m_subscriptionModel;
+}
+
+QObject *StorageManager::recentEpisodes() const
+{
+    return m_recentEpisodes;
+}
+
+QObject *StorageManager::inProgressEpisodes() const
+{
+    return m_inProgressEpisodes;
 }
 
 QVariantList StorageManager::searchHistory() const
 {
-    return m_searchHistory;
+    return m_searchHistory.toVariantList();
 }
 
 int StorageManager::forwardSkipSeconds() const
@@ -80,7 +225,7 @@ void StorageManager::setForwardSkipSeconds(int seconds)
         return;
     }
     m_forwardSkipSeconds = clamped;
-    saveSetting(QString::fromLatin1("forward_skip_seconds"), m_forwardSkipSeconds);
+    saveSetting(QString::fromLatin1(kForwardSkipKey), m_forwardSkipSeconds);
     emit forwardSkipSecondsChanged();
 }
 
@@ -91,7 +236,7 @@ void StorageManager::setBackwardSkipSeconds(int seconds)
         return;
     }
     m_backwardSkipSeconds = clamped;
-    saveSetting(QString::fromLatin1("backward_skip_seconds"), m_backwardSkipSeconds);
+    saveSetting(QString::fromLatin1(kBackwardSkipKey), m_backwardSkipSeconds);
     emit backwardSkipSecondsChanged();
 }
 
@@ -101,7 +246,7 @@ void StorageManager::setEnableArtworkLoading(bool enabled)
         return;
     }
     m_enableArtworkLoading = enabled;
-    saveSetting(QString::fromLatin1("enable_artwork_loading"), m_enableArtworkLoading ? 1 : 0);
+    saveSetting(QString::fromLatin1(kArtworkLoadingKey), m_enableArtworkLoading ? 1 : 0);
     emit enableArtworkLoadingChanged();
 }
 
@@ -112,7 +257,7 @@ void StorageManager::setVolumePercent(int percent)
         return;
     }
     m_volumePercent = clamped;
-    saveSetting(QString::fromLatin1("volume_percent"), m_volumePercent);
+    saveSetting(QString::fromLatin1(kVolumePercentKey), m_volumePercent);
     emit volumePercentChanged();
 }
 
@@ -132,80 +277,81 @@ void StorageManager::setSleepTimerMinutes(int minutes)
         return;
     }
     m_sleepTimerMinutes = minutes;
-    saveSetting(QString::fromLatin1("sleep_timer_minutes"), m_sleepTimerMinutes);
+    saveSetting(QString::fromLatin1(kSleepTimerKey), m_sleepTimerMinutes);
     emit sleepTimerMinutesChanged();
 }
 
 void StorageManager::refreshSubscriptions()
 {
-    if (!ensureOpen()) {
-        return;
-    }
-
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    if (!query.exec(QLatin1String("SELECT feed_id, title, image, last_updated, guid, image_url_hash FROM subscriptions ORDER BY title ASC"))) {
-        logError("load subscriptions", query.lastError());
-        return;
-    }
-
-    QVariantList results;
-    while (query.next()) {
-        QVariantMap entry;
-        entry.insert(QString::fromLatin1("feedId"), query.value(0));
-        entry.insert(QString::fromLatin1("title"), query.value(1));
-        entry.insert(QString::fromLatin1("image"), query.value(2));
-        entry.insert(QString::fromLatin1("lastUpdated"), query.value(3));
-        entry.insert(QString::fromLatin1("guid"), query.value(4));
-        entry.insert(QString::fromLatin1("imageUrlHash"), query.value(5));
-        results.append(entry);
-    }
-
-    setSubscriptions(results);
+    QMetaObject::invokeMethod(m_worker, "loadSubscriptions", Qt::QueuedConnection);
 }
 
 bool StorageManager::isSubscribed(int feedId) const
 {
-    for (int i = 0; i < m_subscriptions.size(); ++i) {
-        const QVariantMap entry = m_subscriptions.at(i).toMap();
-        if (entry.value(QString::fromLatin1("feedId")).toInt() == feedId) {
-            return true;
-        }
+    // Hash lookup on the model's feed ID index.
+    return m_subscriptionModel->contains(feedId);
+}
+
+QVariantList StorageManager::subscribedStates(const QVariantList &feedIds) const
+{
+    QVariantList states;
+    states.reserve(feedIds.size());
+    for (int i = 0; i < feedIds.size(); ++i) {
+        states.append(m_subscriptionModel->contains(feedIds.at(i).toInt()));
     }
-    return false;
+    return states;
 }
 
 void StorageManager::subscribe(int feedId, const QString &title, const QString &image,
-                               const QString &guid, const QString &imageUrlHash)
+                               const QString &guid, const QString &imageUrlHash,
+                               const QString &feedUrl)
 {
     setLastError(QString());
     if (feedId <= 0) {
         setLastError(QString::fromLatin1("Subscribe failed: invalid feed ID (%1)").arg(feedId));
         return;
     }
-    if (!ensureOpen()) {
-        setLastError(QString::fromLatin1("Subscribe failed: database not open"));
-        return;
-    }
 
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("INSERT OR REPLACE INTO subscriptions (feed_id, title, image, last_updated, guid, image_url_hash) "
-                                "VALUES (?, ?, ?, ?, ?, ?)"));
-    query.addBindValue(feedId);
-    query.addBindValue(title);
-    query.addBindValue(image);
-    query.addBindValue(static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
-    query.addBindValue(guid);
-    query.addBindValue(imageUrlHash);
-
-    if (!query.exec()) {
-        logError("subscribe", query.lastError());
-        setLastError(QString::fromLatin1("Subscribe failed: %1").arg(query.lastError().text()));
+    QMetaObject::invokeMethod(m_worker, "subscribe", Qt::QueuedConnection,
+                              Q_ARG(int, feedId),
+                              Q_ARG(QString, title),
+                              Q_ARG(QString, image),
+                              Q_ARG(QString, guid),
+                              Q_ARG(QString, imageUrlHash),
+                              Q_ARG(QString, feedUrl));
+    scheduleCheckpoint();
+}
+
+void StorageManager::importOpml(const QString &path)
+{
+    setLastError(QString());
+    QMetaObject::invokeMethod(m_worker, "importOpml", Qt::QueuedConnection,
+                              Q_ARG(QString, path));
+    scheduleCheckpoint();
+}
+
+void StorageManager::exportOpml(const QString &path)
+{
+    setLastError(QString());
+    QMetaObject::invokeMethod(m_worker, "exportOpml", Qt::QueuedConnection,
+                              Q_ARG(QString, path));
+}
+
+QString StorageManager::defaultOpmlPath() const
+{
+    const QString documents = QDesktopServices::storageLocation(QDesktopServices::DocumentsLocation);
+    return QDir::toNativeSeparators(QDir(documents).filePath(QLatin1String("podin.opml")));
+}
+
+void StorageManager::subscribeAll(const QVariantList &feeds, int failed)
+{
+    if (feeds.isEmpty()) {
+        emit subscriptionsImported(0, 0, failed);
         return;
     }
-
-    refreshSubscriptions();
+    QMetaObject::invokeMethod(m_worker, "subscribeAll", Qt::QueuedConnection,
+                              Q_ARG(QVariantList, feeds), Q_ARG(int, failed));
+    scheduleCheckpoint();
 }
 
 void StorageManager::unsubscribe(int feedId)
@@ -215,46 +361,42 @@ void StorageManager::unsubscribe(int feedId)
         setLastError(QString::fromLatin1("Unsubscribe failed: invalid feed ID (%1)").arg(feedId));
         return;
     }
-    if (!ensureOpen()) {
-        setLastError(QString::fromLatin1("Unsubscribe failed: database not open"));
-        return;
-    }
-
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("DELETE FROM subscriptions WHERE feed_id = ?"));
-    query.addBindValue(feedId);
 
-    if (!query.exec()) {
-        logError("unsubscribe", query.lastError());
-        setLastError(QString::fromLatin1("Unsubscribe failed: %1").arg(query.lastError().text()));
-        return;
-    }
-
-    refreshSubscriptions();
+    QMetaObject::invokeMethod(m_worker, "unsubscribe", Qt::QueuedConnection,
+                              Q_ARG(int, feedId));
+    scheduleCheckpoint();
 }
 
-int StorageManager::loadEpisodePosition(const QString &episodeId) const
+void StorageManager::requestEpisodeState(const QString &episodeId)
 {
     if (episodeId.isEmpty()) {
-        return 0;
+        return;
     }
-    if (!ensureOpen()) {
-        return 0;
+    // Unflushed progress is newer than anything on disk.
+    QHash<QString, PendingProgress>::const_iterator pending = m_pendingProgress.constFind(episodeId);
+    if (pending != m_pendingProgress.constEnd()) {
+        QVariantMap state;
+        state.insert(QString::fromLatin1("positionMs"), pending->positionMs);
+        state.insert(QString::fromLatin1("playState"), pending->playState);
+        state.insert(QString::fromLatin1("durationSeconds"), pending->durationSeconds);
+        emit episodeStateLoaded(episodeId, state);
+        return;
     }
 
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("SELECT played_position_ms FROM episodes WHERE episode_id = ?"));
-    query.addBindValue(episodeId);
-    if (!query.exec()) {
-        logError("load episode position", query.lastError());
-        return 0;
-    }
-    if (query.next()) {
-        return query.value(0).toInt();
+    StorageWorker *worker = !m_progressWritesInFlight.isEmpty() ? m_worker : reader();
+    QMetaObject::invokeMethod(worker, "loadEpisodeState", Qt::QueuedConnection,
+                              Q_ARG(QString, episodeId));
+}
+
+void StorageManager::requestEpisodeStates(const QStringList &episodeIds)
+{
+    if (episodeIds.isEmpty()) {
+        emit episodeStatesLoaded(QVariantMap());
+        return;
     }
-    return 0;
+    StorageWorker *worker = !m_progressWritesInFlight.isEmpty() ? m_worker : reader();
+    QMetaObject::invokeMethod(worker, "loadEpisodeStates", Qt::QueuedConnection,
+                              Q_ARG(QStringList, episodeIds));
 }
 
 void StorageManager::saveEpisodeProgress(const QString &episodeId,
@@ -273,509 +415,459 @@ void StorageManager::saveEpisodeProgress(const QString &episodeId,
 
     // Skip redundant writes — no position or state change since last save.
     const QPair<int,int> current(positionMs, playState);
-    if (m_lastSavedProgress.value(episodeId) == current) {
-        return;
+    if (!m_pendingProgress.contains(episodeId)) {
+        const QPair<int,int> *saved = m_lastSavedProgress.object(episodeId);
+        if (saved && *saved == current) {
+            return;
+        }
     }
 
-    if (!ensureOpen()) {
-        return;
+    PendingProgress progress;
+    progress.feedId = feedId;
+    progress.title = title;
+    progress.audioUrl = audioUrl;
+    progress.durationSeconds = durationSeconds;
+    progress.positionMs = positionMs;
+    progress.lastPlayedAt = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t());
+    progress.enclosureType = enclosureType;
+    progress.publishedAt = publishedAt;
+    progress.playState = playState;
+    m_pendingProgress.insert(episodeId, progress);
+
+    m_playbackActive = playState == 1;
+    if (m_playbackActive) {
+        m_checkpointTimer.stop();
     }
 
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("INSERT OR REPLACE INTO episodes "
-                                "(episode_id, feed_id, title, audio_url, duration_seconds, "
-                                "played_position_ms, last_played_at, enclosure_type, published_at, play_state) "
-                                "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
-    query.addBindValue(episodeId);
-    query.addBindValue(feedId);
-    query.addBindValue(title);
-    query.addBindValue(audioUrl);
-    query.addBindValue(durationSeconds);
-    query.addBindValue(positionMs);
-    query.addBindValue(static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
-    query.addBindValue(enclosureType);
-    query.addBindValue(publishedAt);
-    query.addBindValue(playState);
-
-    if (!query.exec()) {
-        logError("save episode progress", query.lastError());
-    } else {
-        m_lastSavedProgress.insert(episodeId, current);
+    // Pause (2) and stop (0) are the points where the user expects the
+    // position to stick; periodic saves while playing (1) are batched.
+    if (playState != 1) {
+        flushPendingProgress();
+    } else if (!m_progressFlushTimer.isActive()) {
+        m_progressFlushTimer.start();
     }
 }
 
-QVariantMap StorageManager::loadEpisodeState(const QString &episodeId) const
+void StorageManager::flushPendingProgress()
 {
-    QVariantMap state;
-    state.insert(QString::fromLatin1("positionMs"), 0);
-    state.insert(QString::fromLatin1("playState"), 0);
-    if (episodeId.isEmpty()) {
-        return state;
-    }
-    if (!ensureOpen()) {
-        return state;
-    }
-
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("SELECT played_position_ms, play_state FROM episodes WHERE episode_id = ?"));
-    query.addBindValue(episodeId);
-    if (!query.exec()) {
-        logError("load episode state", query.lastError());
-        return state;
-    }
-    if (query.next()) {
-        state.insert(QString::fromLatin1("positionMs"), query.value(0).toInt());
-        state.insert(QString::fromLatin1("playState"), query.value(1).toInt());
-    }
-    return state;
-}
-
-QString StorageManager::dbPath()
-{
-    QString base;
-    m_dbPathLog.clear();
-#ifdef Q_OS_SYMBIAN
-    // Try multiple locations on Symbian
-    // For self-signed apps, only the private directory is writable
-    QStringList candidates;
-
-    // 1. App's private directory from QDesktopServices (works for self-signed)
-    QString dataPath = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
-    if (!dataPath.isEmpty()) {
-        candidates << dataPath;
-    }
-    m_dbPathLog += QString::fromLatin1("DataLocation: %1\n").arg(dataPath.isEmpty() ? QLatin1String("(empty)") : dataPath);
-
-    // 2. Try app's private directory using QCoreApplication path
-    QString appPrivate = QCoreApplication::applicationDirPath();
-    if (!appPrivate.isEmpty() && !candidates.contains(appPrivate)) {
-        candidates << appPrivate;
-    }
-    m_dbPathLog += QString::fromLatin1("AppDirPath: %1\n").arg(appPrivate.isEmpty() ? QLatin1String("(empty)") : appPrivate);
-
-    // 3. Try C:\Data\Podin (requires WriteUserData capability - won't work self-signed)
-    candidates << QLatin1String(AppConfig::kPhoneBase);
-
-    // 4. Try E:\Podin (memory card - might work)
-    candidates << QLatin1String(AppConfig::kMemoryCardBase);
-
-    // 5. Try temp location as last resort
-    QString tempPath = QDir::tempPath();
-    if (!tempPath.isEmpty() && !candidates.contains(tempPath)) {
-        candidates << tempPath;
-    }
-    m_dbPathLog += QString::fromLatin1("TempPath: %1\n").arg(tempPath.isEmpty() ? QLatin1String("(empty)") : tempPath);
-    m_dbPathLog += QString::fromLatin1("Candidates: %1\n").arg(candidates.join(QLatin1String(", ")));
-    
-    // Determine which driver will actually be used
-    QString testDriver = QLatin1String("QSQLITE");
-    if (QSqlDatabase::isDriverAvailable(QLatin1String("QSYMSQL"))) {
-        testDriver = QLatin1String("QSYMSQL");
-    }
-    m_dbPathLog += QString::fromLatin1("TestDriver: %1\n").arg(testDriver);
-
-    // Try each candidate - test with actual SQLite open
-    for (int i = 0; i < candidates.size(); ++i) {
-        QString candidatePath = candidates.at(i);
-        QDir dir(candidatePath);
-
-        // On Symbian, paths under /private/ are data-caged:
-        // QDir::exists() returns false even though the directory exists,
-        // and mkpath() fails because the /private/ parent is system-owned.
-        // Skip the exists/mkdir check for these paths and go straight to
-        // the SQLite write test.
-        bool isPrivatePath = candidatePath.contains(QLatin1String("/private/"),
-                                                     Qt::CaseInsensitive);
-        if (!isPrivatePath) {
-            if (!dir.exists()) {
-                if (!dir.mkpath(QLatin1String("."))) {
-                    m_dbPathLog += QString::fromLatin1("mkdir FAIL: %1\n").arg(candidatePath);
-                    qDebug() << "StorageManager: mkdir failed for" << candidatePath;
-                    continue;
-                }
-                m_dbPathLog += QString::fromLatin1("mkdir OK: %1\n").arg(candidatePath);
-            } else {
-                m_dbPathLog += QString::fromLatin1("exists: %1\n").arg(candidatePath);
-            }
-        } else {
-            m_dbPathLog += QString::fromLatin1("private (skip mkdir): %1\n").arg(candidatePath);
-        }
-
-        // Test by actually opening SQLite database with the same driver
-        // that initDb() will use
-        QString testDbPath = QDir::toNativeSeparators(
-            dir.filePath(QLatin1String("test.db")));
-        if (QSqlDatabase::contains(QLatin1String("path_test"))) {
-            QSqlDatabase::removeDatabase(QLatin1String("path_test"));
-        }
+    m_progressFlushTimer.stop();
+    if (m_pendingProgress.isEmpty()) {
+        return;
+    }
 
-        QSqlDatabase testDb = QSqlDatabase::addDatabase(testDriver, QLatin1String("path_test"));
-        testDb.setDatabaseName(testDbPath);
-        if (testDb.open()) {
-            QSqlQuery q(testDb);
-            if (q.exec(QLatin1String("CREATE TABLE IF NOT EXISTS test(id INTEGER)"))) {
-                testDb.close();
-                QSqlDatabase::removeDatabase(QLatin1String("path_test"));
-                QFile::remove(testDbPath);
-                base = candidatePath;
-                m_dbPathLog += QString::fromLatin1("SQLite OK: %1\n").arg(candidatePath);
-                qDebug() << "StorageManager: Using db path:" << base;
-                break;
-            }
-            m_dbPathLog += QString::fromLatin1("SQLite CREATE FAIL: %1\n").arg(candidatePath);
-        } else {
-            m_dbPathLog += QString::fromLatin1("SQLite open FAIL: %1 - %2\n").arg(candidatePath, testDb.lastError().text());
-        }
-        testDb.close();
-        QSqlDatabase::removeDatabase(QLatin1String("path_test"));
-        QFile::remove(testDbPath);
-        qDebug() << "StorageManager: SQLite test failed for" << candidatePath;
-    }
-
-    // Last resort: in-memory database (data won't persist)
-    if (base.isEmpty()) {
-        qWarning() << "StorageManager: No writable path found, using in-memory database";
-        m_dbPathLog += QLatin1String("FALLBACK: in-memory\n");
-        m_dbPath = QLatin1String(":memory:");
-        return m_dbPath;
-    }
-#else
-    base = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
-    m_dbPathLog += QString::fromLatin1("DataLocation: %1\n").arg(base.isEmpty() ? QLatin1String("(empty)") : base);
-    if (base.isEmpty()) {
-        base = QDir::homePath() + QLatin1String("/.podin");
-        m_dbPathLog += QString::fromLatin1("Using home fallback: %1\n").arg(base);
-    }
-#endif
-    QDir dir(base);
-    bool baseIsPrivate = base.contains(QLatin1String("/private/"), Qt::CaseInsensitive);
-    if (!baseIsPrivate && !dir.exists()) {
-        if (dir.mkpath(QLatin1String("."))) {
-            m_dbPathLog += QString::fromLatin1("Created dir: %1\n").arg(base);
-        } else {
-            m_dbPathLog += QString::fromLatin1("mkdir FAIL: %1\n").arg(base);
-        }
+    QVariantList entries;
+    entries.reserve(m_pendingProgress.size());
+    QHash<QString, PendingProgress>::const_iterator it = m_pendingProgress.constBegin();
+    for (; it != m_pendingProgress.constEnd(); ++it) {
+        const PendingProgress &progress = it.value();
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("episodeId"), it.key());
+        entry.insert(QString::fromLatin1("feedId"), progress.feedId);
+        entry.insert(QString::fromLatin1("title"), progress.title);
+        entry.insert(QString::fromLatin1("audioUrl"), progress.audioUrl);
+        entry.insert(QString::fromLatin1("durationSeconds"), progress.durationSeconds);
+        entry.insert(QString::fromLatin1("positionMs"), progress.positionMs);
+        entry.insert(QString::fromLatin1("lastPlayedAt"), progress.lastPlayedAt);
+        entry.insert(QString::fromLatin1("enclosureType"), progress.enclosureType);
+        entry.insert(QString::fromLatin1("publishedAt"), progress.publishedAt);
+        entry.insert(QString::fromLatin1("playState"), progress.playState);
+        entries.append(entry);
+        m_lastSavedProgress.insert(it.key(), new QPair<int,int>(progress.positionMs, progress.playState));
+    }
+    m_pendingProgress.clear();
+
+    m_progressWritesInFlight.append(entries);
+    QMetaObject::invokeMethod(m_worker, "saveProgress", Qt::QueuedConnection,
+                              Q_ARG(QVariantList, entries));
+    scheduleCheckpoint();
+    // The history models pick the entries up in onProgressSaved(), once the
+    // rows are committed and visible to the read connection.
+}
+
+void StorageManager::requestCachedEpisodes(int feedId)
+{
+    if (feedId <= 0) {
+        return;
     }
-    m_dbPath = QDir::toNativeSeparators(dir.filePath(QLatin1String("podin.db")));
-    return m_dbPath;
+    QMetaObject::invokeMethod(reader(), "loadCachedEpisodes", Qt::QueuedConnection,
+                              Q_ARG(int, feedId));
 }
 
-bool StorageManager::ensureOpen() const
+void StorageManager::cacheEpisodes(int feedId, const QVariantList &episodes)
 {
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName), false);
-    if (db.isValid() && db.isOpen()) {
-        return true;
+    if (feedId <= 0) {
+        return;
     }
+    QMetaObject::invokeMethod(m_worker, "saveCachedEpisodes", Qt::QueuedConnection,
+                              Q_ARG(int, feedId),
+                              Q_ARG(QVariantList, episodes));
+    scheduleCheckpoint();
+}
 
-    if (!db.isValid()) {
-        return false;
+QVariant StorageManager::setting(const QString &key, const QVariant &defaultValue) const
+{
+    return m_settings.value(key, defaultValue);
+}
+
+void StorageManager::setSetting(const QString &key, const QVariant &value)
+{
+    if (key.isEmpty()) {
+        return;
     }
-    if (!db.open()) {
-        logError("open db", db.lastError());
-        return false;
+    // Known keys go through their typed setters for bounds and notifications.
+    if (key == QLatin1String(kForwardSkipKey)) {
+        setForwardSkipSeconds(value.toInt());
+    } else if (key == QLatin1String(kBackwardSkipKey)) {
+        setBackwardSkipSeconds(value.toInt());
+    } else if (key == QLatin1String(kArtworkLoadingKey)) {
+        setEnableArtworkLoading(value.toBool());
+    } else if (key == QLatin1String(kVolumePercentKey)) {
+        setVolumePercent(value.toInt());
+    } else if (key == QLatin1String(kSleepTimerKey)) {
+        setSleepTimerMinutes(value.toInt());
+    } else if (m_settings.value(key) != value) {
+        saveSetting(key, value);
+        emit settingChanged(key);
     }
-    return true;
 }
 
-void StorageManager::initDb()
+void StorageManager::saveSetting(const QString &key, const QVariant &value)
 {
-    QStringList drivers = QSqlDatabase::drivers();
-    qDebug() << "StorageManager: Available SQL drivers:" << drivers;
-    m_dbPathLog += QString::fromLatin1("Drivers: %1\n").arg(drivers.join(QLatin1String(", ")));
+    m_settings.insert(key, value);
+    m_dirtySettings.insert(key, value);
+    if (!m_settingsFlushTimer.isActive()) {
+        m_settingsFlushTimer.start();
+    }
+}
 
-    if (QSqlDatabase::contains(QLatin1String(kConnectionName))) {
-        m_dbStatus = QLatin1String("already exists");
+void StorageManager::flushSettings()
+{
+    m_settingsFlushTimer.stop();
+    if (m_dirtySettings.isEmpty()) {
         return;
     }
+    QMetaObject::invokeMethod(m_worker, "saveSettings", Qt::QueuedConnection,
+                              Q_ARG(QVariantMap, m_dirtySettings));
+    m_dirtySettings.clear();
+    scheduleCheckpoint();
+}
 
-    QString path = dbPath();
-    qDebug() << "StorageManager: Opening database at:" << path;
-
-    // On Symbian, prefer QSYMSQL (native Symbian SQL) over QSQLITE if available
-    QString driverName;
-#ifdef Q_OS_SYMBIAN
-    if (QSqlDatabase::isDriverAvailable(QLatin1String("QSYMSQL"))) {
-        driverName = QLatin1String("QSYMSQL");
-        qDebug() << "StorageManager: Using QSYMSQL driver";
-    } else
-#endif
-    if (QSqlDatabase::isDriverAvailable(QLatin1String("QSQLITE"))) {
-        driverName = QLatin1String("QSQLITE");
-        qDebug() << "StorageManager: Using QSQLITE driver";
-    } else {
-        m_dbStatus = QString::fromLatin1("no driver available: %1").arg(drivers.join(QLatin1String(", ")));
-        qWarning("Storage error (init db): No SQLite driver available. Drivers: %s",
-                 qPrintable(drivers.join(QLatin1String(", "))));
+QString StorageManager::lastError() const
+{
+    return m_lastError;
+}
+
+void StorageManager::setLastError(const QString &error)
+{
+    if (m_lastError == error) {
         return;
     }
-    m_dbPathLog += QString::fromLatin1("Using driver: %1\n").arg(driverName);
+    m_lastError = error;
+    emit lastErrorChanged();
+}
 
-    QSqlDatabase db = QSqlDatabase::addDatabase(driverName, QLatin1String(kConnectionName));
-    db.setDatabaseName(path);
+void StorageManager::addSearchHistory(const QString &term)
+{
+    QString trimmed = term.trimmed();
+    if (trimmed.isEmpty()) {
+        return;
+    }
+    if (m_searchHistory.termAt(0) == trimmed) {
+        // Same search again: nothing visible changes, skip the rewrite.
+        return;
+    }
+    m_searchHistory.add(trimmed, static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
+    m_searchHistoryDirty = true;
+    m_searchHistoryFlushTimer.start();
+    emit searchHistoryChanged();
+}
 
-    if (!db.open()) {
-        m_dbStatus = QString::fromLatin1("open failed: %1").arg(db.lastError().text());
-        qWarning("Storage error (init db): Failed to open database at %s - %s",
-                 qPrintable(path),
-                 qPrintable(db.lastError().text()));
+void StorageManager::removeSearchHistory(const QString &term)
+{
+    if (term.isEmpty() || !m_searchHistory.remove(term)) {
         return;
     }
+    m_searchHistoryDirty = true;
+    m_searchHistoryFlushTimer.start();
+    emit searchHistoryChanged();
+}
 
-    m_dbStatus = QLatin1String("open");
-    qDebug() << "StorageManager: Database opened successfully";
+void StorageManager::refreshSearchHistory()
+{
+    // The in-memory ring is authoritative once loaded; just re-notify.
+    emit searchHistoryChanged();
+}
 
-    // Use WAL journal mode for non-blocking writes (avoids fsync stalls during playback)
-    QSqlQuery journalQuery(db);
-    if (!journalQuery.exec(QLatin1String("PRAGMA journal_mode=WAL"))) {
-        qDebug() << "StorageManager: Could not set journal_mode";
-    }
+QStringList StorageManager::searchSuggestions(const QString &prefix, int limit) const
+{
+    return m_searchHistory.suggestions(prefix, limit);
+}
 
-    QSqlQuery query(db);
-    if (!query.exec(QLatin1String("CREATE TABLE IF NOT EXISTS subscriptions ("
-                                  "feed_id INTEGER PRIMARY KEY, "
-                                  "title TEXT NOT NULL, "
-                                  "image TEXT, "
-                                  "last_updated INTEGER, "
-                                  "guid TEXT, "
-                                  "image_url_hash TEXT)"))) {
-        logError("create subscriptions table", query.lastError());
+void StorageManager::flushSearchHistory()
+{
+    m_searchHistoryFlushTimer.stop();
+    if (!m_searchHistoryDirty) {
+        return;
     }
+    QMetaObject::invokeMethod(m_worker, "saveSearchHistory", Qt::QueuedConnection,
+                              Q_ARG(QVariantList, m_searchHistory.toVariantList()));
+    m_searchHistoryDirty = false;
+    scheduleCheckpoint();
+}
 
-    // Migration: add guid and image_url_hash columns if missing
-    query.exec(QLatin1String("ALTER TABLE subscriptions ADD COLUMN guid TEXT"));
-    query.exec(QLatin1String("ALTER TABLE subscriptions ADD COLUMN image_url_hash TEXT"));
+void StorageManager::searchLocal(const QString &term)
+{
+    QMetaObject::invokeMethod(reader(), "searchLocal", Qt::QueuedConnection,
+                              Q_ARG(QString, term));
+}
 
-    if (!query.exec(QLatin1String("CREATE TABLE IF NOT EXISTS episodes ("
-                                  "episode_id TEXT PRIMARY KEY, "
-                                  "feed_id INTEGER NOT NULL, "
-                                  "title TEXT NOT NULL, "
-                                  "audio_url TEXT NOT NULL, "
-                                  "duration_seconds INTEGER, "
-                                  "played_position_ms INTEGER DEFAULT 0, "
-                                  "last_played_at INTEGER, "
-                                  "published_at INTEGER, "
-                                  "enclosure_type TEXT, "
-                                  "play_state INTEGER DEFAULT 0, "
-                                  "image TEXT, "
-                                  "FOREIGN KEY(feed_id) REFERENCES subscriptions(feed_id))"))) {
-        logError("create episodes table", query.lastError());
+void StorageManager::dumpStatementStats()
+{
+    if (m_statementDumpsPending > 0) {
+        return;
     }
-
-    if (!query.exec(QLatin1String("CREATE TABLE IF NOT EXISTS settings ("
-                                  "key TEXT PRIMARY KEY, "
-                                  "value INTEGER)"))) {
-        logError("create settings table", query.lastError());
+    m_statementDump.clear();
+    m_statementDumpsPending = m_readerReady ? 2 : 1;
+    QMetaObject::invokeMethod(m_worker, "dumpStatementStats", Qt::QueuedConnection);
+    if (m_readerReady) {
+        QMetaObject::invokeMethod(m_reader, "dumpStatementStats", Qt::QueuedConnection);
     }
+}
 
-    if (!query.exec(QLatin1String("CREATE TABLE IF NOT EXISTS search_history ("
-                                  "term TEXT PRIMARY KEY COLLATE NOCASE, "
-                                  "searched_at INTEGER)"))) {
-        logError("create search_history table", query.lastError());
-    }
+void StorageManager::clearLastError()
+{
+    setLastError(QString());
+}
 
-    if (!query.exec(QLatin1String("INSERT OR IGNORE INTO settings (key, value) "
-                                  "VALUES ('forward_skip_seconds', 30)"))) {
-        logError("seed forward skip setting", query.lastError());
-    }
+QString StorageManager::dbPathForQml() const
+{
+    return m_dbPath;
+}
 
-    if (!query.exec(QLatin1String("INSERT OR IGNORE INTO settings (key, value) "
-                                  "VALUES ('backward_skip_seconds', 15)"))) {
-        logError("seed backward skip setting", query.lastError());
-    }
-    if (!query.exec(QLatin1String("INSERT OR IGNORE INTO settings (key, value) "
-                                  "VALUES ('enable_artwork_loading', 0)"))) {
-        logError("seed artwork loading setting", query.lastError());
-    }
-    if (!query.exec(QLatin1String("INSERT OR IGNORE INTO settings (key, value) "
-                                  "VALUES ('volume_percent', 50)"))) {
-        logError("seed volume percent setting", query.lastError());
-    }
+QString StorageManager::dbStatus() const
+{
+    return m_dbStatus;
+}
 
-    QSqlQuery pragma(db);
-    bool havePlayState = false;
-    if (pragma.exec(QLatin1String("PRAGMA table_info(episodes)"))) {
-        while (pragma.next()) {
-            if (pragma.value(1).toString() == QLatin1String("play_state")) {
-                havePlayState = true;
-                break;
-            }
-        }
-    }
-    if (!havePlayState) {
-        QSqlQuery alter(db);
-        if (!alter.exec(QLatin1String("ALTER TABLE episodes ADD COLUMN play_state INTEGER DEFAULT 0"))) {
-            logError("alter episodes add play_state", alter.lastError());
-        }
-    }
+QString StorageManager::dbPathLog() const
+{
+    return m_dbPathLog;
+}
 
-    if (!query.exec(QLatin1String("CREATE INDEX IF NOT EXISTS idx_episodes_feed_id ON episodes(feed_id)"))) {
-        logError("create idx_episodes_feed_id", query.lastError());
+void StorageManager::onOpened(const QString &dbPath, const QString &dbStatus, const QString &dbPathLog)
+{
+    m_dbPath = dbPath;
+    m_dbStatus = dbStatus;
+    m_dbPathLog = dbPathLog;
+    emit dbStatusChanged();
+    // Fold in anything a previous session left in the WAL.
+    scheduleCheckpoint();
+    m_maintenanceTimer.start(kMaintenanceDelayMs);
+    // The schema is current now. A second connection to an in-memory
+    // database would see a different, empty one.
+    if (dbStatus == QLatin1String("open") && dbPath != QLatin1String(":memory:")) {
+        QMetaObject::invokeMethod(m_reader, "openReadOnly", Qt::QueuedConnection,
+                                  Q_ARG(QString, dbPath));
     }
+}
 
-    if (!query.exec(QLatin1String("CREATE INDEX IF NOT EXISTS idx_episodes_last_played ON episodes(last_played_at)"))) {
-        logError("create idx_episodes_last_played", query.lastError());
+void StorageManager::onReaderOpened(bool ok)
+{
+    m_readerReady = ok;
+    if (!ok) {
+        qWarning("Storage error (open read connection): reads stay on the writer");
     }
 }
 
-void StorageManager::loadSettings()
+void StorageManager::onProgressSaved()
 {
-    if (!ensureOpen()) {
+    if (m_progressWritesInFlight.isEmpty()) {
         return;
     }
-    m_forwardSkipSeconds = readSetting(QString::fromLatin1("forward_skip_seconds"), 30);
-    m_backwardSkipSeconds = readSetting(QString::fromLatin1("backward_skip_seconds"), 15);
-    m_enableArtworkLoading = readSetting(QString::fromLatin1("enable_artwork_loading"), 1) != 0;
-    m_volumePercent = qBound(0, readSetting(QString::fromLatin1("volume_percent"), 50), 100);
-    m_sleepTimerMinutes = readSetting(QString::fromLatin1("sleep_timer_minutes"), 0);
+    // The writer acknowledges batches in the order they were queued. Models
+    // nobody has looked at yet stay empty.
+    const QVariantList entries = m_progressWritesInFlight.takeFirst();
+    m_recentEpisodes->applyProgress(entries);
+    m_inProgressEpisodes->applyProgress(entries);
 }
 
-void StorageManager::saveSetting(const QString &key, int value)
+void StorageManager::onStatementStatsDumped(const QVariantList &stats)
 {
-    if (!ensureOpen()) {
+    if (m_statementDumpsPending <= 0) {
         return;
     }
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("INSERT OR REPLACE INTO settings (key, value) VALUES (?, ?)"));
-    query.addBindValue(key);
-    query.addBindValue(value);
-    if (!query.exec()) {
-        logError("save setting", query.lastError());
+    m_statementDump += stats;
+    if (--m_statementDumpsPending > 0) {
+        return;
     }
+    qSort(m_statementDump.begin(), m_statementDump.end(), largerTotalFirst);
+    const QVariantList merged = m_statementDump;
+    m_statementDump.clear();
+    emit statementStatsDumped(merged);
 }
 
-int StorageManager::readSetting(const QString &key, int defaultValue) const
+void StorageManager::onSettingsLoaded(const QVariantMap &settings)
 {
-    if (!ensureOpen()) {
-        return defaultValue;
+    // Anything changed before the load finished wins over the stored value.
+    m_settings = settings;
+    QVariantMap::const_iterator dirty = m_dirtySettings.constBegin();
+    for (; dirty != m_dirtySettings.constEnd(); ++dirty) {
+        m_settings.insert(dirty.key(), dirty.value());
+    }
+
+    const int forward = m_settings.value(QLatin1String(kForwardSkipKey), 30).toInt();
+    if (forward != m_forwardSkipSeconds) {
+        m_forwardSkipSeconds = forward;
+        emit forwardSkipSecondsChanged();
     }
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("SELECT value FROM settings WHERE key = ?"));
-    query.addBindValue(key);
-    if (!query.exec()) {
-        logError("load setting", query.lastError());
-        return defaultValue;
+    const int backward = m_settings.value(QLatin1String(kBackwardSkipKey), 15).toInt();
+    if (backward != m_backwardSkipSeconds) {
+        m_backwardSkipSeconds = backward;
+        emit backwardSkipSecondsChanged();
     }
-    if (query.next()) {
-        return query.value(0).toInt();
+    const bool artwork = m_settings.value(QLatin1String(kArtworkLoadingKey), 1).toInt() != 0;
+    if (artwork != m_enableArtworkLoading) {
+        m_enableArtworkLoading = artwork;
+        emit enableArtworkLoadingChanged();
+    }
+    const int volume = qBound(0, m_settings.value(QLatin1String(kVolumePercentKey), 50).toInt(), 100);
+    if (volume != m_volumePercent) {
+        m_volumePercent = volume;
+        emit volumePercentChanged();
+    }
+    const int sleepMinutes = m_settings.value(QLatin1String(kSleepTimerKey), 0).toInt();
+    if (sleepMinutes != m_sleepTimerMinutes) {
+        m_sleepTimerMinutes = sleepMinutes;
+        emit sleepTimerMinutesChanged();
     }
-    return defaultValue;
 }
 
-void StorageManager::setSubscriptions(const QVariantList &list)
+void StorageManager::onSubscriptionsLoaded(const QVariantList &subscriptions)
 {
-    m_subscriptions = list;
+    m_subscriptionModel->setSubscriptions(subscriptions);
     emit subscriptionsChanged();
 }
 
-QString StorageManager::lastError() const
+void StorageManager::onSubscriptionSaved(const QVariantMap &subscription)
 {
-    return m_lastError;
+    m_subscriptionModel->insertOrUpdate(subscription);
+    emit subscriptionsChanged();
 }
 
-void StorageManager::setLastError(const QString &error)
+void StorageManager::onSubscriptionRemoved(int feedId)
 {
-    if (m_lastError == error) {
-        return;
-    }
-    m_lastError = error;
-    emit lastErrorChanged();
+    m_subscriptionModel->remove(feedId);
+    emit subscriptionsChanged();
 }
 
-void StorageManager::addSearchHistory(const QString &term)
+void StorageManager::onEpisodeStatesLoaded(const QStringList &episodeIds, const QVariantMap &episodeStates)
 {
-    QString trimmed = term.trimmed();
-    if (trimmed.isEmpty()) {
-        return;
-    }
-    if (!ensureOpen()) {
-        return;
-    }
-
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("INSERT OR REPLACE INTO search_history (term, searched_at) VALUES (?, ?)"));
-    query.addBindValue(trimmed);
-    query.addBindValue(static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
-    if (!query.exec()) {
-        logError("add search history", query.lastError());
-        return;
+    // Overlay progress that is still waiting in the journal.
+    QVariantMap states = episodeStates;
+    if (!m_pendingProgress.isEmpty()) {
+        for (int i = 0; i < episodeIds.size(); ++i) {
+            QHash<QString, PendingProgress>::const_iterator pending = m_pendingProgress.constFind(episodeIds.at(i));
+            if (pending == m_pendingProgress.constEnd()) {
+                continue;
+            }
+            QVariantMap state;
+            state.insert(QString::fromLatin1("positionMs"), pending->positionMs);
+            state.insert(QString::fromLatin1("playState"), pending->playState);
+            state.insert(QString::fromLatin1("durationSeconds"), pending->durationSeconds);
+            states.insert(pending.key(), state);
+        }
     }
+    emit episodeStatesLoaded(states);
+}
 
-    // Prune to newest 20 entries
-    QSqlQuery prune(db);
-    if (!prune.exec(QLatin1String("DELETE FROM search_history WHERE rowid NOT IN "
-                                  "(SELECT rowid FROM search_history ORDER BY searched_at DESC LIMIT 20)"))) {
-        logError("prune search history", prune.lastError());
+void StorageManager::onSearchHistoryLoaded(const QVariantList &history)
+{
+    if (!m_searchHistoryDirty) {
+        m_searchHistory.setEntries(history);
+    } else {
+        // Searches made before the initial load finished win over the
+        // stored rows; replay them on top, oldest first.
+        const QVariantList pending = m_searchHistory.toVariantList();
+        m_searchHistory.setEntries(history);
+        for (int i = pending.size() - 1; i >= 0; --i) {
+            const QVariantMap entry = pending.at(i).toMap();
+            m_searchHistory.add(entry.value(QString::fromLatin1("term")).toString(),
+                                entry.value(QString::fromLatin1("searchedAt")).toInt());
+        }
     }
-
-    refreshSearchHistory();
+    emit searchHistoryChanged();
 }
 
-void StorageManager::removeSearchHistory(const QString &term)
+void StorageManager::scheduleCheckpoint()
 {
-    if (term.isEmpty()) {
-        return;
-    }
-    if (!ensureOpen()) {
-        return;
+    // Automatic checkpoints are disabled on the connection; while playing
+    // the WAL just grows and is folded in at the next pause or stop.
+    if (!m_playbackActive) {
+        m_checkpointTimer.start();
     }
+}
 
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    query.prepare(QLatin1String("DELETE FROM search_history WHERE term = ?"));
-    query.addBindValue(term);
-    if (!query.exec()) {
-        logError("remove search history", query.lastError());
+void StorageManager::onCheckpointTimeout()
+{
+    if (m_playbackActive) {
         return;
     }
-
-    refreshSearchHistory();
+    QMetaObject::invokeMethod(m_worker, "checkpoint", Qt::QueuedConnection);
 }
 
-void StorageManager::refreshSearchHistory()
+void StorageManager::onMaintenanceTimeout()
 {
-    if (!ensureOpen()) {
+    // Never compete with playback for the storage thread or the disk.
+    if (m_playbackActive) {
+        m_maintenanceTimer.start(kMaintenanceDelayMs);
         return;
     }
-
-    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
-    QSqlQuery query(db);
-    if (!query.exec(QLatin1String("SELECT term FROM search_history ORDER BY searched_at DESC"))) {
-        logError("load search history", query.lastError());
+    if (!m_maintenancePruned) {
+        QMetaObject::invokeMethod(m_worker, "pruneStep", Qt::QueuedConnection);
         return;
     }
+    QMetaObject::invokeMethod(m_worker, "vacuumStep", Qt::QueuedConnection);
+}
 
-    QVariantList results;
-    while (query.next()) {
-        QVariantMap entry;
-        entry.insert(QString::fromLatin1("term"), query.value(0));
-        results.append(entry);
+void StorageManager::onPruneStepFinished(bool morePending)
+{
+    // Vacuum steps follow once every stale row is gone; the gap lets
+    // queued writes and reads run between steps.
+    if (!morePending) {
+        m_maintenancePruned = true;
     }
-
-    m_searchHistory = results;
-    emit searchHistoryChanged();
+    m_maintenanceTimer.start(kVacuumStepIntervalMs);
 }
 
-void StorageManager::clearLastError()
+void StorageManager::onVacuumStepFinished(bool morePending)
 {
-    setLastError(QString());
+    if (morePending) {
+        m_maintenanceTimer.start(kVacuumStepIntervalMs);
+    } else {
+        scheduleCheckpoint();
+    }
 }
 
-QString StorageManager::dbPathForQml() const
+void StorageManager::onSubscriptionsImported(int added, const QVariantList &unresolved, int failed)
 {
-    return m_dbPath;
+    emit subscriptionsImported(added, unresolved.size(), failed);
+    if (!unresolved.isEmpty()) {
+        emit feedsNeedResolving(unresolved);
+    }
 }
 
-QString StorageManager::dbStatus() const
+void StorageManager::onRecentPageRequested(int token, int beforePlayedAt, const QString &beforeEpisodeId,
+                                           int limit, bool inProgressOnly)
 {
-    return m_dbStatus;
+    QMetaObject::invokeMethod(reader(), "loadRecentEpisodes", Qt::QueuedConnection,
+                              Q_ARG(int, token),
+                              Q_ARG(int, beforePlayedAt),
+                              Q_ARG(QString, beforeEpisodeId),
+                              Q_ARG(int, limit),
+                              Q_ARG(bool, inProgressOnly));
 }
 
-QString StorageManager::dbPathLog() const
+void StorageManager::onOperationFailed(const QString &message)
 {
-    return m_dbPathLog;
+    setLastError(message);
 }
@@ -2,15 +2,31 @@
 #define STORAGEMANAGER_H
 
 #include <QtCore/QObject>
+#include <QtCore/QCache>
 #include <QtCore/QHash>
 #include <QtCore/QPair>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
 #include <QtCore/QVariantList>
 #include <QtCore/QVariantMap>
 
+#include "SearchHistory.h"
+
+class StorageWorker;
+class RecentEpisodesModel;
+class SubscriptionListModel;
+
+// QML-facing storage API. All SQLite work runs on two StorageWorkers, a
+// writer and a reader, each in a dedicated thread; calls here only queue
+// requests and update in-memory state, so the GUI thread never waits on disk.
 class StorageManager : public QObject
 {
     Q_OBJECT
     Q_PROPERTY(QVariantList subscriptions READ subscriptions NOTIFY subscriptionsChanged)
+    Q_PROPERTY(QObject *subscriptionModel READ subscriptionModel CONSTANT)
+    Q_PROPERTY(QObject *recentEpisodes READ recentEpisodes CONSTANT)
+    Q_PROPERTY(QObject *inProgressEpisodes READ inProgressEpisodes CONSTANT)
     Q_PROPERTY(int forwardSkipSeconds READ forwardSkipSeconds WRITE setForwardSkipSeconds NOTIFY forwardSkipSecondsChanged)
     Q_PROPERTY(int backwardSkipSeconds READ backwardSkipSeconds WRITE setBackwardSkipSeconds NOTIFY backwardSkipSecondsChanged)
     Q_PROPERTY(bool enableArtworkLoading READ enableArtworkLoading WRITE setEnableArtworkLoading NOTIFY enableArtworkLoadingChanged)
@@ -18,14 +34,21 @@ class StorageManager : public QObject
     Q_PROPERTY(int sleepTimerMinutes READ sleepTimerMinutes WRITE setSleepTimerMinutes NOTIFY sleepTimerMinutesChanged)
     Q_PROPERTY(QVariantList searchHistory READ searchHistory NOTIFY searchHistoryChanged)
     Q_PROPERTY(QString lastError READ lastError NOTIFY lastErrorChanged)
-    Q_PROPERTY(QString dbPath READ dbPathForQml CONSTANT)
-    Q_PROPERTY(QString dbStatus READ dbStatus CONSTANT)
-    Q_PROPERTY(QString dbPathLog READ dbPathLog CONSTANT)
+    Q_PROPERTY(QString dbPath READ dbPathForQml NOTIFY dbStatusChanged)
+    Q_PROPERTY(QString dbStatus READ dbStatus NOTIFY dbStatusChanged)
+    Q_PROPERTY(QString dbPathLog READ dbPathLog NOTIFY dbStatusChanged)
 
 public:
     explicit StorageManager(QObject *parent = 0);
+    ~StorageManager();
 
+    // Built on demand from the model; prefer subscriptionModel in views.
     QVariantList subscriptions() const;
+    QObject *subscriptionModel() const;
+    // Lazily paged history models: everything played, and only episodes
+    // with a resume position ("continue listening").
+    QObject *recentEpisodes() const;
+    QObject *inProgressEpisodes() const;
     QVariantList searchHistory() const;
     int forwardSkipSeconds() const;
     int backwardSkipSeconds() const;
@@ -43,14 +66,32 @@ public:
     void setVolumePercent(int percent);
     void setSleepTimerMinutes(int minutes);
 
+    // Episodes remembered for progress dedup; only the current one and a
+    // few recently played matter, older entries are evicted LRU-first.
+    static const int LastSavedProgressCapacity = 16;
+
     Q_INVOKABLE void refreshSubscriptions();
     Q_INVOKABLE bool isSubscribed(int feedId) const;
+    // One bool per feed ID, in the same order; for list pages.
+    Q_INVOKABLE QVariantList subscribedStates(const QVariantList &feedIds) const;
     Q_INVOKABLE void subscribe(int feedId, const QString &title, const QString &image,
-                               const QString &guid = QString(), const QString &imageUrlHash = QString());
+                               const QString &guid = QString(), const QString &imageUrlHash = QString(),
+                               const QString &feedUrl = QString());
     Q_INVOKABLE void unsubscribe(int feedId);
 
-    Q_INVOKABLE int loadEpisodePosition(const QString &episodeId) const;
-    Q_INVOKABLE QVariantMap loadEpisodeState(const QString &episodeId) const;
+    // OPML import/export run on the storage thread. Import adds every feed
+    // with a Podcast Index ID in one transaction; the rest are announced via
+    // feedsNeedResolving() and come back through subscribeAll().
+    Q_INVOKABLE void importOpml(const QString &path);
+    Q_INVOKABLE void exportOpml(const QString &path);
+    Q_INVOKABLE QString defaultOpmlPath() const;
+
+    // Result is delivered through episodeStateLoaded().
+    Q_INVOKABLE void requestEpisodeState(const QString &episodeId);
+    // States for a whole list in one query; delivered through
+    // episodeStatesLoaded() as episodeId -> {positionMs, playState,
+    // durationSeconds}. IDs without a stored row are left out.
+    Q_INVOKABLE void requestEpisodeStates(const QStringList &episodeIds);
     Q_INVOKABLE void saveEpisodeProgress(const QString &episodeId,
                                          int feedId,
                                          const QString &title,
@@ -61,12 +102,47 @@ public:
                                          int publishedAt,
                                          int playState);
 
+    // Search history lives in memory; changes are written behind.
     Q_INVOKABLE void addSearchHistory(const QString &term);
     Q_INVOKABLE void removeSearchHistory(const QString &term);
     Q_INVOKABLE void refreshSearchHistory();
+    // Previous searches starting with prefix, newest first; no SQLite access.
+    Q_INVOKABLE QStringList searchSuggestions(const QString &prefix, int limit = 5) const;
+
+    // Searches subscriptions and cached episodes on the device; the answer
+    // arrives via localSearchFinished() with the same term, usually long
+    // before the network search does.
+    Q_INVOKABLE void searchLocal(const QString &term);
+
+    // Writes per-statement timings to the log and delivers them through
+    // statementStatsDumped(). The slow-statement log threshold is the
+    // "slow_statement_ms" setting (default 50, 0 turns it off).
+    Q_INVOKABLE void dumpStatementStats();
 
     Q_INVOKABLE void clearLastError();
 
+    // Generic access to the in-memory settings store; keys without a typed
+    // property are persisted the same way, no schema change needed.
+    Q_INVOKABLE QVariant setting(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    Q_INVOKABLE void setSetting(const QString &key, const QVariant &value);
+
+public slots:
+    // Hands all queued episode progress to the worker as one transaction.
+    void flushPendingProgress();
+    // Writes coalesced setting changes in one transaction.
+    void flushSettings();
+    // Replaces the stored search history with the in-memory ring.
+    void flushSearchHistory();
+    // Subscribes to a list of feed maps (feedId, title, image, guid,
+    // imageUrlHash, feedUrl) in one transaction; failed is the number of
+    // feeds the lookup could not find, reported with the result.
+    void subscribeAll(const QVariantList &feeds, int failed);
+
+    // Offline episode lists; results arrive through cachedEpisodesLoaded().
+    void requestCachedEpisodes(int feedId);
+    // Stores a fresh network list; only rows that changed are rewritten.
+    void cacheEpisodes(int feedId, const QVariantList &episodes);
+
 signals:
     void subscriptionsChanged();
     void forwardSkipSecondsChanged();
@@ -76,24 +152,114 @@ signals:
     void sleepTimerMinutesChanged();
     void searchHistoryChanged();
     void lastErrorChanged();
+    void dbStatusChanged();
+    void settingChanged(const QString &key);
+    void episodeStateLoaded(const QString &episodeId, const QVariantMap &episodeState);
+    void episodeStatesLoaded(const QVariantMap &episodeStates);
+    void cachedEpisodesLoaded(int feedId, const QVariantList &episodes);
+    void localSearchFinished(const QString &term, const QVariantList &results);
+    // pending: feeds still being looked up on the network; failed: feeds
+    // the lookup could not find.
+    void subscriptionsImported(int added, int pending, int failed);
+    void opmlExported(int count, const QString &path);
+    // { feedUrl, title } maps to resolve to Podcast Index feeds.
+    void feedsNeedResolving(const QVariantList &feeds);
+    // [{ connection, sql, count, totalMs, maxMs, p95Ms }] from both
+    // connections, largest total first.
+    void statementStatsDumped(const QVariantList &stats);
+
+private slots:
+    void onOpened(const QString &dbPath, const QString &dbStatus, const QString &dbPathLog);
+    void onSettingsLoaded(const QVariantMap &settings);
+    void onSubscriptionsLoaded(const QVariantList &subscriptions);
+    void onSubscriptionSaved(const QVariantMap &subscription);
+    void onSubscriptionRemoved(int feedId);
+    void onSearchHistoryLoaded(const QVariantList &history);
+    void onEpisodeStatesLoaded(const QStringList &episodeIds, const QVariantMap &episodeStates);
+    void onOperationFailed(const QString &message);
+    void onCheckpointTimeout();
+    void onMaintenanceTimeout();
+    void onPruneStepFinished(bool morePending);
+    void onVacuumStepFinished(bool morePending);
+    void onSubscriptionsImported(int added, const QVariantList &unresolved, int failed);
+    void onRecentPageRequested(int token, int beforePlayedAt, const QString &beforeEpisodeId,
+                               int limit, bool inProgressOnly);
+    void onReaderOpened(bool ok);
+    void onProgressSaved();
+    void onStatementStatsDumped(const QVariantList &stats);
 
 private:
-    QString dbPath();
-    bool ensureOpen() const;
-    void initDb();
-    void loadSettings();
-    void saveSetting(const QString &key, int value);
-    int readSetting(const QString &key, int defaultValue) const;
-    void setSubscriptions(const QVariantList &list);
+    // Signals both workers emit for loads.
+    void connectReadSignals(StorageWorker *worker);
+    StorageWorker *reader() const;
+    void saveSetting(const QString &key, const QVariant &value);
+    void scheduleCheckpoint();
 
     void setLastError(const QString &error);
 
+    // Latest unsaved progress for one episode; only the newest state is kept.
+    struct PendingProgress {
+        int feedId;
+        QString title;
+        QString audioUrl;
+        int durationSeconds;
+        int positionMs;
+        int lastPlayedAt;
+        QString enclosureType;
+        int publishedAt;
+        int playState;
+    };
+
+    // Write-behind journal: episodeId -> latest progress, flushed on a timer,
+    // on pause/stop and on application exit.
+    QHash<QString, PendingProgress> m_pendingProgress;
+    QTimer m_progressFlushTimer;
+
     // Tracks the last persisted (positionMs, playState) per episode to avoid
     // redundant DB writes when position hasn't changed (e.g. while paused).
-    QHash<QString, QPair<int,int> > m_lastSavedProgress;
+    // QCache keeps it at LastSavedProgressCapacity entries (cost 1 each).
+    QCache<QString, QPair<int,int> > m_lastSavedProgress;
+
+    // All settings as loaded in one query, plus changes not yet written.
+    QVariantMap m_settings;
+    QVariantMap m_dirtySettings;
+    QTimer m_settingsFlushTimer;
+
+    // Newest-first ring with a prefix index; the table is only written from
+    // here, after changes settle.
+    SearchHistory m_searchHistory;
+    bool m_searchHistoryDirty;
+    QTimer m_searchHistoryFlushTimer;
+
+    // WAL checkpoints only run after writes settle while nothing is playing.
+    QTimer m_checkpointTimer;
+    bool m_playbackActive;
+
+    // Once per session, at idle: prune stale rows, then vacuum in steps.
+    QTimer m_maintenanceTimer;
+    bool m_maintenancePruned;
+
+    // Writes (and anything that must follow them in order) go to m_worker.
+    // Plain loads go to m_reader, a read-only connection on its own thread,
+    // so a long list query and a progress write never queue behind each
+    // other. Until the reader is open, and for an in-memory database, reads
+    // fall back to m_worker.
+    QThread m_thread;
+    StorageWorker *m_worker;
+    QThread m_readThread;
+    StorageWorker *m_reader;
+    bool m_readerReady;
+    // Entries of saveProgress() calls not yet acknowledged by
+    // progressSaved(), oldest first; episode state reads stay on the writer
+    // meanwhile so they see the new rows.
+    QList<QVariantList> m_progressWritesInFlight;
+    // dumpStatementStats() collects one answer per connection.
+    int m_statementDumpsPending;
+    QVariantList m_statementDump;
 
-    QVariantList m_subscriptions;
-    QVariantList m_searchHistory;
+    SubscriptionListModel *m_subscriptionModel;
+    RecentEpisodesModel *m_recentEpisodes;
+    RecentEpisodesModel *m_inProgressEpisodes;
     int m_forwardSkipSeconds;
     int m_backwardSkipSeconds;
     bool m_enableArtworkLoading;
@@ -0,0 +1,2096 @@
+#include "StorageWorker.h"
+
+#include "AppConfig.h"
+#include "Opml.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QDebug>
+#include <QtGui/QDesktopServices>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlError>
+#include <QtSql/QSqlQuery>
+#include <QtCore/qglobal.h>
+
+namespace {
+const char *const kConnectionName = "podin";
+// Second connection to the same file for StorageManager's reader thread.
+// Under WAL its reads see the last committed state and never wait for the
+// writer.
+const char *const kReadConnectionName = "podin-read";
+
+// Batch state lookups bind this many IDs per IN (...) query; short batches
+// are padded with a repeated ID so a single prepared statement serves all.
+const int kEpisodeStateBatchSize = 50;
+// Larger lists go into a temp table and are resolved with one join.
+const int kEpisodeStateTempTableThreshold = 500;
+
+// Field-wise comparison of a cached episode row against a freshly parsed
+// one; JSON numbers and SQLite integers differ in QVariant type.
+bool sameCachedEpisode(const QVariantMap &cached, const QVariantMap &episode, int position)
+{
+    return cached.value(QString::fromLatin1("position")).toInt() == position
+        && cached.value(QString::fromLatin1("title")).toString() == episode.value(QString::fromLatin1("title")).toString()
+        && cached.value(QString::fromLatin1("enclosureUrl")).toString() == episode.value(QString::fromLatin1("enclosureUrl")).toString()
+        && cached.value(QString::fromLatin1("enclosureType")).toString() == episode.value(QString::fromLatin1("enclosureType")).toString()
+        && cached.value(QString::fromLatin1("duration")).toInt() == episode.value(QString::fromLatin1("duration")).toInt()
+        && cached.value(QString::fromLatin1("datePublished")).toLongLong() == episode.value(QString::fromLatin1("datePublished")).toLongLong()
+        && cached.value(QString::fromLatin1("description")).toString() == episode.value(QString::fromLatin1("description")).toString();
+}
+
+// Maintenance retention windows. Finished episodes (within 30 s of the end)
+// only need to be remembered briefly; anything untouched for half a year is
+// abandoned; rows from feeds the user is not subscribed to get a short grace
+// period so resuming a just-sampled episode still works.
+const int kFinishedRetentionDays = 30;
+const int kAbandonedRetentionDays = 180;
+const int kUnsubscribedRetentionDays = 7;
+const int kSecondsPerDay = 24 * 60 * 60;
+
+// OPML feeds that need a network lookup (no Podcast Index ID in the file)
+// are capped so a huge file cannot queue an unbounded amount of work.
+const int kOpmlMaxUnresolved = 1000;
+
+// Settings key for the slow-statement log threshold in milliseconds; 0
+// turns the log off. Not seeded, StatementProfiler has the default.
+const char *const kSlowStatementKey = "slow_statement_ms";
+
+// Local search returns at most this many subscriptions and as many episodes.
+const int kLocalSearchLimit = 20;
+// The LIKE fallback binds one pattern per word; longer input is cut here so
+// the statement cache sees a bounded number of query shapes.
+const int kLikeSearchMaxWords = 6;
+
+// One incremental vacuum step frees pages in small chunks until the
+// freelist is empty or the time budget is spent.
+const int kVacuumPagesPerChunk = 16;
+const int kVacuumStepBudgetMs = 40;
+// Pruning works the same way: rows are deleted this many at a time, and a
+// step stops at the vacuum budget.
+const int kPruneRowsPerChunk = 200;
+// A file without auto_vacuum=INCREMENTAL can only be converted by a full
+// VACUUM, which rewrites every live page with no time limit. Only done
+// when at least this share of the file is free pages (1/N) and the live
+// part is small enough to copy quickly; otherwise the file keeps its mode
+// and maintenance only prunes rows.
+const int kConvertMinFreeShare = 4;
+const int kConvertMaxLivePages = 2048;
+
+// Reads one (episode_id, played_position_ms, play_state, duration_seconds) row.
+void insertEpisodeState(QVariantMap &states, const QSqlQuery *query)
+{
+    QVariantMap state;
+    state.insert(QString::fromLatin1("positionMs"), query->value(1).toInt());
+    state.insert(QString::fromLatin1("playState"), query->value(2).toInt());
+    state.insert(QString::fromLatin1("durationSeconds"), query->value(3).toInt());
+    states.insert(query->value(0).toString(), state);
+}
+
+// What the user typed as lowercase words. Anything that is not a letter or
+// digit separates words, so the words can never form FTS operators or LIKE
+// wildcards.
+QStringList searchWords(const QString &term)
+{
+    QStringList words;
+    QString word;
+    const QString lower = term.toLower();
+    for (int i = 0; i <= lower.size(); ++i) {
+        if (i < lower.size() && lower.at(i).isLetterOrNumber()) {
+            word += lower.at(i);
+        } else if (!word.isEmpty()) {
+            words << word;
+            word.clear();
+        }
+    }
+    return words;
+}
+
+// FTS3 query: every word becomes a prefix term, implicitly ANDed.
+QString ftsMatchExpression(const QStringList &words)
+{
+    QStringList terms;
+    for (int i = 0; i < words.size(); ++i) {
+        terms << words.at(i) + QLatin1Char('*');
+    }
+    return terms.join(QLatin1String(" "));
+}
+
+// LIKE fallback: "column LIKE ?" (or "(a LIKE ? OR b LIKE ?)") per word,
+// ANDed; bind likePattern() of each word once per column.
+QString likeCondition(const QStringList &columns, int wordCount)
+{
+    QStringList alternatives;
+    for (int i = 0; i < columns.size(); ++i) {
+        alternatives << columns.at(i) + QLatin1String(" LIKE ?");
+    }
+    QString perWord = alternatives.join(QLatin1String(" OR "));
+    if (columns.size() > 1) {
+        perWord = QLatin1Char('(') + perWord + QLatin1Char(')');
+    }
+    QStringList conditions;
+    for (int i = 0; i < wordCount; ++i) {
+        conditions << perWord;
+    }
+    return conditions.join(QLatin1String(" AND "));
+}
+
+QString likePattern(const QString &word)
+{
+    return QLatin1Char('%') + word + QLatin1Char('%');
+}
+
+void logError(const QString &context, const QSqlError &error)
+{
+    if (error.type() == QSqlError::NoError) {
+        return;
+    }
+    qWarning("Storage error (%s): %s",
+             qPrintable(context),
+             qPrintable(error.text()));
+}
+
+#ifdef Q_OS_SYMBIAN
+// Remembers which candidate directory dbPath() settled on. Lives next to the
+// executable's private directory, which the app can always read.
+QString dbLocationMarkerPath()
+{
+    return QDir(QCoreApplication::applicationDirPath()).filePath(QLatin1String("podin.dbpath"));
+}
+
+QString readDbLocationMarker()
+{
+    QFile marker(dbLocationMarkerPath());
+    if (!marker.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    const QString location = QString::fromUtf8(marker.readAll()).trimmed();
+    marker.close();
+    return location;
+}
+
+bool writeDbLocationMarker(const QString &location)
+{
+    QFile marker(dbLocationMarkerPath());
+    if (!marker.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    marker.write(location.toUtf8());
+    marker.close();
+    return true;
+}
+
+void removeDbLocationMarker()
+{
+    QFile::remove(dbLocationMarkerPath());
+}
+#endif
+
+// QSYMSQL (native Symbian SQL) is preferred over QSQLITE where available.
+QString preferredDriver()
+{
+#ifdef Q_OS_SYMBIAN
+    if (QSqlDatabase::isDriverAvailable(QLatin1String("QSYMSQL"))) {
+        return QLatin1String("QSYMSQL");
+    }
+#endif
+    if (QSqlDatabase::isDriverAvailable(QLatin1String("QSQLITE"))) {
+        return QLatin1String("QSQLITE");
+    }
+    return QString();
+}
+
+// Runs sql on a query that bypasses StatementCache (migrations, tuning,
+// probes), timed under the connection's profiler all the same. Reads are
+// timed for the exec() call only.
+bool execTimed(QSqlQuery &query, const QSqlDatabase &db, const QString &sql)
+{
+    StatementTimer timer(db.connectionName(), sql);
+    return query.exec(sql);
+}
+
+bool execAll(QSqlDatabase &db, const char *const *statements, const char *context)
+{
+    QSqlQuery query(db);
+    for (int i = 0; statements[i]; ++i) {
+        if (!execTimed(query, db, QLatin1String(statements[i]))) {
+            logError(QString::fromLatin1("%1: %2").arg(QLatin1String(context), QLatin1String(statements[i])),
+                     query.lastError());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Per-connection tuning, applied on every open. Under WAL, NORMAL only
+// syncs at checkpoints; the page cache is capped at 512 KiB for the 32 MB
+// heap; temp b-trees stay in RAM. Automatic checkpoints are off so they
+// can't land mid-playback: StorageManager asks for checkpoint() while
+// playback is stopped or paused.
+void applyTuning(QSqlDatabase &db)
+{
+    static const char *const kPragmas[] = {
+        "PRAGMA synchronous=NORMAL",
+        "PRAGMA cache_size=-512",
+        "PRAGMA temp_store=MEMORY",
+        "PRAGMA wal_autocheckpoint=0",
+        0
+    };
+    QSqlQuery query(db);
+    for (int i = 0; kPragmas[i]; ++i) {
+        // Best effort: some drivers (QSYMSQL) reject individual pragmas.
+        if (!execTimed(query, db, QLatin1String(kPragmas[i]))) {
+            logError(QString::fromLatin1("tuning: %1").arg(QLatin1String(kPragmas[i])), query.lastError());
+        }
+    }
+}
+
+bool hasColumn(QSqlDatabase &db, const char *table, const char *column)
+{
+    QSqlQuery pragma(db);
+    if (!execTimed(pragma, db, QString::fromLatin1("PRAGMA table_info(%1)").arg(QLatin1String(table)))) {
+        return false;
+    }
+    while (pragma.next()) {
+        if (pragma.value(1).toString() == QLatin1String(column)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool addColumnIfMissing(QSqlDatabase &db, const char *table, const char *column, const char *type)
+{
+    if (hasColumn(db, table, column)) {
+        return true;
+    }
+    QSqlQuery alter(db);
+    if (!execTimed(alter, db, QString::fromLatin1("ALTER TABLE %1 ADD COLUMN %2 %3")
+                   .arg(QLatin1String(table), QLatin1String(column), QLatin1String(type)))) {
+        logError(QString::fromLatin1("alter %1 add %2").arg(QLatin1String(table), QLatin1String(column)),
+                 alter.lastError());
+        return false;
+    }
+    return true;
+}
+
+// Version 1: the schema as it stood before versioning. Also upgrades
+// unversioned databases created by older builds, which may lack the
+// guid/image_url_hash/play_state columns.
+bool migrateToV1(QSqlDatabase &db)
+{
+    static const char *const kStatements[] = {
+        "CREATE TABLE IF NOT EXISTS subscriptions ("
+        "feed_id INTEGER PRIMARY KEY, "
+        "title TEXT NOT NULL, "
+        "image TEXT, "
+        "last_updated INTEGER, "
+        "guid TEXT, "
+        "image_url_hash TEXT)",
+        "CREATE TABLE IF NOT EXISTS episodes ("
+        "episode_id TEXT PRIMARY KEY, "
+        "feed_id INTEGER NOT NULL, "
+        "title TEXT NOT NULL, "
+        "audio_url TEXT NOT NULL, "
+        "duration_seconds INTEGER, "
+        "played_position_ms INTEGER DEFAULT 0, "
+        "last_played_at INTEGER, "
+        "published_at INTEGER, "
+        "enclosure_type TEXT, "
+        "play_state INTEGER DEFAULT 0, "
+        "image TEXT, "
+        "FOREIGN KEY(feed_id) REFERENCES subscriptions(feed_id))",
+        "CREATE TABLE IF NOT EXISTS settings ("
+        "key TEXT PRIMARY KEY, "
+        "value INTEGER)",
+        "CREATE TABLE IF NOT EXISTS search_history ("
+        "term TEXT PRIMARY KEY COLLATE NOCASE, "
+        "searched_at INTEGER)",
+        "INSERT OR IGNORE INTO settings (key, value) VALUES ('forward_skip_seconds', 30)",
+        "INSERT OR IGNORE INTO settings (key, value) VALUES ('backward_skip_seconds', 15)",
+        "INSERT OR IGNORE INTO settings (key, value) VALUES ('enable_artwork_loading', 0)",
+        "INSERT OR IGNORE INTO settings (key, value) VALUES ('volume_percent', 50)",
+        0
+    };
+    static const char *const kIndexes[] = {
+        "CREATE INDEX IF NOT EXISTS idx_episodes_feed_id ON episodes(feed_id)",
+        "CREATE INDEX IF NOT EXISTS idx_episodes_last_played ON episodes(last_played_at)",
+        0
+    };
+
+    return execAll(db, kStatements, "migration 1")
+        && addColumnIfMissing(db, "subscriptions", "guid", "TEXT")
+        && addColumnIfMissing(db, "subscriptions", "image_url_hash", "TEXT")
+        && addColumnIfMissing(db, "episodes", "play_state", "INTEGER DEFAULT 0")
+        && execAll(db, kIndexes, "migration 1");
+}
+
+// Version 2: per-feed copy of the last fetched episode list, shown
+// immediately while the network refresh is in flight (or offline).
+bool migrateToV2(QSqlDatabase &db)
+{
+    static const char *const kStatements[] = {
+        "CREATE TABLE IF NOT EXISTS episode_cache ("
+        "feed_id INTEGER NOT NULL, "
+        "episode_id TEXT NOT NULL, "
+        "position INTEGER NOT NULL, "
+        "title TEXT, "
+        "enclosure_url TEXT, "
+        "enclosure_type TEXT, "
+        "duration_seconds INTEGER, "
+        "date_published INTEGER, "
+        "description TEXT, "
+        "cached_at INTEGER, "
+        "PRIMARY KEY(feed_id, episode_id))",
+        0
+    };
+    return execAll(db, kStatements, "migration 2");
+}
+
+// Version 3: (last_played_at, episode_id) index for keyset paging of the
+// recently played list; supersedes the single-column index.
+bool migrateToV3(QSqlDatabase &db)
+{
+    static const char *const kStatements[] = {
+        "CREATE INDEX IF NOT EXISTS idx_episodes_recent ON episodes(last_played_at, episode_id)",
+        "DROP INDEX IF EXISTS idx_episodes_last_played",
+        0
+    };
+    return execAll(db, kStatements, "migration 3");
+}
+
+// Refills both search tables from their source rows. Episode docids are
+// episode_cache rowids, which a full VACUUM may renumber. Run inside a
+// transaction: between the DELETEs and INSERTs the tables are empty.
+bool rebuildSearchIndex(QSqlDatabase &db)
+{
+    static const char *const kStatements[] = {
+        "DELETE FROM subscription_search",
+        "DELETE FROM episode_search",
+        "INSERT INTO subscription_search (docid, title) SELECT feed_id, title FROM subscriptions",
+        "INSERT INTO episode_search (docid, title, description) "
+        "SELECT rowid, title, description FROM episode_cache",
+        0
+    };
+    return execAll(db, kStatements, "rebuild search index");
+}
+
+// Version 4: full-text index over subscription titles and cached episode
+// titles/descriptions. SQLite builds without FTS3 keep working: the tables
+// are simply not created and local search falls back to LIKE.
+bool migrateToV4(QSqlDatabase &db)
+{
+    static const char *const kStatements[] = {
+        "CREATE VIRTUAL TABLE subscription_search USING fts3(title)",
+        "CREATE VIRTUAL TABLE episode_search USING fts3(title, description)",
+        0
+    };
+    QSqlQuery probe(db);
+    if (execTimed(probe, db, QLatin1String("SELECT 1 FROM sqlite_master WHERE name = 'subscription_search'"))
+        && probe.next()) {
+        return true;
+    }
+    probe.finish();
+    if (!execAll(db, kStatements, "migration 4")) {
+        qDebug() << "StorageManager: FTS3 not available, local search uses LIKE";
+        QSqlQuery cleanup(db);
+        execTimed(cleanup, db, QLatin1String("DROP TABLE IF EXISTS subscription_search"));
+        return true;
+    }
+    return rebuildSearchIndex(db);
+}
+
+// Version 5: remember each subscription's feed URL for OPML export.
+bool migrateToV5(QSqlDatabase &db)
+{
+    return addColumnIfMissing(db, "subscriptions", "feed_url", "TEXT");
+}
+
+struct Migration {
+    int version;
+    bool (*apply)(QSqlDatabase &db);
+};
+
+// Append new migrations here; each runs exactly once, in its own transaction,
+// and bumps PRAGMA user_version to its version on commit.
+const Migration kMigrations[] = {
+    { 1, migrateToV1 },
+    { 2, migrateToV2 },
+    { 3, migrateToV3 },
+    { 4, migrateToV4 },
+    { 5, migrateToV5 }
+};
+const int kMigrationCount = sizeof(kMigrations) / sizeof(kMigrations[0]);
+}
+
+StorageWorker::StorageWorker(Connection connection, QObject *parent)
+    : QObject(parent)
+    , m_connectionName(QLatin1String(connection == ReadOnly ? kReadConnectionName : kConnectionName))
+    , m_dbStatus(QLatin1String("not initialized"))
+    , m_dbPathFromCache(false)
+    , m_searchIndex(-1)
+    , m_vacuumConversionChecked(false)
+    , m_pruneStage(0)
+{
+}
+
+StorageWorker::~StorageWorker()
+{
+    m_statements.clear();
+}
+
+void StorageWorker::open()
+{
+    initDb();
+    emit opened(m_dbPath, m_dbStatus, m_dbPathLog);
+    loadSettings();
+    loadSubscriptions();
+    loadSearchHistory();
+}
+
+void StorageWorker::openReadOnly(const QString &path)
+{
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        const QString driverName = preferredDriver();
+        if (driverName.isEmpty()) {
+            emit readOnlyOpened(false);
+            return;
+        }
+        QSqlDatabase db = QSqlDatabase::addDatabase(driverName, m_connectionName);
+        db.setDatabaseName(path);
+        if (driverName == QLatin1String("QSQLITE")) {
+            // QSYMSQL has no equivalent; there the connection is simply
+            // never written to.
+            db.setConnectOptions(QLatin1String("QSQLITE_OPEN_READONLY"));
+        }
+    }
+    m_statements.setDatabase(QSqlDatabase::database(m_connectionName, false));
+    const bool ok = ensureOpen();
+    m_dbPath = path;
+    m_dbStatus = ok ? QLatin1String("open (read-only)") : QLatin1String("open failed");
+    qDebug() << "StorageManager: Read connection" << m_dbStatus;
+    emit readOnlyOpened(ok);
+}
+
+void StorageWorker::close()
+{
+    m_statements.setDatabase(QSqlDatabase());
+    if (!QSqlDatabase::contains(m_connectionName)) {
+        return;
+    }
+    {
+        QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+        if (db.isOpen()) {
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(m_connectionName);
+    m_dbStatus = QLatin1String("closed");
+}
+
+QVariantMap StorageWorker::readSettings()
+{
+    QVariantMap settings;
+    if (!ensureOpen()) {
+        return settings;
+    }
+
+    // Every key in one pass; StorageManager applies defaults and bounds.
+    QSqlQuery *query = m_statements.query(QLatin1String("SELECT key, value FROM settings"));
+    if (!query) {
+        return settings;
+    }
+    if (!m_statements.exec(query)) {
+        logError("load settings", query->lastError());
+        return settings;
+    }
+    while (query->next()) {
+        settings.insert(query->value(0).toString(), query->value(1));
+    }
+    m_statements.finish(query);
+    return settings;
+}
+
+void StorageWorker::loadSettings()
+{
+    if (!ensureOpen()) {
+        return;
+    }
+    const QVariantMap settings = readSettings();
+    applyProfilerSettings(settings);
+    emit settingsLoaded(settings);
+}
+
+void StorageWorker::saveSettings(const QVariantMap &settings)
+{
+    if (settings.isEmpty() || !ensureOpen()) {
+        return;
+    }
+    applyProfilerSettings(settings);
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "INSERT OR REPLACE INTO settings (key, value) VALUES (?, ?)"));
+    if (!query) {
+        return;
+    }
+
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    QVariantMap::const_iterator it = settings.constBegin();
+    for (; it != settings.constEnd(); ++it) {
+        query->bindValue(0, it.key());
+        query->bindValue(1, it.value());
+        if (!m_statements.exec(query)) {
+            logError("save setting", query->lastError());
+        }
+    }
+    if (inTransaction && !m_statements.commit()) {
+        logError("commit settings", db.lastError());
+        m_statements.rollback();
+    }
+}
+
+void StorageWorker::dumpStatementStats()
+{
+    QVariantList stats = m_statements.profiler()->snapshot();
+    qDebug("StorageManager: Statement timings on %s (count, total ms, max ms, p95 ms):",
+           qPrintable(m_connectionName));
+    for (int i = 0; i < stats.size(); ++i) {
+        QVariantMap row = stats.at(i).toMap();
+        qDebug("StorageManager: %6d %9.1f %7.1f %7.1f %s",
+               row.value(QString::fromLatin1("count")).toInt(),
+               row.value(QString::fromLatin1("totalMs")).toDouble(),
+               row.value(QString::fromLatin1("maxMs")).toDouble(),
+               row.value(QString::fromLatin1("p95Ms")).toDouble(),
+               qPrintable(row.value(QString::fromLatin1("sql")).toString()));
+        row.insert(QString::fromLatin1("connection"), m_connectionName);
+        stats[i] = row;
+    }
+    emit statementStatsDumped(stats);
+}
+
+void StorageWorker::applyProfilerSettings(const QVariantMap &settings)
+{
+    const QString key = QLatin1String(kSlowStatementKey);
+    if (settings.contains(key)) {
+        m_statements.profiler()->setSlowThresholdMs(settings.value(key).toInt());
+    }
+}
+
+QVariantList StorageWorker::readSubscriptions()
+{
+    QVariantList results;
+    if (!ensureOpen()) {
+        return results;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "SELECT feed_id, title, image, last_updated, guid, image_url_hash FROM subscriptions ORDER BY title ASC"));
+    if (!query) {
+        return results;
+    }
+    if (!m_statements.exec(query)) {
+        logError("load subscriptions", query->lastError());
+        return results;
+    }
+
+    while (query->next()) {
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("feedId"), query->value(0));
+        entry.insert(QString::fromLatin1("title"), query->value(1));
+        entry.insert(QString::fromLatin1("image"), query->value(2));
+        entry.insert(QString::fromLatin1("lastUpdated"), query->value(3));
+        entry.insert(QString::fromLatin1("guid"), query->value(4));
+        entry.insert(QString::fromLatin1("imageUrlHash"), query->value(5));
+        results.append(entry);
+    }
+    m_statements.finish(query);
+    return results;
+}
+
+void StorageWorker::loadSubscriptions()
+{
+    if (!ensureOpen()) {
+        return;
+    }
+    emit subscriptionsLoaded(readSubscriptions());
+}
+
+void StorageWorker::subscribe(int feedId, const QString &title, const QString &image,
+                              const QString &guid, const QString &imageUrlHash,
+                              const QString &feedUrl)
+{
+    if (!ensureOpen()) {
+        emit operationFailed(QString::fromLatin1("Subscribe failed: database not open"));
+        return;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "INSERT OR REPLACE INTO subscriptions (feed_id, title, image, last_updated, guid, image_url_hash, feed_url) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?)"));
+    if (!query) {
+        emit operationFailed(QString::fromLatin1("Subscribe failed: could not prepare statement"));
+        return;
+    }
+    const int lastUpdated = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t());
+    query->bindValue(0, feedId);
+    query->bindValue(1, title);
+    query->bindValue(2, image);
+    query->bindValue(3, lastUpdated);
+    query->bindValue(4, guid);
+    query->bindValue(5, imageUrlHash);
+    query->bindValue(6, feedUrl.isEmpty() ? QVariant(QVariant::String) : QVariant(feedUrl));
+
+    if (!m_statements.exec(query)) {
+        logError("subscribe", query->lastError());
+        emit operationFailed(QString::fromLatin1("Subscribe failed: %1").arg(query->lastError().text()));
+        return;
+    }
+
+    indexSubscription(feedId, title);
+
+    // Same shape as a readSubscriptions() row; no need to re-read the table.
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("feedId"), feedId);
+    entry.insert(QString::fromLatin1("title"), title);
+    entry.insert(QString::fromLatin1("image"), image);
+    entry.insert(QString::fromLatin1("lastUpdated"), lastUpdated);
+    entry.insert(QString::fromLatin1("guid"), guid);
+    entry.insert(QString::fromLatin1("imageUrlHash"), imageUrlHash);
+    emit subscriptionSaved(entry);
+}
+
+bool StorageWorker::indexSubscription(int feedId, const QString &title)
+{
+    if (!searchIndexAvailable()) {
+        return true;
+    }
+    QSqlQuery *unindex = m_statements.query(QLatin1String("DELETE FROM subscription_search WHERE docid = ?"));
+    QSqlQuery *index = m_statements.query(QLatin1String(
+        "INSERT INTO subscription_search (docid, title) VALUES (?, ?)"));
+    if (!unindex || !index) {
+        return false;
+    }
+    unindex->bindValue(0, feedId);
+    index->bindValue(0, feedId);
+    index->bindValue(1, title);
+    if (!m_statements.exec(unindex)) {
+        logError("index subscription", unindex->lastError());
+        return false;
+    }
+    if (!m_statements.exec(index)) {
+        logError("index subscription", index->lastError());
+        return false;
+    }
+    return true;
+}
+
+bool StorageWorker::insertSubscription(const QVariantMap &feed, bool *added)
+{
+    *added = false;
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "INSERT OR IGNORE INTO subscriptions (feed_id, title, image, last_updated, guid, image_url_hash, feed_url) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?)"));
+    if (!query) {
+        return false;
+    }
+    const int feedId = feed.value(QString::fromLatin1("feedId")).toInt();
+    const QString title = feed.value(QString::fromLatin1("title")).toString();
+    const QString feedUrl = feed.value(QString::fromLatin1("feedUrl")).toString();
+    query->bindValue(0, feedId);
+    query->bindValue(1, title);
+    query->bindValue(2, feed.value(QString::fromLatin1("image")).toString());
+    query->bindValue(3, static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
+    query->bindValue(4, feed.value(QString::fromLatin1("guid")).toString());
+    query->bindValue(5, feed.value(QString::fromLatin1("imageUrlHash")).toString());
+    query->bindValue(6, feedUrl.isEmpty() ? QVariant(QVariant::String) : QVariant(feedUrl));
+    if (!m_statements.exec(query)) {
+        logError("insert subscription", query->lastError());
+        return false;
+    }
+    // Already subscribed feeds are left as they are.
+    *added = query->numRowsAffected() > 0;
+    return !*added || indexSubscription(feedId, title);
+}
+
+void StorageWorker::importOpml(const QString &path)
+{
+    if (!ensureOpen()) {
+        emit operationFailed(QString::fromLatin1("Import failed: database not open"));
+        return;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit operationFailed(QString::fromLatin1("Import failed: %1").arg(file.errorString()));
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Feeds without a Podcast Index ID are only known by URL; skip the ones
+    // already subscribed, hand the rest back for a network lookup.
+    QSet<QString> knownUrls;
+    QSqlQuery *urls = m_statements.query(QLatin1String(
+        "SELECT feed_url FROM subscriptions WHERE feed_url IS NOT NULL"));
+    if (urls && m_statements.exec(urls)) {
+        while (urls->next()) {
+            knownUrls.insert(urls->value(0).toString());
+        }
+        m_statements.finish(urls);
+    }
+
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    OpmlReader reader(&file);
+    QVariantMap feed;
+    QVariantList unresolved;
+    int added = 0;
+    int read = 0;
+    bool ok = true;
+    while (ok && reader.readNextFeed(&feed)) {
+        ++read;
+        const QString feedUrl = feed.value(QString::fromLatin1("feedUrl")).toString();
+        if (feed.value(QString::fromLatin1("feedId")).toInt() > 0) {
+            bool inserted = false;
+            ok = insertSubscription(feed, &inserted);
+            if (inserted) {
+                ++added;
+                knownUrls.insert(feedUrl);
+            }
+        } else if (!knownUrls.contains(feedUrl) && unresolved.size() < kOpmlMaxUnresolved) {
+            knownUrls.insert(feedUrl);
+            QVariantMap pending;
+            pending.insert(QString::fromLatin1("feedUrl"), feedUrl);
+            pending.insert(QString::fromLatin1("title"), feed.value(QString::fromLatin1("title")));
+            unresolved.append(pending);
+        }
+    }
+    QString failure;
+    if (ok && reader.hasError()) {
+        qWarning("Storage error (read opml): %s", qPrintable(reader.errorString()));
+        failure = reader.errorString();
+        ok = false;
+    }
+    if (inTransaction) {
+        if (ok && !m_statements.commit()) {
+            logError("commit opml import", db.lastError());
+            ok = false;
+        }
+        if (!ok) {
+            m_statements.rollback();
+        }
+    }
+    if (!ok) {
+        // Every failure has to be reported: the settings page keeps its OPML
+        // buttons disabled until it hears back.
+        if (failure.isEmpty()) {
+            failure = QString::fromLatin1("could not save %1 feeds").arg(read);
+        }
+        emit operationFailed(QString::fromLatin1("Import failed: %1").arg(failure));
+        return;
+    }
+
+    qDebug() << "StorageManager: OPML import read" << read << "feeds, added" << added
+             << "," << unresolved.size() << "to resolve, in" << timer.elapsed() << "ms";
+    if (added > 0) {
+        emit subscriptionsLoaded(readSubscriptions());
+    }
+    emit subscriptionsImported(added, unresolved, 0);
+}
+
+void StorageWorker::subscribeAll(const QVariantList &feeds, int failed)
+{
+    if (!ensureOpen()) {
+        emit operationFailed(QString::fromLatin1("Subscribe failed: database not open"));
+        return;
+    }
+
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    int added = 0;
+    bool ok = true;
+    for (int i = 0; ok && i < feeds.size(); ++i) {
+        const QVariantMap feed = feeds.at(i).toMap();
+        if (feed.value(QString::fromLatin1("feedId")).toInt() <= 0) {
+            continue;
+        }
+        bool inserted = false;
+        ok = insertSubscription(feed, &inserted);
+        if (inserted) {
+            ++added;
+        }
+    }
+    if (inTransaction) {
+        if (ok && !m_statements.commit()) {
+            logError("commit subscriptions", db.lastError());
+            ok = false;
+        }
+        if (!ok) {
+            m_statements.rollback();
+        }
+    }
+    if (!ok) {
+        emit operationFailed(QString::fromLatin1("Subscribe failed: could not save %1 feeds").arg(feeds.size()));
+        return;
+    }
+    if (added > 0) {
+        emit subscriptionsLoaded(readSubscriptions());
+    }
+    emit subscriptionsImported(added, QVariantList(), failed);
+}
+
+void StorageWorker::exportOpml(const QString &path)
+{
+    if (!ensureOpen()) {
+        emit operationFailed(QString::fromLatin1("Export failed: database not open"));
+        return;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "SELECT feed_id, title, feed_url, guid, image FROM subscriptions ORDER BY title ASC"));
+    if (!query || !m_statements.exec(query)) {
+        if (query) {
+            logError("export subscriptions", query->lastError());
+        }
+        emit operationFailed(QString::fromLatin1("Export failed: could not read subscriptions"));
+        return;
+    }
+
+    // Written next to the target and renamed at the end, so a failed export
+    // never leaves half a file where the last good one was.
+    const QString partPath = path + QLatin1String(".part");
+    QFile file(partPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_statements.finish(query);
+        emit operationFailed(QString::fromLatin1("Export failed: %1").arg(file.errorString()));
+        return;
+    }
+
+    OpmlWriter writer(&file);
+    writer.writeStart(QString::fromLatin1("Podin subscriptions"));
+    int count = 0;
+    while (query->next()) {
+        QVariantMap feed;
+        feed.insert(QString::fromLatin1("feedId"), query->value(0).toInt());
+        feed.insert(QString::fromLatin1("title"), query->value(1).toString());
+        feed.insert(QString::fromLatin1("feedUrl"), query->value(2).toString());
+        feed.insert(QString::fromLatin1("guid"), query->value(3).toString());
+        feed.insert(QString::fromLatin1("image"), query->value(4).toString());
+        writer.writeFeed(feed);
+        ++count;
+    }
+    m_statements.finish(query);
+    writer.writeEnd();
+    const bool written = file.flush() && file.error() == QFile::NoError;
+    const QString fileError = file.errorString();
+    file.close();
+    if (!written) {
+        QFile::remove(partPath);
+        emit operationFailed(QString::fromLatin1("Export failed: %1").arg(fileError));
+        return;
+    }
+    QFile::remove(path);
+    if (!QFile::rename(partPath, path)) {
+        emit operationFailed(QString::fromLatin1("Export failed: could not write %1").arg(path));
+        return;
+    }
+    emit opmlExported(count, path);
+}
+
+void StorageWorker::unsubscribe(int feedId)
+{
+    if (!ensureOpen()) {
+        emit operationFailed(QString::fromLatin1("Unsubscribe failed: database not open"));
+        return;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String("DELETE FROM subscriptions WHERE feed_id = ?"));
+    if (!query) {
+        emit operationFailed(QString::fromLatin1("Unsubscribe failed: could not prepare statement"));
+        return;
+    }
+    query->bindValue(0, feedId);
+
+    if (!m_statements.exec(query)) {
+        logError("unsubscribe", query->lastError());
+        emit operationFailed(QString::fromLatin1("Unsubscribe failed: %1").arg(query->lastError().text()));
+        return;
+    }
+
+    if (searchIndexAvailable()) {
+        QSqlQuery *unindex = m_statements.query(QLatin1String("DELETE FROM subscription_search WHERE docid = ?"));
+        if (unindex) {
+            unindex->bindValue(0, feedId);
+            if (!m_statements.exec(unindex)) {
+                logError("unindex subscription", unindex->lastError());
+            }
+        }
+    }
+
+    emit subscriptionRemoved(feedId);
+}
+
+QVariantMap StorageWorker::readEpisodeState(const QString &episodeId)
+{
+    QVariantMap state;
+    state.insert(QString::fromLatin1("positionMs"), 0);
+    state.insert(QString::fromLatin1("playState"), 0);
+    state.insert(QString::fromLatin1("durationSeconds"), 0);
+    if (episodeId.isEmpty() || !ensureOpen()) {
+        return state;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "SELECT played_position_ms, play_state, duration_seconds FROM episodes WHERE episode_id = ?"));
+    if (!query) {
+        return state;
+    }
+    query->bindValue(0, episodeId);
+    if (!m_statements.exec(query)) {
+        logError("load episode state", query->lastError());
+        return state;
+    }
+    if (query->next()) {
+        state.insert(QString::fromLatin1("positionMs"), query->value(0).toInt());
+        state.insert(QString::fromLatin1("playState"), query->value(1).toInt());
+        state.insert(QString::fromLatin1("durationSeconds"), query->value(2).toInt());
+    }
+    m_statements.finish(query);
+    return state;
+}
+
+void StorageWorker::loadEpisodeState(const QString &episodeId)
+{
+    emit episodeStateLoaded(episodeId, readEpisodeState(episodeId));
+}
+
+QVariantMap StorageWorker::readEpisodeStates(const QStringList &episodeIds)
+{
+    QVariantMap states;
+    if (!ensureOpen()) {
+        return states;
+    }
+
+    QStringList ids;
+    QSet<QString> seen;
+    for (int i = 0; i < episodeIds.size(); ++i) {
+        const QString &id = episodeIds.at(i);
+        if (!id.isEmpty() && !seen.contains(id)) {
+            seen.insert(id);
+            ids.append(id);
+        }
+    }
+    if (ids.isEmpty()) {
+        return states;
+    }
+
+    if (ids.size() > kEpisodeStateTempTableThreshold) {
+        readEpisodeStatesJoined(ids, states);
+        return states;
+    }
+
+    QString sql = QString::fromLatin1(
+        "SELECT episode_id, played_position_ms, play_state, duration_seconds "
+        "FROM episodes WHERE episode_id IN (?");
+    sql.append(QString::fromLatin1(", ?").repeated(kEpisodeStateBatchSize - 1));
+    sql.append(QLatin1Char(')'));
+    QSqlQuery *query = m_statements.query(sql);
+    if (!query) {
+        return states;
+    }
+
+    for (int start = 0; start < ids.size(); start += kEpisodeStateBatchSize) {
+        const int end = qMin(start + kEpisodeStateBatchSize, ids.size());
+        for (int slot = 0; slot < kEpisodeStateBatchSize; ++slot) {
+            const int index = start + slot;
+            query->bindValue(slot, ids.at(index < end ? index : end - 1));
+        }
+        if (!m_statements.exec(query)) {
+            logError("load episode states", query->lastError());
+            return states;
+        }
+        while (query->next()) {
+            insertEpisodeState(states, query);
+        }
+        m_statements.finish(query);
+    }
+    return states;
+}
+
+void StorageWorker::readEpisodeStatesJoined(const QStringList &ids, QVariantMap &states)
+{
+    QSqlDatabase db = m_statements.database();
+    QSqlQuery create(db);
+    if (!execTimed(create, db, QLatin1String(
+            "CREATE TEMP TABLE IF NOT EXISTS episode_state_lookup (episode_id TEXT PRIMARY KEY)"))) {
+        logError("create episode lookup", create.lastError());
+        return;
+    }
+
+    QSqlQuery *clear = m_statements.query(QLatin1String("DELETE FROM episode_state_lookup"));
+    QSqlQuery *insert = m_statements.query(QLatin1String(
+        "INSERT OR IGNORE INTO episode_state_lookup (episode_id) VALUES (?)"));
+    QSqlQuery *select = m_statements.query(QLatin1String(
+        "SELECT e.episode_id, e.played_position_ms, e.play_state, e.duration_seconds "
+        "FROM episode_state_lookup l JOIN episodes e ON e.episode_id = l.episode_id"));
+    if (!clear || !insert || !select) {
+        return;
+    }
+
+    // Temp tables are private to this connection; the transaction only
+    // saves a journal sync per inserted ID.
+    const bool inTransaction = m_statements.transaction();
+    bool ok = m_statements.exec(clear);
+    if (!ok) {
+        logError("clear episode lookup", clear->lastError());
+    }
+    for (int i = 0; ok && i < ids.size(); ++i) {
+        insert->bindValue(0, ids.at(i));
+        ok = m_statements.exec(insert);
+        if (!ok) {
+            logError("fill episode lookup", insert->lastError());
+        }
+    }
+    if (ok) {
+        if (m_statements.exec(select)) {
+            while (select->next()) {
+                insertEpisodeState(states, select);
+            }
+            m_statements.finish(select);
+        } else {
+            logError("join episode lookup", select->lastError());
+        }
+    }
+    if (inTransaction && !m_statements.commit()) {
+        logError("commit episode lookup", db.lastError());
+        m_statements.rollback();
+    }
+}
+
+void StorageWorker::loadEpisodeStates(const QStringList &episodeIds)
+{
+    emit episodeStatesLoaded(episodeIds, readEpisodeStates(episodeIds));
+}
+
+QVariantList StorageWorker::readCachedEpisodes(int feedId)
+{
+    QVariantList episodes;
+    if (feedId <= 0 || !ensureOpen()) {
+        return episodes;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "SELECT episode_id, position, title, enclosure_url, enclosure_type, duration_seconds, "
+        "date_published, description FROM episode_cache WHERE feed_id = ? ORDER BY position"));
+    if (!query) {
+        return episodes;
+    }
+    query->bindValue(0, feedId);
+    if (!m_statements.exec(query)) {
+        logError("load cached episodes", query->lastError());
+        return episodes;
+    }
+
+    // Same keys PodcastIndexProjection::episodeList() produces.
+    while (query->next()) {
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("id"), query->value(0).toString());
+        entry.insert(QString::fromLatin1("position"), query->value(1).toInt());
+        entry.insert(QString::fromLatin1("title"), query->value(2).toString());
+        entry.insert(QString::fromLatin1("enclosureUrl"), query->value(3).toString());
+        entry.insert(QString::fromLatin1("enclosureType"), query->value(4).toString());
+        entry.insert(QString::fromLatin1("duration"), query->value(5).toInt());
+        entry.insert(QString::fromLatin1("datePublished"), query->value(6).toLongLong());
+        entry.insert(QString::fromLatin1("description"), query->value(7).toString());
+        episodes.append(entry);
+    }
+    m_statements.finish(query);
+    return episodes;
+}
+
+bool StorageWorker::writeCachedEpisodes(int feedId, const QVariantList &episodes)
+{
+    if (feedId <= 0 || !ensureOpen()) {
+        return false;
+    }
+
+    // Diff against what is stored so an unchanged feed costs one read and
+    // no writes.
+    QHash<QString, QVariantMap> stale;
+    const QVariantList cached = readCachedEpisodes(feedId);
+    for (int i = 0; i < cached.size(); ++i) {
+        const QVariantMap entry = cached.at(i).toMap();
+        stale.insert(entry.value(QString::fromLatin1("id")).toString(), entry);
+    }
+
+    // Changed rows are updated in place rather than replaced so their rowid,
+    // which is also their docid in episode_search, stays put.
+    QSqlQuery *insert = m_statements.query(QLatin1String(
+        "INSERT INTO episode_cache "
+        "(position, title, enclosure_url, enclosure_type, duration_seconds, "
+        "date_published, description, cached_at, feed_id, episode_id) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+    QSqlQuery *update = m_statements.query(QLatin1String(
+        "UPDATE episode_cache SET position = ?, title = ?, enclosure_url = ?, enclosure_type = ?, "
+        "duration_seconds = ?, date_published = ?, description = ?, cached_at = ? "
+        "WHERE feed_id = ? AND episode_id = ?"));
+    QSqlQuery *remove = m_statements.query(QLatin1String(
+        "DELETE FROM episode_cache WHERE feed_id = ? AND episode_id = ?"));
+    if (!insert || !update || !remove) {
+        return false;
+    }
+
+    QSqlQuery *indexNew = 0;
+    QSqlQuery *reindex = 0;
+    QSqlQuery *unindex = 0;
+    if (searchIndexAvailable()) {
+        indexNew = m_statements.query(QLatin1String(
+            "INSERT INTO episode_search (docid, title, description) VALUES (?, ?, ?)"));
+        reindex = m_statements.query(QLatin1String(
+            "UPDATE episode_search SET title = ?, description = ? WHERE docid = "
+            "(SELECT rowid FROM episode_cache WHERE feed_id = ? AND episode_id = ?)"));
+        unindex = m_statements.query(QLatin1String(
+            "DELETE FROM episode_search WHERE docid = "
+            "(SELECT rowid FROM episode_cache WHERE feed_id = ? AND episode_id = ?)"));
+        if (!indexNew || !reindex || !unindex) {
+            return false;
+        }
+    }
+
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    const int now = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t());
+    bool ok = true;
+    int written = 0;
+    QSet<QString> seen;
+    for (int i = 0; ok && i < episodes.size(); ++i) {
+        const QVariantMap episode = episodes.at(i).toMap();
+        const QString episodeId = episode.value(QString::fromLatin1("id")).toString();
+        if (episodeId.isEmpty() || seen.contains(episodeId)) {
+            continue;
+        }
+        seen.insert(episodeId);
+        bool known = false;
+        QHash<QString, QVariantMap>::iterator existing = stale.find(episodeId);
+        if (existing != stale.end()) {
+            const bool unchanged = sameCachedEpisode(existing.value(), episode, i);
+            stale.erase(existing);
+            if (unchanged) {
+                continue;
+            }
+            known = true;
+        }
+        const QString title = episode.value(QString::fromLatin1("title")).toString();
+        const QString description = episode.value(QString::fromLatin1("description")).toString();
+        QSqlQuery *write = known ? update : insert;
+        write->bindValue(0, i);
+        write->bindValue(1, title);
+        write->bindValue(2, episode.value(QString::fromLatin1("enclosureUrl")).toString());
+        write->bindValue(3, episode.value(QString::fromLatin1("enclosureType")).toString());
+        write->bindValue(4, episode.value(QString::fromLatin1("duration")).toInt());
+        write->bindValue(5, episode.value(QString::fromLatin1("datePublished")).toLongLong());
+        write->bindValue(6, description);
+        write->bindValue(7, now);
+        write->bindValue(8, feedId);
+        write->bindValue(9, episodeId);
+        ok = m_statements.exec(write);
+        if (!ok) {
+            logError("cache episode", write->lastError());
+        } else if (known && reindex) {
+            reindex->bindValue(0, title);
+            reindex->bindValue(1, description);
+            reindex->bindValue(2, feedId);
+            reindex->bindValue(3, episodeId);
+            ok = m_statements.exec(reindex);
+            if (!ok) {
+                logError("reindex cached episode", reindex->lastError());
+            }
+        } else if (!known && indexNew) {
+            indexNew->bindValue(0, write->lastInsertId());
+            indexNew->bindValue(1, title);
+            indexNew->bindValue(2, description);
+            ok = m_statements.exec(indexNew);
+            if (!ok) {
+                logError("index cached episode", indexNew->lastError());
+            }
+        }
+        ++written;
+    }
+
+    QHash<QString, QVariantMap>::const_iterator gone = stale.constBegin();
+    for (; ok && gone != stale.constEnd(); ++gone) {
+        if (unindex) {
+            unindex->bindValue(0, feedId);
+            unindex->bindValue(1, gone.key());
+            ok = m_statements.exec(unindex);
+            if (!ok) {
+                logError("unindex cached episode", unindex->lastError());
+                break;
+            }
+        }
+        remove->bindValue(0, feedId);
+        remove->bindValue(1, gone.key());
+        ok = m_statements.exec(remove);
+        if (!ok) {
+            logError("drop cached episode", remove->lastError());
+        }
+    }
+
+    if (inTransaction) {
+        if (ok && !m_statements.commit()) {
+            logError("commit episode cache", db.lastError());
+            ok = false;
+        }
+        if (!ok) {
+            m_statements.rollback();
+        }
+    }
+    if (ok && (written > 0 || !stale.isEmpty())) {
+        qDebug() << "StorageManager: Episode cache for feed" << feedId
+                 << "updated" << written << "removed" << stale.size();
+    }
+    return ok;
+}
+
+void StorageWorker::checkpoint()
+{
+    if (!ensureOpen()) {
+        return;
+    }
+
+    // PASSIVE never waits on readers or writers; whatever it cannot copy
+    // now is picked up by the next call.
+    QElapsedTimer timer;
+    timer.start();
+    QSqlQuery *query = m_statements.query(QLatin1String("PRAGMA wal_checkpoint(PASSIVE)"));
+    if (!query) {
+        return;
+    }
+    if (!m_statements.exec(query)) {
+        logError("wal checkpoint", query->lastError());
+        return;
+    }
+    if (query->next()) {
+        qDebug() << "StorageManager: WAL checkpoint" << query->value(2).toInt()
+                 << "of" << query->value(1).toInt() << "frames in" << timer.elapsed() << "ms";
+    }
+    m_statements.finish(query);
+}
+
+int StorageWorker::pragmaValue(const char *pragma)
+{
+    QSqlQuery *query = m_statements.query(QLatin1String(pragma));
+    if (!query) {
+        return -1;
+    }
+    if (!m_statements.exec(query) || !query->next()) {
+        logError(QLatin1String(pragma), query->lastError());
+        return -1;
+    }
+    const int value = query->value(0).toInt();
+    m_statements.finish(query);
+    return value;
+}
+
+void StorageWorker::pruneStep()
+{
+    if (!ensureOpen()) {
+        emit pruneStepFinished(false);
+        return;
+    }
+
+    // Row selections, oldest stage first. Rows of unsubscribed feeds go
+    // after a week only if finished or never started; an episode played
+    // from search keeps its resume point until the 180-day rule.
+    static const char *const kEpisodeRows[] = {
+        "SELECT rowid FROM episodes WHERE COALESCE(last_played_at, 0) < ? "
+        "AND duration_seconds > 0 AND played_position_ms >= (duration_seconds - 30) * 1000 "
+        "ORDER BY rowid LIMIT %1",
+        "SELECT rowid FROM episodes WHERE COALESCE(last_played_at, 0) < ? ORDER BY rowid LIMIT %1",
+        "SELECT rowid FROM episodes WHERE COALESCE(last_played_at, 0) < ? "
+        "AND feed_id NOT IN (SELECT feed_id FROM subscriptions) "
+        "AND (COALESCE(played_position_ms, 0) = 0 "
+        "OR (duration_seconds > 0 AND played_position_ms >= (duration_seconds - 30) * 1000)) "
+        "ORDER BY rowid LIMIT %1",
+        0
+    };
+    static const char *const kCacheRows =
+        "SELECT rowid FROM episode_cache WHERE COALESCE(cached_at, 0) < ? "
+        "AND feed_id NOT IN (SELECT feed_id FROM subscriptions) ORDER BY rowid LIMIT %1";
+    const int episodeStages = 3;
+    const int now = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t());
+    const int cutoffs[] = {
+        now - kFinishedRetentionDays * kSecondsPerDay,
+        now - kAbandonedRetentionDays * kSecondsPerDay,
+        now - kUnsubscribedRetentionDays * kSecondsPerDay,
+        now - kUnsubscribedRetentionDays * kSecondsPerDay
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    bool ok = true;
+    int removed = 0;
+    while (ok && m_pruneStage <= episodeStages && timer.elapsed() < kVacuumStepBudgetMs) {
+        const bool cacheStage = m_pruneStage == episodeStages;
+        const QString rows = QString::fromLatin1(cacheStage ? kCacheRows : kEpisodeRows[m_pruneStage])
+            .arg(kPruneRowsPerChunk);
+        QStringList statements;
+        if (cacheStage && searchIndexAvailable()) {
+            // The same rows, unindexed first so their rowids still resolve.
+            statements << QString::fromLatin1("DELETE FROM episode_search WHERE docid IN (%1)").arg(rows);
+        }
+        statements << QString::fromLatin1("DELETE FROM %1 WHERE rowid IN (%2)")
+                      .arg(QLatin1String(cacheStage ? "episode_cache" : "episodes"), rows);
+        int deleted = 0;
+        for (int i = 0; ok && i < statements.size(); ++i) {
+            QSqlQuery *query = m_statements.query(statements.at(i));
+            ok = query != 0;
+            if (!ok) {
+                break;
+            }
+            query->bindValue(0, cutoffs[m_pruneStage]);
+            ok = m_statements.exec(query);
+            if (!ok) {
+                logError("prune", query->lastError());
+                break;
+            }
+            deleted = qMax(0, query->numRowsAffected());
+        }
+        removed += deleted;
+        if (ok && deleted < kPruneRowsPerChunk) {
+            ++m_pruneStage;
+        }
+    }
+    if (inTransaction) {
+        if (ok && !m_statements.commit()) {
+            logError("commit prune", db.lastError());
+            ok = false;
+        }
+        if (!ok) {
+            m_statements.rollback();
+        }
+    }
+    if (ok && removed > 0) {
+        qDebug() << "StorageManager: Pruned" << removed << "rows in" << timer.elapsed() << "ms";
+    }
+    const bool morePending = ok && m_pruneStage <= episodeStages;
+    if (!morePending) {
+        // A failed pass is not retried this session.
+        m_pruneStage = 0;
+    }
+    emit pruneStepFinished(morePending);
+}
+
+void StorageWorker::vacuumStep()
+{
+    if (!ensureOpen()) {
+        emit vacuumStepFinished(false);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int autoVacuum = pragmaValue("PRAGMA auto_vacuum");
+    if (autoVacuum < 0) {
+        emit vacuumStepFinished(false);
+        return;
+    }
+    if (autoVacuum != 2) {
+        // StorageManager only calls this while nothing is playing; the
+        // rewrite still blocks queued writes, hence the limits.
+        const int pageCount = pragmaValue("PRAGMA page_count");
+        const int freePages = pragmaValue("PRAGMA freelist_count");
+        const bool convert = !m_vacuumConversionChecked && pageCount > 0 && freePages >= 0
+            && freePages * kConvertMinFreeShare >= pageCount
+            && pageCount - freePages <= kConvertMaxLivePages;
+        m_vacuumConversionChecked = true;
+        if (convert) {
+            convertToIncrementalVacuum();
+            qDebug() << "StorageManager: Full VACUUM of" << pageCount << "pages took"
+                     << timer.elapsed() << "ms";
+        }
+        emit vacuumStepFinished(false);
+        return;
+    }
+
+    const QString chunkSql = QString::fromLatin1("PRAGMA incremental_vacuum(%1)").arg(kVacuumPagesPerChunk);
+    int freePages = pragmaValue("PRAGMA freelist_count");
+    int freed = 0;
+    while (freePages > 0 && timer.elapsed() < kVacuumStepBudgetMs) {
+        QSqlQuery *chunk = m_statements.query(chunkSql);
+        if (!chunk || !m_statements.exec(chunk)) {
+            if (chunk) {
+                logError("incremental vacuum", chunk->lastError());
+            }
+            freePages = 0;
+            break;
+        }
+        while (chunk->next()) {
+            // Drain the pragma; pages are released as it steps.
+        }
+        m_statements.finish(chunk);
+        const int remaining = pragmaValue("PRAGMA freelist_count");
+        freed += qMax(0, freePages - remaining);
+        freePages = remaining;
+    }
+    if (freed > 0) {
+        qDebug() << "StorageManager: Vacuum step freed" << freed << "pages in"
+                 << timer.elapsed() << "ms," << qMax(0, freePages) << "left";
+    }
+    emit vacuumStepFinished(freePages > 0);
+}
+
+void StorageWorker::convertToIncrementalVacuum()
+{
+    QSqlDatabase db = m_statements.database();
+    QSqlQuery convert(db);
+    m_statements.clear();
+    if (!execTimed(convert, db, QLatin1String("PRAGMA auto_vacuum=INCREMENTAL"))
+        || !execTimed(convert, db, QLatin1String("VACUUM"))) {
+        logError("enable incremental vacuum", convert.lastError());
+        return;
+    }
+    if (!searchIndexAvailable()) {
+        return;
+    }
+    // In one transaction, so local search never sees the tables empty.
+    if (!m_statements.transaction()) {
+        logError("begin search index rebuild", db.lastError());
+        return;
+    }
+    if (!rebuildSearchIndex(db) || !m_statements.commit()) {
+        qDebug() << "StorageManager: Search index rebuild after VACUUM failed";
+        m_statements.rollback();
+    }
+}
+
+QVariantList StorageWorker::readRecentEpisodes(int beforePlayedAt, const QString &beforeEpisodeId,
+                                               int limit, bool inProgressOnly)
+{
+    QVariantList page;
+    if (limit <= 0 || !ensureOpen()) {
+        return page;
+    }
+
+    // Keyset paging: continue strictly after the last row of the previous
+    // page in (last_played_at DESC, episode_id DESC) order, so every page
+    // is an index range scan no matter how deep the user scrolls.
+    QString sql = QString::fromLatin1(
+        "SELECT episode_id, feed_id, title, audio_url, duration_seconds, played_position_ms, "
+        "last_played_at, enclosure_type, published_at, play_state FROM episodes "
+        "WHERE last_played_at <= ? AND (last_played_at < ? OR episode_id < ?)");
+    if (inProgressOnly) {
+        sql += QString::fromLatin1(
+            " AND played_position_ms > 0"
+            " AND (duration_seconds IS NULL OR duration_seconds <= 0"
+            " OR played_position_ms < (duration_seconds - 30) * 1000)");
+    }
+    sql += QString::fromLatin1(" ORDER BY last_played_at DESC, episode_id DESC LIMIT ?");
+
+    QSqlQuery *query = m_statements.query(sql);
+    if (!query) {
+        return page;
+    }
+    query->bindValue(0, beforePlayedAt);
+    query->bindValue(1, beforePlayedAt);
+    query->bindValue(2, beforeEpisodeId);
+    query->bindValue(3, limit);
+    if (!m_statements.exec(query)) {
+        logError("load recent episodes", query->lastError());
+        return page;
+    }
+    while (query->next()) {
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("episodeId"), query->value(0).toString());
+        entry.insert(QString::fromLatin1("feedId"), query->value(1).toInt());
+        entry.insert(QString::fromLatin1("title"), query->value(2).toString());
+        entry.insert(QString::fromLatin1("audioUrl"), query->value(3).toString());
+        entry.insert(QString::fromLatin1("durationSeconds"), query->value(4).toInt());
+        entry.insert(QString::fromLatin1("positionMs"), query->value(5).toInt());
+        entry.insert(QString::fromLatin1("lastPlayedAt"), query->value(6).toInt());
+        entry.insert(QString::fromLatin1("enclosureType"), query->value(7).toString());
+        entry.insert(QString::fromLatin1("publishedAt"), query->value(8).toInt());
+        entry.insert(QString::fromLatin1("playState"), query->value(9).toInt());
+        page.append(entry);
+    }
+    m_statements.finish(query);
+    return page;
+}
+
+void StorageWorker::loadRecentEpisodes(int token, int beforePlayedAt, const QString &beforeEpisodeId,
+                                       int limit, bool inProgressOnly)
+{
+    emit recentEpisodesLoaded(token, readRecentEpisodes(beforePlayedAt, beforeEpisodeId,
+                                                        limit, inProgressOnly));
+}
+
+QVariantList StorageWorker::readLocalSearch(const QString &term)
+{
+    QVariantList results;
+    QStringList words = searchWords(term);
+    if (words.isEmpty() || !ensureOpen()) {
+        return results;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool fts = searchIndexAvailable();
+    QSqlQuery *feeds = 0;
+    QSqlQuery *episodes = 0;
+    if (fts) {
+        feeds = m_statements.query(QLatin1String(
+            "SELECT s.feed_id, s.title, s.image, s.guid, s.image_url_hash FROM subscription_search "
+            "JOIN subscriptions s ON s.feed_id = subscription_search.docid "
+            "WHERE subscription_search MATCH ? ORDER BY s.title LIMIT ?"));
+        episodes = m_statements.query(QLatin1String(
+            "SELECT c.feed_id, c.episode_id, c.title, c.description, "
+            "s.title, s.image, s.guid, s.image_url_hash FROM episode_search "
+            "JOIN episode_cache c ON c.rowid = episode_search.docid "
+            "LEFT JOIN subscriptions s ON s.feed_id = c.feed_id "
+            "WHERE episode_search MATCH ? ORDER BY c.date_published DESC LIMIT ?"));
+    } else {
+        words = words.mid(0, kLikeSearchMaxWords);
+        feeds = m_statements.query(QLatin1String(
+            "SELECT s.feed_id, s.title, s.image, s.guid, s.image_url_hash FROM subscriptions s WHERE ")
+            + likeCondition(QStringList() << QLatin1String("s.title"), words.size())
+            + QLatin1String(" ORDER BY s.title LIMIT ?"));
+        episodes = m_statements.query(QLatin1String(
+            "SELECT c.feed_id, c.episode_id, c.title, c.description, "
+            "s.title, s.image, s.guid, s.image_url_hash FROM episode_cache c "
+            "LEFT JOIN subscriptions s ON s.feed_id = c.feed_id WHERE ")
+            + likeCondition(QStringList() << QLatin1String("c.title") << QLatin1String("c.description"),
+                            words.size())
+            + QLatin1String(" ORDER BY c.date_published DESC LIMIT ?"));
+    }
+    if (!feeds || !episodes) {
+        return results;
+    }
+    const QString match = ftsMatchExpression(words);
+
+    int bound = 0;
+    if (fts) {
+        feeds->bindValue(bound++, match);
+    } else {
+        for (int i = 0; i < words.size(); ++i) {
+            feeds->bindValue(bound++, likePattern(words.at(i)));
+        }
+    }
+    feeds->bindValue(bound, kLocalSearchLimit);
+    if (!m_statements.exec(feeds)) {
+        logError("local search subscriptions", feeds->lastError());
+        return results;
+    }
+    // Same keys as PodcastIndexClient's podcast entries, plus kind.
+    while (feeds->next()) {
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("kind"), QString::fromLatin1("podcast"));
+        entry.insert(QString::fromLatin1("feedId"), feeds->value(0).toInt());
+        entry.insert(QString::fromLatin1("title"), feeds->value(1).toString());
+        entry.insert(QString::fromLatin1("image"), feeds->value(2).toString());
+        entry.insert(QString::fromLatin1("guid"), feeds->value(3).toString());
+        entry.insert(QString::fromLatin1("imageUrlHash"), feeds->value(4).toString());
+        results.append(entry);
+    }
+    m_statements.finish(feeds);
+
+    bound = 0;
+    if (fts) {
+        episodes->bindValue(bound++, match);
+    } else {
+        for (int i = 0; i < words.size(); ++i) {
+            episodes->bindValue(bound++, likePattern(words.at(i)));
+            episodes->bindValue(bound++, likePattern(words.at(i)));
+        }
+    }
+    episodes->bindValue(bound, kLocalSearchLimit);
+    if (!m_statements.exec(episodes)) {
+        logError("local search episodes", episodes->lastError());
+        return results;
+    }
+    while (episodes->next()) {
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("kind"), QString::fromLatin1("episode"));
+        entry.insert(QString::fromLatin1("feedId"), episodes->value(0).toInt());
+        entry.insert(QString::fromLatin1("episodeId"), episodes->value(1).toString());
+        entry.insert(QString::fromLatin1("title"), episodes->value(2).toString());
+        entry.insert(QString::fromLatin1("description"), episodes->value(3).toString());
+        entry.insert(QString::fromLatin1("podcastTitle"), episodes->value(4).toString());
+        entry.insert(QString::fromLatin1("image"), episodes->value(5).toString());
+        entry.insert(QString::fromLatin1("guid"), episodes->value(6).toString());
+        entry.insert(QString::fromLatin1("imageUrlHash"), episodes->value(7).toString());
+        results.append(entry);
+    }
+    m_statements.finish(episodes);
+
+    qDebug() << "StorageManager: Local search" << (fts ? "(fts)" : "(like)")
+             << results.size() << "hits in" << timer.elapsed() << "ms";
+    return results;
+}
+
+void StorageWorker::searchLocal(const QString &term)
+{
+    emit localSearchFinished(term, readLocalSearch(term));
+}
+
+void StorageWorker::loadCachedEpisodes(int feedId)
+{
+    emit cachedEpisodesLoaded(feedId, readCachedEpisodes(feedId));
+}
+
+void StorageWorker::saveCachedEpisodes(int feedId, const QVariantList &episodes)
+{
+    writeCachedEpisodes(feedId, episodes);
+}
+
+bool StorageWorker::writeProgress(const QVariantList &entries)
+{
+    if (entries.isEmpty()) {
+        return true;
+    }
+    if (!ensureOpen()) {
+        return false;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "INSERT OR REPLACE INTO episodes "
+        "(episode_id, feed_id, title, audio_url, duration_seconds, "
+        "played_position_ms, last_played_at, enclosure_type, published_at, play_state) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+    if (!query) {
+        return false;
+    }
+
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    if (!inTransaction) {
+        logError("begin progress flush", db.lastError());
+    }
+
+    bool ok = true;
+    for (int i = 0; i < entries.size(); ++i) {
+        const QVariantMap entry = entries.at(i).toMap();
+        query->bindValue(0, entry.value(QString::fromLatin1("episodeId")));
+        query->bindValue(1, entry.value(QString::fromLatin1("feedId")));
+        query->bindValue(2, entry.value(QString::fromLatin1("title")));
+        query->bindValue(3, entry.value(QString::fromLatin1("audioUrl")));
+        query->bindValue(4, entry.value(QString::fromLatin1("durationSeconds")));
+        query->bindValue(5, entry.value(QString::fromLatin1("positionMs")));
+        query->bindValue(6, entry.value(QString::fromLatin1("lastPlayedAt")));
+        query->bindValue(7, entry.value(QString::fromLatin1("enclosureType")));
+        query->bindValue(8, entry.value(QString::fromLatin1("publishedAt")));
+        query->bindValue(9, entry.value(QString::fromLatin1("playState")));
+        if (!m_statements.exec(query)) {
+            logError("save episode progress", query->lastError());
+            ok = false;
+        }
+    }
+
+    if (inTransaction && !m_statements.commit()) {
+        logError("commit progress flush", db.lastError());
+        m_statements.rollback();
+        return false;
+    }
+    return ok;
+}
+
+void StorageWorker::saveProgress(const QVariantList &entries)
+{
+    writeProgress(entries);
+    emit progressSaved();
+}
+
+QVariantList StorageWorker::readSearchHistory()
+{
+    QVariantList results;
+    if (!ensureOpen()) {
+        return results;
+    }
+
+    QSqlQuery *query = m_statements.query(QLatin1String(
+        "SELECT term, searched_at FROM search_history ORDER BY searched_at DESC, rowid DESC"));
+    if (!query) {
+        return results;
+    }
+    if (!m_statements.exec(query)) {
+        logError("load search history", query->lastError());
+        return results;
+    }
+
+    while (query->next()) {
+        QVariantMap entry;
+        entry.insert(QString::fromLatin1("term"), query->value(0));
+        entry.insert(QString::fromLatin1("searchedAt"), query->value(1).toInt());
+        results.append(entry);
+    }
+    m_statements.finish(query);
+    return results;
+}
+
+void StorageWorker::loadSearchHistory()
+{
+    if (!ensureOpen()) {
+        return;
+    }
+    emit searchHistoryLoaded(readSearchHistory());
+}
+
+void StorageWorker::saveSearchHistory(const QVariantList &entries)
+{
+    if (!ensureOpen()) {
+        return;
+    }
+
+    QSqlQuery *clear = m_statements.query(QLatin1String("DELETE FROM search_history"));
+    QSqlQuery *insert = m_statements.query(QLatin1String(
+        "INSERT OR REPLACE INTO search_history (term, searched_at) VALUES (?, ?)"));
+    if (!clear || !insert) {
+        return;
+    }
+
+    QSqlDatabase db = m_statements.database();
+    const bool inTransaction = m_statements.transaction();
+    bool ok = m_statements.exec(clear);
+    if (!ok) {
+        logError("clear search history", clear->lastError());
+    }
+    // Oldest first, so rowid order breaks ties in searched_at on reload.
+    for (int i = entries.size() - 1; ok && i >= 0; --i) {
+        const QVariantMap entry = entries.at(i).toMap();
+        insert->bindValue(0, entry.value(QString::fromLatin1("term")).toString());
+        insert->bindValue(1, entry.value(QString::fromLatin1("searchedAt")).toInt());
+        ok = m_statements.exec(insert);
+        if (!ok) {
+            logError("save search history", insert->lastError());
+        }
+    }
+    if (inTransaction) {
+        if (ok && !m_statements.commit()) {
+            logError("commit search history", db.lastError());
+            ok = false;
+        }
+        if (!ok) {
+            m_statements.rollback();
+        }
+    }
+}
+
+QString StorageWorker::dbPath(bool useCachedLocation)
+{
+    QString base;
+    m_dbPathFromCache = false;
+#ifdef Q_OS_SYMBIAN
+    // Probing opens a throwaway database per candidate, so reuse the
+    // location that worked last time. initDb() re-probes if it fails to open.
+    if (useCachedLocation) {
+        const QString cached = readDbLocationMarker();
+        if (!cached.isEmpty()) {
+            m_dbPathLog += QString::fromLatin1("Cached location: %1\n").arg(cached);
+            m_dbPathFromCache = true;
+            m_dbPath = QDir::toNativeSeparators(QDir(cached).filePath(QLatin1String("podin.db")));
+            return m_dbPath;
+        }
+        m_dbPathLog += QLatin1String("No cached location, probing\n");
+    }
+
+    // Try multiple locations on Symbian
+    // For self-signed apps, only the private directory is writable
+    QStringList candidates;
+
+    // 1. App's private directory from QDesktopServices (works for self-signed)
+    QString dataPath = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+    if (!dataPath.isEmpty()) {
+        candidates << dataPath;
+    }
+    m_dbPathLog += QString::fromLatin1("DataLocation: %1\n").arg(dataPath.isEmpty() ? QLatin1String("(empty)") : dataPath);
+
+    // 2. Try app's private directory using QCoreApplication path
+    QString appPrivate = QCoreApplication::applicationDirPath();
+    if (!appPrivate.isEmpty() && !candidates.contains(appPrivate)) {
+        candidates << appPrivate;
+    }
+    m_dbPathLog += QString::fromLatin1("AppDirPath: %1\n").arg(appPrivate.isEmpty() ? QLatin1String("(empty)") : appPrivate);
+
+    // 3. Try C:\Data\Podin (requires WriteUserData capability - won't work self-signed)
+    candidates << QLatin1String(AppConfig::kPhoneBase);
+
+    // 4. Try E:\Podin (memory card - might work)
+    candidates << QLatin1String(AppConfig::kMemoryCardBase);
+
+    // 5. Try temp location as last resort
+    QString tempPath = QDir::tempPath();
+    if (!tempPath.isEmpty() && !candidates.contains(tempPath)) {
+        candidates << tempPath;
+    }
+    m_dbPathLog += QString::fromLatin1("TempPath: %1\n").arg(tempPath.isEmpty() ? QLatin1String("(empty)") : tempPath);
+    m_dbPathLog += QString::fromLatin1("Candidates: %1\n").arg(candidates.join(QLatin1String(", ")));
+    
+    // Determine which driver will actually be used
+    QString testDriver = QLatin1String("QSQLITE");
+    if (QSqlDatabase::isDriverAvailable(QLatin1String("QSYMSQL"))) {
+        testDriver = QLatin1String("QSYMSQL");
+    }
+    m_dbPathLog += QString::fromLatin1("TestDriver: %1\n").arg(testDriver);
+
+    // Try each candidate - test with actual SQLite open
+    for (int i = 0; i < candidates.size(); ++i) {
+        QString candidatePath = candidates.at(i);
+        QDir dir(candidatePath);
+
+        // On Symbian, paths under /private/ are data-caged:
+        // QDir::exists() returns false even though the directory exists,
+        // and mkpath() fails because the /private/ parent is system-owned.
+        // Skip the exists/mkdir check for these paths and go straight to
+        // the SQLite write test.
+        bool isPrivatePath = candidatePath.contains(QLatin1String("/private/"),
+                                                     Qt::CaseInsensitive);
+        if (!isPrivatePath) {
+            if (!dir.exists()) {
+                if (!dir.mkpath(QLatin1String("."))) {
+                    m_dbPathLog += QString::fromLatin1("mkdir FAIL: %1\n").arg(candidatePath);
+                    qDebug() << "StorageManager: mkdir failed for" << candidatePath;
+                    continue;
+                }
+                m_dbPathLog += QString::fromLatin1("mkdir OK: %1\n").arg(candidatePath);
+            } else {
+                m_dbPathLog += QString::fromLatin1("exists: %1\n").arg(candidatePath);
+            }
+        } else {
+            m_dbPathLog += QString::fromLatin1("private (skip mkdir): %1\n").arg(candidatePath);
+        }
+
+        // Test by actually opening SQLite database with the same driver
+        // that initDb() will use
+        QString testDbPath = QDir::toNativeSeparators(
+            dir.filePath(QLatin1String("test.db")));
+        if (QSqlDatabase::contains(QLatin1String("path_test"))) {
+            QSqlDatabase::removeDatabase(QLatin1String("path_test"));
+        }
+
+        QSqlDatabase testDb = QSqlDatabase::addDatabase(testDriver, QLatin1String("path_test"));
+        testDb.setDatabaseName(testDbPath);
+        if (testDb.open()) {
+            QSqlQuery q(testDb);
+            if (q.exec(QLatin1String("CREATE TABLE IF NOT EXISTS test(id INTEGER)"))) {
+                testDb.close();
+                QSqlDatabase::removeDatabase(QLatin1String("path_test"));
+                QFile::remove(testDbPath);
+                base = candidatePath;
+                m_dbPathLog += QString::fromLatin1("SQLite OK: %1\n").arg(candidatePath);
+                qDebug() << "StorageManager: Using db path:" << base;
+                break;
+            }
+            m_dbPathLog += QString::fromLatin1("SQLite CREATE FAIL: %1\n").arg(candidatePath);
+        } else {
+            m_dbPathLog += QString::fromLatin1("SQLite open FAIL: %1 - %2\n").arg(candidatePath, testDb.lastError().text());
+        }
+        testDb.close();
+        QSqlDatabase::removeDatabase(QLatin1String("path_test"));
+        QFile::remove(testDbPath);
+        qDebug() << "StorageManager: SQLite test failed for" << candidatePath;
+    }
+
+    // Last resort: in-memory database (data won't persist)
+    if (base.isEmpty()) {
+        qWarning() << "StorageManager: No writable path found, using in-memory database";
+        m_dbPathLog += QLatin1String("FALLBACK: in-memory\n");
+        m_dbPath = QLatin1String(":memory:");
+        return m_dbPath;
+    }
+    if (writeDbLocationMarker(base)) {
+        m_dbPathLog += QString::fromLatin1("Cached location saved: %1\n").arg(base);
+    }
+#else
+    Q_UNUSED(useCachedLocation);
+    base = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+    m_dbPathLog += QString::fromLatin1("DataLocation: %1\n").arg(base.isEmpty() ? QLatin1String("(empty)") : base);
+    if (base.isEmpty()) {
+        base = QDir::homePath() + QLatin1String("/.podin");
+        m_dbPathLog += QString::fromLatin1("Using home fallback: %1\n").arg(base);
+    }
+#endif
+    QDir dir(base);
+    bool baseIsPrivate = base.contains(QLatin1String("/private/"), Qt::CaseInsensitive);
+    if (!baseIsPrivate && !dir.exists()) {
+        if (dir.mkpath(QLatin1String("."))) {
+            m_dbPathLog += QString::fromLatin1("Created dir: %1\n").arg(base);
+        } else {
+            m_dbPathLog += QString::fromLatin1("mkdir FAIL: %1\n").arg(base);
+        }
+    }
+    m_dbPath = QDir::toNativeSeparators(dir.filePath(QLatin1String("podin.db")));
+    return m_dbPath;
+}
+
+bool StorageWorker::ensureOpen()
+{
+    QSqlDatabase db = m_statements.database();
+    if (db.isValid() && db.isOpen()) {
+        return true;
+    }
+
+    if (!db.isValid()) {
+        return false;
+    }
+    // Prepared statements belong to the old handle; drop them before reopening.
+    m_statements.clear();
+    if (!db.open()) {
+        logError("open db", db.lastError());
+        return false;
+    }
+    applyTuning(db);
+    return true;
+}
+
+bool StorageWorker::searchIndexAvailable()
+{
+    if (m_searchIndex < 0) {
+        const QSqlDatabase db = m_statements.database();
+        QSqlQuery query(db);
+        if (!execTimed(query, db, QLatin1String("SELECT 1 FROM sqlite_master WHERE name = 'episode_search'"))) {
+            logError("probe search index", query.lastError());
+            return false;
+        }
+        m_searchIndex = query.next() ? 1 : 0;
+    }
+    return m_searchIndex == 1;
+}
+
+int StorageWorker::schemaVersion()
+{
+    // The only statement an up-to-date database pays for at startup.
+    const QSqlDatabase db = m_statements.database();
+    QSqlQuery query(db);
+    if (!execTimed(query, db, QLatin1String("PRAGMA user_version")) || !query.next()) {
+        logError("read user_version", query.lastError());
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+bool StorageWorker::runMigrations(QSqlDatabase &db, int current)
+{
+    if (current < 0) {
+        return false;
+    }
+    const int latest = kMigrations[kMigrationCount - 1].version;
+    if (current >= latest) {
+        return true;
+    }
+
+    if (current == 0) {
+        // journal_mode and auto_vacuum are persistent in the file but cannot
+        // change inside a transaction (auto_vacuum only before the first
+        // table), so set them once before the first migration.
+        QSqlQuery journalQuery(db);
+        if (!execTimed(journalQuery, db, QLatin1String("PRAGMA auto_vacuum=INCREMENTAL"))) {
+            qDebug() << "StorageManager: Could not set auto_vacuum";
+        }
+        if (!execTimed(journalQuery, db, QLatin1String("PRAGMA journal_mode=WAL"))) {
+            qDebug() << "StorageManager: Could not set journal_mode";
+        }
+    }
+
+    for (int i = 0; i < kMigrationCount; ++i) {
+        const Migration &migration = kMigrations[i];
+        if (migration.version <= current) {
+            continue;
+        }
+        if (!m_statements.transaction()) {
+            logError("begin migration", db.lastError());
+            return false;
+        }
+        QSqlQuery bump(db);
+        if (!migration.apply(db)
+            || !execTimed(bump, db, QString::fromLatin1("PRAGMA user_version = %1").arg(migration.version))) {
+            logError(QString::fromLatin1("migration %1").arg(migration.version), bump.lastError());
+            m_statements.rollback();
+            return false;
+        }
+        if (!m_statements.commit()) {
+            logError(QString::fromLatin1("commit migration %1").arg(migration.version), db.lastError());
+            m_statements.rollback();
+            return false;
+        }
+        qDebug("StorageManager: Migrated schema to version %d", migration.version);
+    }
+    return true;
+}
+
+void StorageWorker::initDb()
+{
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    QStringList drivers = QSqlDatabase::drivers();
+    qDebug() << "StorageManager: Available SQL drivers:" << drivers;
+    m_dbPathLog += QString::fromLatin1("Drivers: %1\n").arg(drivers.join(QLatin1String(", ")));
+
+    if (QSqlDatabase::contains(m_connectionName)) {
+        m_dbStatus = QLatin1String("already exists");
+        m_statements.setDatabase(QSqlDatabase::database(m_connectionName, false));
+        return;
+    }
+
+    QString path = dbPath(true);
+    qDebug() << "StorageManager: Opening database at:" << path;
+
+    const QString driverName = preferredDriver();
+    if (!driverName.isEmpty()) {
+        qDebug() << "StorageManager: Using" << driverName << "driver";
+    } else {
+        m_dbStatus = QString::fromLatin1("no driver available: %1").arg(drivers.join(QLatin1String(", ")));
+        qWarning("Storage error (init db): No SQLite driver available. Drivers: %s",
+                 qPrintable(drivers.join(QLatin1String(", "))));
+        return;
+    }
+    m_dbPathLog += QString::fromLatin1("Using driver: %1\n").arg(driverName);
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(driverName, m_connectionName);
+    db.setDatabaseName(path);
+
+    bool opened = db.open();
+    m_statements.setDatabase(db);
+    int version = opened ? schemaVersion() : -1;
+    if (version < 0 && m_dbPathFromCache) {
+        // The remembered location went away (e.g. memory card removed).
+        m_dbPathLog += QString::fromLatin1("Cached location failed: %1\n").arg(path);
+        qDebug() << "StorageManager: Cached db location failed, probing again";
+#ifdef Q_OS_SYMBIAN
+        removeDbLocationMarker();
+#endif
+        m_statements.clear();
+        db.close();
+        path = dbPath(false);
+        db.setDatabaseName(path);
+        opened = db.open();
+        version = opened ? schemaVersion() : -1;
+    }
+
+    if (!opened) {
+        m_dbStatus = QString::fromLatin1("open failed: %1").arg(db.lastError().text());
+        qWarning("Storage error (init db): Failed to open database at %s - %s",
+                 qPrintable(path),
+                 qPrintable(db.lastError().text()));
+        return;
+    }
+
+    m_dbStatus = QLatin1String("open");
+    qDebug() << "StorageManager: Database opened successfully";
+    applyTuning(db);
+
+    const qint64 openMs = startupTimer.elapsed();
+    const bool migrated = runMigrations(db, version);
+    const qint64 totalMs = startupTimer.elapsed();
+    if (!migrated) {
+        m_dbStatus = QLatin1String("migration failed");
+    }
+    qDebug() << "StorageManager: Startup DB time" << totalMs << "ms (path+open"
+             << openMs << "ms, schema" << (totalMs - openMs) << "ms)";
+    m_dbPathLog += QString::fromLatin1("Startup DB time: %1 ms\n").arg(totalMs);
+}
@@ -0,0 +1,158 @@
+#ifndef STORAGEWORKER_H
+#define STORAGEWORKER_H
+
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
+
+#include "StatementCache.h"
+
+// Owns one SQLite connection and runs every statement on it. StorageManager
+// moves it onto a dedicated thread and talks to it only through queued slot
+// calls; results come back as signals. The read*/write* helpers run
+// synchronously and must only be called from the thread the worker lives in.
+//
+// StorageManager keeps two: the ReadWrite worker opens (and migrates) the
+// database and takes every write; a ReadOnly worker on a second thread is
+// pointed at the same file with openReadOnly() and serves the load* and
+// search slots. Write slots fail on a ReadOnly worker.
+class StorageWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Connection {
+        ReadWrite,
+        ReadOnly
+    };
+
+    explicit StorageWorker(Connection connection = ReadWrite, QObject *parent = 0);
+    ~StorageWorker();
+
+    QVariantMap readSettings();
+    QVariantList readSubscriptions();
+    QVariantMap readEpisodeState(const QString &episodeId);
+    // episodeId -> state map, only for IDs that have a stored row.
+    QVariantMap readEpisodeStates(const QStringList &episodeIds);
+    QVariantList readSearchHistory();
+    bool writeProgress(const QVariantList &entries);
+    // Per-feed episode list cache, in PodcastIndexClient's episode shape.
+    QVariantList readCachedEpisodes(int feedId);
+    bool writeCachedEpisodes(int feedId, const QVariantList &episodes);
+    // One page of the recently played list, newest first, strictly after
+    // the (beforePlayedAt, beforeEpisodeId) cursor.
+    QVariantList readRecentEpisodes(int beforePlayedAt, const QString &beforeEpisodeId,
+                                    int limit, bool inProgressOnly);
+    // Subscriptions, then cached episodes, matching every word of term
+    // (word prefixes through FTS3, substring LIKE where FTS3 is missing).
+    QVariantList readLocalSearch(const QString &term);
+
+public slots:
+    void open();
+    // ReadOnly workers only, after the ReadWrite worker has opened path.
+    void openReadOnly(const QString &path);
+    void close();
+    // Copies committed WAL frames into the database (PASSIVE, never blocks).
+    void checkpoint();
+
+    // Idle maintenance: drop stale episode rows, then reclaim free pages a
+    // few at a time; each pruneStep() and vacuumStep() stays within a small
+    // time budget and reports whether another step is needed.
+    // Files created without auto_vacuum only get the one-off full VACUUM
+    // that converts them when it is small and clearly worth it.
+    void pruneStep();
+    void vacuumStep();
+
+    void loadSettings();
+    void saveSettings(const QVariantMap &settings);
+
+    // Logs the per-statement timings and emits statementStatsDumped().
+    void dumpStatementStats();
+
+    void loadSubscriptions();
+    void subscribe(int feedId, const QString &title, const QString &image,
+                   const QString &guid, const QString &imageUrlHash,
+                   const QString &feedUrl = QString());
+    void unsubscribe(int feedId);
+
+    // Bulk paths: each runs in one transaction, skips feeds that are already
+    // subscribed and reports once through subscriptionsImported(), after a
+    // single subscriptionsLoaded() if anything was added.
+    void importOpml(const QString &path);
+    // failed: feeds the caller could not resolve, passed through to the report.
+    void subscribeAll(const QVariantList &feeds, int failed);
+    void exportOpml(const QString &path);
+
+    void loadEpisodeState(const QString &episodeId);
+    void loadEpisodeStates(const QStringList &episodeIds);
+    void saveProgress(const QVariantList &entries);
+
+    void loadRecentEpisodes(int token, int beforePlayedAt, const QString &beforeEpisodeId,
+                            int limit, bool inProgressOnly);
+
+    void loadCachedEpisodes(int feedId);
+    void saveCachedEpisodes(int feedId, const QVariantList &episodes);
+
+    void searchLocal(const QString &term);
+
+    void loadSearchHistory();
+    // Replaces the table with entries ([{ term, searchedAt }], newest first).
+    void saveSearchHistory(const QVariantList &entries);
+
+signals:
+    void opened(const QString &dbPath, const QString &dbStatus, const QString &dbPathLog);
+    void readOnlyOpened(bool ok);
+    void settingsLoaded(const QVariantMap &settings);
+    void subscriptionsLoaded(const QVariantList &subscriptions);
+    void subscriptionSaved(const QVariantMap &subscription);
+    void subscriptionRemoved(int feedId);
+    // unresolved: { feedUrl, title } for OPML feeds without a Podcast Index ID.
+    // failed: OPML feeds that could not be found on Podcast Index.
+    void subscriptionsImported(int added, const QVariantList &unresolved, int failed);
+    void opmlExported(int count, const QString &path);
+    // After each saveProgress() transaction, committed or not.
+    void progressSaved();
+    void episodeStateLoaded(const QString &episodeId, const QVariantMap &episodeState);
+    void episodeStatesLoaded(const QStringList &episodeIds, const QVariantMap &episodeStates);
+    void cachedEpisodesLoaded(int feedId, const QVariantList &episodes);
+    void recentEpisodesLoaded(int token, const QVariantList &page);
+    void searchHistoryLoaded(const QVariantList &history);
+    void localSearchFinished(const QString &term, const QVariantList &results);
+    void operationFailed(const QString &message);
+    void pruneStepFinished(bool morePending);
+    void vacuumStepFinished(bool morePending);
+    void statementStatsDumped(const QVariantList &stats);
+
+private:
+    QString dbPath(bool useCachedLocation);
+    bool ensureOpen();
+    void initDb();
+    int schemaVersion();
+    int pragmaValue(const char *pragma);
+    // Full VACUUM into auto_vacuum=INCREMENTAL, then refills the search index.
+    void convertToIncrementalVacuum();
+    bool runMigrations(QSqlDatabase &db, int current);
+    void readEpisodeStatesJoined(const QStringList &ids, QVariantMap &states);
+    // Whether migration 4 could create the FTS3 tables; checked once.
+    bool searchIndexAvailable();
+    bool indexSubscription(int feedId, const QString &title);
+    // INSERT OR IGNORE of one feed map; added tells whether a row was new.
+    bool insertSubscription(const QVariantMap &feed, bool *added);
+    void applyProfilerSettings(const QVariantMap &settings);
+
+    QString m_connectionName;
+    StatementCache m_statements;
+    QString m_dbPath;
+    QString m_dbStatus;
+    QString m_dbPathLog;
+    bool m_dbPathFromCache;
+    int m_searchIndex;
+    // Set once vacuumStep() has considered converting a legacy file.
+    bool m_vacuumConversionChecked;
+    // Next pruneStep() selection to work on; 0 when no pass is running.
+    int m_pruneStage;
+};
+
+#endif // STORAGEWORKER_H
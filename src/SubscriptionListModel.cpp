@@ -0,0 +1,196 @@
+#include "SubscriptionListModel.h"
+
+#include <QtCore/QtAlgorithms>
+
+SubscriptionListModel::SubscriptionListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    QHash<int, QByteArray> roles;
+    roles.insert(FeedIdRole, "feedId");
+    roles.insert(TitleRole, "title");
+    roles.insert(ImageRole, "image");
+    roles.insert(LastUpdatedRole, "lastUpdated");
+    roles.insert(GuidRole, "guid");
+    roles.insert(ImageUrlHashRole, "imageUrlHash");
+    setRoleNames(roles);
+}
+
+int SubscriptionListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_entries.size();
+}
+
+QVariant SubscriptionListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_entries.size()) {
+        return QVariant();
+    }
+
+    const Entry &entry = m_entries.at(index.row());
+    switch (role) {
+    case FeedIdRole:
+        return entry.feedId;
+    case Qt::DisplayRole:
+    case TitleRole:
+        return entry.title;
+    case ImageRole:
+        return entry.image;
+    case LastUpdatedRole:
+        return entry.lastUpdated;
+    case GuidRole:
+        return entry.guid;
+    case ImageUrlHashRole:
+        return entry.imageUrlHash;
+    default:
+        return QVariant();
+    }
+}
+
+int SubscriptionListModel::count() const
+{
+    return m_entries.size();
+}
+
+bool SubscriptionListModel::contains(int feedId) const
+{
+    return m_titles.contains(feedId);
+}
+
+QVariantMap SubscriptionListModel::get(int row) const
+{
+    if (row < 0 || row >= m_entries.size()) {
+        return QVariantMap();
+    }
+    return entryToMap(m_entries.at(row));
+}
+
+QVariantList SubscriptionListModel::toVariantList() const
+{
+    QVariantList list;
+    for (int i = 0; i < m_entries.size(); ++i) {
+        list.append(entryToMap(m_entries.at(i)));
+    }
+    return list;
+}
+
+void SubscriptionListModel::setSubscriptions(const QVariantList &subscriptions)
+{
+    const int oldCount = m_entries.size();
+
+    beginResetModel();
+    m_entries.clear();
+    m_titles.clear();
+    for (int i = 0; i < subscriptions.size(); ++i) {
+        const Entry entry = entryFromMap(subscriptions.at(i).toMap());
+        if (entry.feedId <= 0 || m_titles.contains(entry.feedId)) {
+            continue;
+        }
+        m_entries.append(entry);
+        m_titles.insert(entry.feedId, entry.title);
+    }
+    // SQLite already returns them by title; sorting here keeps the order
+    // identical to the comparator used for single-row inserts.
+    qStableSort(m_entries.begin(), m_entries.end(), entryLessThan);
+    endResetModel();
+
+    if (m_entries.size() != oldCount) {
+        emit countChanged();
+    }
+}
+
+void SubscriptionListModel::insertOrUpdate(const QVariantMap &subscription)
+{
+    const Entry entry = entryFromMap(subscription);
+    if (entry.feedId <= 0) {
+        return;
+    }
+
+    const int existing = rowOf(entry.feedId);
+    if (existing >= 0) {
+        if (m_entries.at(existing).title == entry.title) {
+            m_entries[existing] = entry;
+            const QModelIndex changed = index(existing);
+            emit dataChanged(changed, changed);
+            return;
+        }
+        // Title changed: the row has to move to keep the list sorted.
+        remove(entry.feedId);
+    }
+
+    const int row = insertPosition(entry);
+    beginInsertRows(QModelIndex(), row, row);
+    m_entries.insert(row, entry);
+    m_titles.insert(entry.feedId, entry.title);
+    endInsertRows();
+    emit countChanged();
+}
+
+void SubscriptionListModel::remove(int feedId)
+{
+    const int row = rowOf(feedId);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_entries.removeAt(row);
+    m_titles.remove(feedId);
+    endRemoveRows();
+    emit countChanged();
+}
+
+SubscriptionListModel::Entry SubscriptionListModel::entryFromMap(const QVariantMap &map)
+{
+    Entry entry;
+    entry.feedId = map.value(QString::fromLatin1("feedId")).toInt();
+    entry.title = map.value(QString::fromLatin1("title")).toString();
+    entry.image = map.value(QString::fromLatin1("image")).toString();
+    entry.lastUpdated = map.value(QString::fromLatin1("lastUpdated")).toInt();
+    entry.guid = map.value(QString::fromLatin1("guid")).toString();
+    entry.imageUrlHash = map.value(QString::fromLatin1("imageUrlHash")).toString();
+    return entry;
+}
+
+QVariantMap SubscriptionListModel::entryToMap(const Entry &entry)
+{
+    QVariantMap map;
+    map.insert(QString::fromLatin1("feedId"), entry.feedId);
+    map.insert(QString::fromLatin1("title"), entry.title);
+    map.insert(QString::fromLatin1("image"), entry.image);
+    map.insert(QString::fromLatin1("lastUpdated"), entry.lastUpdated);
+    map.insert(QString::fromLatin1("guid"), entry.guid);
+    map.insert(QString::fromLatin1("imageUrlHash"), entry.imageUrlHash);
+    return map;
+}
+
+bool SubscriptionListModel::entryLessThan(const Entry &left, const Entry &right)
+{
+    if (left.title != right.title) {
+        return left.title < right.title;
+    }
+    return left.feedId < right.feedId;
+}
+
+int SubscriptionListModel::rowOf(int feedId) const
+{
+    QHash<int, QString>::const_iterator it = m_titles.constFind(feedId);
+    if (it == m_titles.constEnd()) {
+        return -1;
+    }
+
+    Entry key;
+    key.feedId = feedId;
+    key.title = it.value();
+    const int row = insertPosition(key);
+    if (row < m_entries.size() && m_entries.at(row).feedId == feedId) {
+        return row;
+    }
+    return -1;
+}
+
+int SubscriptionListModel::insertPosition(const Entry &entry) const
+{
+    QList<Entry>::const_iterator it = qLowerBound(m_entries.constBegin(), m_entries.constEnd(),
+                                                  entry, entryLessThan);
+    return it - m_entries.constBegin();
+}
@@ -0,0 +1,71 @@
+#ifndef SUBSCRIPTIONLISTMODEL_H
+#define SUBSCRIPTIONLISTMODEL_H
+
+#include <QtCore/QAbstractListModel>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QVariantList>
+#include <QtCore/QVariantMap>
+
+// Subscriptions kept sorted by (title, feedId), matching the storage query.
+// Subscribe/unsubscribe touch a single row found by binary search, so views
+// only create or destroy the affected delegate instead of reloading the list.
+class SubscriptionListModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Roles {
+        FeedIdRole = Qt::UserRole + 1,
+        TitleRole,
+        ImageRole,
+        LastUpdatedRole,
+        GuidRole,
+        ImageUrlHashRole
+    };
+
+    explicit SubscriptionListModel(QObject *parent = 0);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+    int count() const;
+    // O(1): backed by the feed ID -> title index kept with every change.
+    bool contains(int feedId) const;
+    Q_INVOKABLE QVariantMap get(int row) const;
+    QVariantList toVariantList() const;
+
+    // Replaces the whole list (initial load or explicit refresh).
+    void setSubscriptions(const QVariantList &subscriptions);
+    // Inserts a new row or updates an existing one in place.
+    void insertOrUpdate(const QVariantMap &subscription);
+    void remove(int feedId);
+
+signals:
+    void countChanged();
+
+private:
+    struct Entry {
+        int feedId;
+        QString title;
+        QString image;
+        int lastUpdated;
+        QString guid;
+        QString imageUrlHash;
+    };
+
+    static Entry entryFromMap(const QVariantMap &map);
+    static QVariantMap entryToMap(const Entry &entry);
+    static bool entryLessThan(const Entry &left, const Entry &right);
+
+    // Row of feedId, or -1; looks the title up in m_titles and bisects.
+    int rowOf(int feedId) const;
+    int insertPosition(const Entry &entry) const;
+
+    QList<Entry> m_entries;
+    QHash<int, QString> m_titles;
+};
+
+#endif // SUBSCRIPTIONLISTMODEL_H
@@ -414,6 +414,21 @@ int main(int argc, char *argv[])
     AudioEngine audioEngine;
     audioEngine.setVolume(storage.volumePercent() / 100.0);
 
+    // Episode lists are cached per feed and shown before the network answers.
+    QObject::connect(&apiClient, SIGNAL(cachedEpisodesRequested(int)),
+                     &storage, SLOT(requestCachedEpisodes(int)));
+    QObject::connect(&storage, SIGNAL(cachedEpisodesLoaded(int,QVariantList)),
+                     &apiClient, SLOT(applyCachedEpisodes(int,QVariantList)));
+    QObject::connect(&apiClient, SIGNAL(episodesFetched(int,QVariantList)),
+                     &storage, SLOT(cacheEpisodes(int,QVariantList)));
+
+    // OPML entries without a Podcast Index ID are looked up, then subscribed
+    // to in one batch.
+    QObject::connect(&storage, SIGNAL(feedsNeedResolving(QVariantList)),
+                     &apiClient, SLOT(resolveFeeds(QVariantList)));
+    QObject::connect(&apiClient, SIGNAL(feedsResolved(QVariantList,int)),
+                     &storage, SLOT(subscribeAll(QVariantList,int)));
+
     QDeclarativeView view;
     view.rootContext()->setContextProperty("apiClient", &apiClient);
     view.rootContext()->setContextProperty("storage", &storage);
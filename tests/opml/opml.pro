@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = opml-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_opml.cpp \
+    ../../src/Opml.cpp
+HEADERS += \
+    ../../src/Opml.h
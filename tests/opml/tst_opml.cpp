@@ -0,0 +1,112 @@
+#include <QtTest/QtTest>
+#include <QtCore/QBuffer>
+#include <QtCore/QVariant>
+
+#include "Opml.h"
+
+namespace {
+QList<QVariantMap> readAll(const QByteArray &document, QString *error = 0)
+{
+    QBuffer buffer;
+    buffer.setData(document);
+    buffer.open(QIODevice::ReadOnly);
+    OpmlReader reader(&buffer);
+    QList<QVariantMap> feeds;
+    QVariantMap feed;
+    while (reader.readNextFeed(&feed)) {
+        feeds << feed;
+    }
+    if (error) {
+        *error = reader.errorString();
+    }
+    return feeds;
+}
+
+QVariantMap feed(int feedId, const QString &title, const QString &feedUrl)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("feedId"), feedId);
+    entry.insert(QString::fromLatin1("title"), title);
+    entry.insert(QString::fromLatin1("feedUrl"), feedUrl);
+    return entry;
+}
+}
+
+class OpmlTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readsNestedOutlines();
+    void readsPodinAttributes();
+    void reportsMalformedFile();
+    void roundTrips();
+};
+
+void OpmlTest::readsNestedOutlines()
+{
+    const QByteArray document(
+        "<?xml version=\"1.0\"?>\n"
+        "<opml version=\"1.0\"><head><title>Export</title></head><body>\n"
+        "<outline text=\"News\">\n"
+        "  <outline type=\"rss\" text=\"Daily\" xmlUrl=\"http://example.com/daily.xml\"/>\n"
+        "  <outline type=\"rss\" title=\"Weekly &amp; more\" xmlurl=\"http://example.com/weekly.xml\"/>\n"
+        "</outline>\n"
+        "<outline type=\"rss\" text=\"Top\" xmlUrl=\"http://example.com/top.xml\"></outline>\n"
+        "</body></opml>\n");
+    QString error;
+    const QList<QVariantMap> feeds = readAll(document, &error);
+    QVERIFY(error.isEmpty());
+    QCOMPARE(feeds.size(), 3);
+    QCOMPARE(feeds.at(0).value(QString::fromLatin1("title")).toString(), QString::fromLatin1("Daily"));
+    QCOMPARE(feeds.at(1).value(QString::fromLatin1("title")).toString(), QString::fromLatin1("Weekly & more"));
+    QCOMPARE(feeds.at(1).value(QString::fromLatin1("feedUrl")).toString(),
+             QString::fromLatin1("http://example.com/weekly.xml"));
+    QCOMPARE(feeds.at(2).value(QString::fromLatin1("feedId")).toInt(), 0);
+}
+
+void OpmlTest::readsPodinAttributes()
+{
+    const QByteArray document(
+        "<opml version=\"2.0\"><body>"
+        "<outline text=\"Known\" podcastIndexId=\"920666\" podcastGuid=\"abc\"/>"
+        "</body></opml>");
+    const QList<QVariantMap> feeds = readAll(document);
+    QCOMPARE(feeds.size(), 1);
+    QCOMPARE(feeds.at(0).value(QString::fromLatin1("feedId")).toInt(), 920666);
+    QCOMPARE(feeds.at(0).value(QString::fromLatin1("guid")).toString(), QString::fromLatin1("abc"));
+    QVERIFY(feeds.at(0).value(QString::fromLatin1("feedUrl")).toString().isEmpty());
+}
+
+void OpmlTest::reportsMalformedFile()
+{
+    const QByteArray document(
+        "<opml><body><outline text=\"A\" xmlUrl=\"http://example.com/a.xml\"/><outline");
+    QString error;
+    const QList<QVariantMap> feeds = readAll(document, &error);
+    QCOMPARE(feeds.size(), 1);
+    QVERIFY(!error.isEmpty());
+}
+
+void OpmlTest::roundTrips()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    OpmlWriter writer(&buffer);
+    writer.writeStart(QString::fromLatin1("Podin subscriptions"));
+    writer.writeFeed(feed(1, QString::fromLatin1("Alpha <1>"), QString::fromLatin1("http://example.com/a.xml")));
+    writer.writeFeed(feed(2, QString::fromLatin1("Bravo"), QString()));
+    writer.writeEnd();
+    buffer.close();
+
+    const QList<QVariantMap> feeds = readAll(buffer.data());
+    QCOMPARE(feeds.size(), 2);
+    QCOMPARE(feeds.at(0).value(QString::fromLatin1("title")).toString(), QString::fromLatin1("Alpha <1>"));
+    QCOMPARE(feeds.at(0).value(QString::fromLatin1("feedId")).toInt(), 1);
+    QCOMPARE(feeds.at(0).value(QString::fromLatin1("feedUrl")).toString(),
+             QString::fromLatin1("http://example.com/a.xml"));
+    QCOMPARE(feeds.at(1).value(QString::fromLatin1("feedId")).toInt(), 2);
+}
+
+QTEST_MAIN(OpmlTest)
+#include "tst_opml.moc"
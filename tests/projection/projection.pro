@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = projection-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+include(../../lib/qjson/qjson.pri)
+DEFINES += QJSON_STATIC
+SOURCES += tst_projection.cpp \
+    ../../src/PodcastIndexProjection.cpp
+HEADERS += \
+    ../../src/PodcastIndexProjection.h
@@ -0,0 +1,335 @@
+#include <QtTest/QtTest>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QVariant>
+
+#include "PodcastIndexProjection.h"
+#include "parser.h"
+#include "streamreader.h"
+
+#if defined(Q_OS_SYMBIAN)
+#include <e32std.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+using QJson::StreamReader;
+
+namespace {
+// Bytes currently allocated on the heap, or -1 where it cannot be read.
+qint64 heapInUse()
+{
+#if defined(Q_OS_SYMBIAN)
+    TInt size = 0;
+    User::AllocSize(size);
+    return size;
+#elif defined(__GLIBC__)
+    const struct mallinfo info = mallinfo();
+    // Large blocks are mmap()ed and only show up in hblkhd.
+    return qint64(info.uordblks) + qint64(info.hblkhd);
+#else
+    return -1;
+#endif
+}
+
+// Shaped like a search/byterm answer, with the nested blocks the real
+// API sends for every feed.
+QByteArray searchPayload(int feeds)
+{
+    QByteArray json("{\"status\":\"true\",\"feeds\":[");
+    for (int i = 0; i < feeds; ++i) {
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"id\":" + QByteArray::number(1000 + i)
+            + ",\"podcastGuid\":\"guid-" + QByteArray::number(i) + "\""
+            + ",\"title\":\"Feed " + QByteArray::number(i) + "\""
+            + ",\"url\":\"https://example.org/" + QByteArray::number(i) + ".xml\""
+            + ",\"originalUrl\":\"https://example.org/" + QByteArray::number(i) + ".xml\""
+            + ",\"link\":\"https://example.org/\",\"author\":\"Someone\",\"ownerName\":\"Someone\""
+            + ",\"image\":\"https://example.org/" + QByteArray::number(i) + ".jpg\""
+            + ",\"artwork\":\"https://example.org/" + QByteArray::number(i) + ".jpg\""
+            + ",\"imageUrlHash\":" + QByteArray::number(3000000000u + i)
+            + ",\"description\":\"" + QByteArray(600, 'd') + "\""
+            + ",\"lastUpdateTime\":1700000000,\"lastCrawlTime\":1700000000"
+            + ",\"itunesId\":null,\"language\":\"en\",\"explicit\":false,\"type\":0"
+            + ",\"categories\":{\"1\":\"Arts\",\"55\":\"News\",\"59\":\"Politics\",\"102\":\"Technology\"}"
+            + ",\"funding\":{\"url\":\"https://example.org/support\",\"message\":\"Support the show\"}"
+            + ",\"value\":{\"model\":{\"type\":\"lightning\",\"method\":\"keysend\",\"suggested\":\"0.00000005\"},"
+              "\"destinations\":[{\"name\":\"Host\",\"address\":\"03ae9f91a0cb8ff43840e3c322c4c61f019d8c1c3cea15a25cfc425ac605e61a4a\","
+              "\"type\":\"node\",\"split\":90},{\"name\":\"Index\",\"address\":\"03ae9f91a0cb8ff43840e3c322c4c61f019d8c1c3cea15a25cfc425ac605e61a4a\","
+              "\"type\":\"node\",\"split\":10,\"fee\":true}]}"
+            + "}";
+    }
+    json += "],\"count\":" + QByteArray::number(feeds) + ",\"query\":\"x\",\"description\":\"Found matching feeds\"}";
+    return json;
+}
+
+QByteArray episodesPayload(int items)
+{
+    QByteArray json("{\"status\":\"true\",\"liveItems\":[],\"items\":[");
+    for (int i = 0; i < items; ++i) {
+        if (i > 0) {
+            json += ',';
+        }
+        json += "{\"id\":" + QByteArray::number(9000 + i)
+            + ",\"title\":\"Episode " + QByteArray::number(i) + "\""
+            + ",\"link\":\"https://example.org/e\",\"description\":\"" + QByteArray(1500, 'e') + "\""
+            + ",\"guid\":\"e-" + QByteArray::number(i) + "\",\"datePublished\":" + QByteArray::number(1700000000 + i)
+            + ",\"enclosureUrl\":\"https://example.org/" + QByteArray::number(i) + ".mp3\""
+            + ",\"enclosureType\":\"audio/mpeg\",\"enclosureLength\":12345678,\"duration\":" + QByteArray::number(600 + i)
+            + ",\"transcripts\":[{\"url\":\"https://example.org/t.vtt\",\"type\":\"text/vtt\"}]"
+            + ",\"persons\":[{\"id\":1,\"name\":\"Someone\",\"role\":\"host\",\"group\":\"cast\"}]"
+            + ",\"chaptersUrl\":\"https://example.org/c.json\",\"feedLanguage\":\"en\"}";
+    }
+    json += "],\"count\":" + QByteArray::number(items) + "}";
+    return json;
+}
+
+typedef bool (*Projection)(const QByteArray &, QVariant *, QString *);
+
+// Heap held by the parsed document on the QJson::Parser path versus the
+// heap still held after the streamed projection.
+void reportHeap(const char *label, const QByteArray &payload, Projection projection,
+                qint64 *treeBytes, qint64 *streamBytes)
+{
+    qint64 before = heapInUse();
+    {
+        QJson::Parser parser;
+        bool ok = false;
+        const QVariant tree = parser.parse(payload, &ok);
+        *treeBytes = heapInUse() - before;
+        QVERIFY(ok);
+    }
+    before = heapInUse();
+    {
+        QVariant result;
+        QString error;
+        QVERIFY(projection(payload, &result, &error));
+        *streamBytes = heapInUse() - before;
+    }
+    qDebug("%s: %d KB payload, parse tree %lld KB, streamed projection %lld KB",
+           label, payload.size() / 1024, *treeBytes / 1024, *streamBytes / 1024);
+}
+}
+
+class ProjectionTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readsTokens();
+    void decodesEscapes();
+    void skipsSubtrees();
+    void numbersMatchParser();
+    void reportsErrors();
+    void projectsFeedList();
+    void projectsFeedListFrom();
+    void projectsPodcastDetail();
+    void projectsEpisodeList();
+    void extractsErrorDetail();
+    void peakHeap();
+};
+
+void ProjectionTest::readsTokens()
+{
+    StreamReader reader("{\"a\": [1, true, null, \"x\"], \"b\": {}}");
+    QList<int> types;
+    while (reader.readNext() != StreamReader::EndDocument) {
+        QVERIFY(!reader.hasError());
+        types << reader.tokenType();
+    }
+    QCOMPARE(types, QList<int>()
+             << StreamReader::StartObject
+             << StreamReader::Name << StreamReader::StartArray
+             << StreamReader::Number << StreamReader::Bool << StreamReader::Null << StreamReader::String
+             << StreamReader::EndArray
+             << StreamReader::Name << StreamReader::StartObject << StreamReader::EndObject
+             << StreamReader::EndObject);
+}
+
+void ProjectionTest::decodesEscapes()
+{
+    StreamReader reader("[\"tab\\there \\\"q\\\" caf\\u00e9 \\ud83c\\udfa7 \\/\", \"plain\"]");
+    QCOMPARE(int(reader.readNext()), int(StreamReader::StartArray));
+    QCOMPARE(int(reader.readNext()), int(StreamReader::String));
+    QCOMPARE(reader.text(), QString::fromUtf8("tab\there \"q\" caf\xc3\xa9 \xf0\x9f\x8e\xa7 /"));
+    QCOMPARE(int(reader.readNext()), int(StreamReader::String));
+    QVERIFY(reader.textEquals("plain"));
+    QVERIFY(!reader.textEquals("plai"));
+}
+
+void ProjectionTest::skipsSubtrees()
+{
+    StreamReader reader("{\"skip\": {\"x\": [1, {\"y\": \"]}\"}]}, \"keep\": 7}");
+    QCOMPARE(int(reader.readNext()), int(StreamReader::StartObject));
+    QCOMPARE(int(reader.readNext()), int(StreamReader::Name));
+    QVERIFY(reader.textEquals("skip"));
+    QVERIFY(reader.skipCurrentValue());
+    QCOMPARE(int(reader.readNext()), int(StreamReader::Name));
+    QVERIFY(reader.textEquals("keep"));
+    QCOMPARE(reader.depth(), 1);
+    QCOMPARE(int(reader.readNext()), int(StreamReader::Number));
+    QCOMPARE(reader.value().toInt(), 7);
+    QCOMPARE(int(reader.readNext()), int(StreamReader::EndObject));
+    QCOMPARE(int(reader.readNext()), int(StreamReader::EndDocument));
+}
+
+void ProjectionTest::numbersMatchParser()
+{
+    const QByteArray json("[0, 42, -7, 2.5, 1e3, 3000000001]");
+    QJson::Parser parser;
+    const QVariantList expected = parser.parse(json).toList();
+    StreamReader reader(json);
+    reader.readNext();
+    for (int i = 0; i < expected.size(); ++i) {
+        QCOMPARE(int(reader.readNext()), int(StreamReader::Number));
+        QCOMPARE(reader.value().type(), expected.at(i).type());
+        QCOMPARE(reader.value(), expected.at(i));
+    }
+}
+
+void ProjectionTest::reportsErrors()
+{
+    const char *const broken[] = {
+        "{\"a\": [1, 2}", "{\"a\" 1}", "[1,]", "{\"a\": \"open", "[1] 2", "[tru]", 0
+    };
+    for (int i = 0; broken[i]; ++i) {
+        StreamReader reader(broken[i]);
+        while (reader.readNext() != StreamReader::EndDocument && !reader.hasError()) {
+        }
+        QVERIFY2(reader.hasError(), broken[i]);
+        QVERIFY(!reader.errorString().isEmpty());
+    }
+
+    QVariant result;
+    QString error;
+    QVERIFY(!PodcastIndexProjection::feedList("{\"feeds\": [{\"id\": 1,", &result, &error));
+    QVERIFY(error.startsWith(QLatin1String("JSON parse error")));
+}
+
+void ProjectionTest::projectsFeedList()
+{
+    QVariant result;
+    QString error;
+    QVERIFY(PodcastIndexProjection::feedList(searchPayload(3), &result, &error));
+    const QVariantList feeds = result.toList();
+    QCOMPARE(feeds.size(), 3);
+    const QVariantMap feed = feeds.at(2).toMap();
+    QCOMPARE(feed.size(), 6);
+    QCOMPARE(feed.value(QString::fromLatin1("feedId")).toInt(), 1002);
+    QCOMPARE(feed.value(QString::fromLatin1("guid")).toString(), QString::fromLatin1("guid-2"));
+    QCOMPARE(feed.value(QString::fromLatin1("title")).toString(), QString::fromLatin1("Feed 2"));
+    QCOMPARE(feed.value(QString::fromLatin1("image")).toString(), QString::fromLatin1("https://example.org/2.jpg"));
+    QCOMPARE(feed.value(QString::fromLatin1("imageUrlHash")).toString(), QString::fromLatin1("3000000002"));
+    QCOMPARE(feed.value(QString::fromLatin1("description")).toString().size(), 243);
+
+    QVERIFY(PodcastIndexProjection::feedList("{\"status\":\"true\",\"feeds\":[],\"count\":0}", &result, &error));
+    QVERIFY(result.toList().isEmpty());
+}
+
+void ProjectionTest::projectsFeedListFrom()
+{
+    QVariant result;
+    QString error;
+    QVERIFY(PodcastIndexProjection::feedListFrom(searchPayload(20), 10, &result, &error));
+    const QVariantList feeds = result.toList();
+    QCOMPARE(feeds.size(), 10);
+    QCOMPARE(feeds.first().toMap().value(QString::fromLatin1("feedId")).toInt(), 1010);
+    QCOMPARE(feeds.last().toMap().value(QString::fromLatin1("feedId")).toInt(), 1019);
+
+    // Past the end of a short (exhausted) result set.
+    QVERIFY(PodcastIndexProjection::feedListFrom(searchPayload(5), 10, &result, &error));
+    QVERIFY(result.toList().isEmpty());
+
+    // Errors inside the skipped entries are still reported.
+    QVERIFY(!PodcastIndexProjection::feedListFrom("{\"feeds\": [{\"id\": 1,", 1, &result, &error));
+    QVERIFY(error.startsWith(QLatin1String("JSON parse error")));
+}
+
+void ProjectionTest::projectsPodcastDetail()
+{
+    QVariant result;
+    QString error;
+    QVERIFY(PodcastIndexProjection::podcastDetail(
+        "{\"status\":\"true\",\"query\":{\"id\":\"75075\"},\"feed\":{\"id\":75075,\"title\":\"Show\","
+        "\"link\":\"https://example.org/\",\"ownerName\":\"Owner\",\"author\":\"\","
+        "\"categories\":{\"1\":\"Arts\"},\"guid\":\"g\",\"imageUrlHash\":12}}",
+        &result, &error));
+    const QVariantMap feed = result.toMap();
+    QCOMPARE(feed.value(QString::fromLatin1("feedId")).toInt(), 75075);
+    QCOMPARE(feed.value(QString::fromLatin1("title")).toString(), QString::fromLatin1("Show"));
+    QCOMPARE(feed.value(QString::fromLatin1("author")).toString(), QString::fromLatin1("Owner"));
+    QCOMPARE(feed.value(QString::fromLatin1("url")).toString(), QString::fromLatin1("https://example.org/"));
+    QCOMPARE(feed.value(QString::fromLatin1("guid")).toString(), QString::fromLatin1("g"));
+    QCOMPARE(feed.value(QString::fromLatin1("imageUrlHash")).toString(), QString::fromLatin1("12"));
+
+    // byfeedurl for an unknown feed.
+    QVERIFY(PodcastIndexProjection::podcastDetail("{\"status\":\"true\",\"feed\":[]}", &result, &error));
+    QVERIFY(result.toMap().isEmpty());
+}
+
+void ProjectionTest::projectsEpisodeList()
+{
+    QVariant result;
+    QString error;
+    QVERIFY(PodcastIndexProjection::episodeList(episodesPayload(2), &result, &error));
+    const QVariantList items = result.toList();
+    QCOMPARE(items.size(), 2);
+    const QVariantMap item = items.at(1).toMap();
+    QCOMPARE(item.size(), 7);
+    QCOMPARE(item.value(QString::fromLatin1("id")).toInt(), 9001);
+    QCOMPARE(item.value(QString::fromLatin1("datePublished")).toLongLong(), Q_INT64_C(1700000001));
+    QCOMPARE(item.value(QString::fromLatin1("duration")).toInt(), 601);
+    QCOMPARE(item.value(QString::fromLatin1("enclosureUrl")).toString(), QString::fromLatin1("https://example.org/1.mp3"));
+    QCOMPARE(item.value(QString::fromLatin1("description")).toString().size(), 503);
+}
+
+void ProjectionTest::extractsErrorDetail()
+{
+    QCOMPARE(PodcastIndexProjection::errorDetail("{\"status\":\"false\",\"description\":\"Bad key\"}"),
+             QString::fromLatin1("Bad key"));
+    QCOMPARE(PodcastIndexProjection::errorDetail("<html>Gateway</html>"),
+             QString::fromLatin1("<html>Gateway</html>"));
+    QVERIFY(PodcastIndexProjection::errorDetail(QByteArray()).isEmpty());
+}
+
+void ProjectionTest::peakHeap()
+{
+    if (heapInUse() < 0) {
+        QSKIP("No heap statistics on this platform", SkipAll);
+    }
+    qint64 treeBytes = 0;
+    qint64 streamBytes = 0;
+    reportHeap("search (100 feeds)", searchPayload(100), PodcastIndexProjection::feedList,
+               &treeBytes, &streamBytes);
+    QVERIFY(streamBytes < treeBytes);
+    reportHeap("episodes (100 items)", episodesPayload(100), PodcastIndexProjection::episodeList,
+               &treeBytes, &streamBytes);
+    QVERIFY(streamBytes < treeBytes);
+
+    // Captured responses: PODIN_PAYLOAD_DIR=<dir> with search*.json,
+    // episodes*.json and podcast*.json saved from the API.
+    const QString dirPath = QString::fromLocal8Bit(qgetenv("PODIN_PAYLOAD_DIR"));
+    if (dirPath.isEmpty()) {
+        return;
+    }
+    const QFileInfoList files = QDir(dirPath).entryInfoList(QStringList() << QString::fromLatin1("*.json"),
+                                                           QDir::Files, QDir::Name);
+    for (int i = 0; i < files.size(); ++i) {
+        QFile file(files.at(i).absoluteFilePath());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray payload = file.readAll();
+        const QString name = files.at(i).fileName();
+        Projection projection = PodcastIndexProjection::podcastDetail;
+        if (name.startsWith(QLatin1String("search"))) {
+            projection = PodcastIndexProjection::feedList;
+        } else if (name.startsWith(QLatin1String("episodes"))) {
+            projection = PodcastIndexProjection::episodeList;
+        }
+        reportHeap(qPrintable(name), payload, projection, &treeBytes, &streamBytes);
+    }
+}
+
+QTEST_MAIN(ProjectionTest)
+#include "tst_projection.moc"
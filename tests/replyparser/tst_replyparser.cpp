@@ -0,0 +1,120 @@
+#include <QtTest/QtTest>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVariant>
+
+#include "ReplyParser.h"
+#include "parser.h"
+
+namespace {
+QThread *gProjectionThread = 0;
+
+// Keeps only the titles, like the client's list projections.
+bool projectTitles(const QByteArray &payload, QVariant *result, QString *errorMessage)
+{
+    gProjectionThread = QThread::currentThread();
+    QJson::Parser parser;
+    bool ok = false;
+    const QVariant root = parser.parse(payload, &ok);
+    if (!ok) {
+        *errorMessage = parser.errorString();
+        return false;
+    }
+    QVariantList titles;
+    const QVariantList feeds = root.toMap().value(QString::fromLatin1("feeds")).toList();
+    for (int i = 0; i < feeds.size(); ++i) {
+        titles << feeds.at(i).toMap().value(QString::fromLatin1("title"));
+    }
+    *result = titles;
+    return true;
+}
+}
+
+class Receiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    Receiver()
+        : calls(0)
+        , ticket(0)
+        , ok(false)
+        , thread(0)
+    {
+    }
+
+    int calls;
+    int ticket;
+    QVariant result;
+    bool ok;
+    QString errorMessage;
+    QThread *thread;
+
+public slots:
+    void onProjected(int ticket, const QVariant &result, bool ok, const QString &errorMessage)
+    {
+        ++calls;
+        this->ticket = ticket;
+        this->result = result;
+        this->ok = ok;
+        this->errorMessage = errorMessage;
+        thread = QThread::currentThread();
+    }
+};
+
+class ReplyParserTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void projectsOnPoolThread();
+    void reportsParseErrors();
+
+private:
+    void run(ReplyParser *parser, Receiver *receiver);
+};
+
+void ReplyParserTest::run(ReplyParser *parser, Receiver *receiver)
+{
+    connect(parser, SIGNAL(projected(int,QVariant,bool,QString)),
+            receiver, SLOT(onProjected(int,QVariant,bool,QString)));
+    QThreadPool pool;
+    pool.start(parser);
+    pool.waitForDone();
+    // The result is queued to this thread.
+    QCOMPARE(receiver->calls, 0);
+    QCoreApplication::processEvents();
+    QCOMPARE(receiver->calls, 1);
+}
+
+void ReplyParserTest::projectsOnPoolThread()
+{
+    gProjectionThread = 0;
+    Receiver receiver;
+    const QByteArray payload("{\"status\":\"true\",\"feeds\":[{\"id\":1,\"title\":\"One\",\"categories\":{\"1\":\"Arts\"}},"
+                             "{\"id\":2,\"title\":\"Two\",\"funding\":{\"url\":\"x\"}}],\"count\":2}");
+    run(new ReplyParser(7, projectTitles, payload), &receiver);
+
+    QVERIFY(receiver.ok);
+    QCOMPARE(receiver.ticket, 7);
+    QCOMPARE(receiver.result.toList(), QVariantList() << QString::fromLatin1("One")
+                                                      << QString::fromLatin1("Two"));
+    QVERIFY(gProjectionThread != 0);
+    QVERIFY(gProjectionThread != QThread::currentThread());
+    QCOMPARE(receiver.thread, QThread::currentThread());
+}
+
+void ReplyParserTest::reportsParseErrors()
+{
+    gProjectionThread = 0;
+    Receiver receiver;
+    run(new ReplyParser(3, projectTitles, QByteArray("{\"feeds\":[")), &receiver);
+
+    QVERIFY(!receiver.ok);
+    QCOMPARE(receiver.ticket, 3);
+    QVERIFY(!receiver.errorMessage.isEmpty());
+    QVERIFY(receiver.result.isNull());
+}
+
+QTEST_MAIN(ReplyParserTest)
+#include "tst_replyparser.moc"
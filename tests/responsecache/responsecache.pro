@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = responsecache-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_responsecache.cpp \
+    ../../src/ResponseCache.cpp \
+    ../../src/ResponseCacheJob.cpp
+HEADERS += \
+    ../../src/ResponseCache.h \
+    ../../src/ResponseCacheJob.h
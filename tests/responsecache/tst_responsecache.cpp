@@ -0,0 +1,199 @@
+#include <QtTest/QtTest>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QUrl>
+#include <QtCore/QVariant>
+
+#include "ResponseCache.h"
+#include "ResponseCacheJob.h"
+
+namespace {
+QVariantList feedList(int count)
+{
+    QVariantList list;
+    for (int i = 0; i < count; ++i) {
+        QVariantMap feed;
+        feed.insert(QString::fromLatin1("feedId"), 1000 + i);
+        feed.insert(QString::fromLatin1("title"), QString::fromLatin1("Feed %1").arg(i));
+        list.append(feed);
+    }
+    return list;
+}
+
+QString keyFor(const char *url)
+{
+    return ResponseCache::canonicalKey(QUrl(QString::fromLatin1(url)));
+}
+}
+
+class ResponseCacheTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void canonicalKeyIgnoresQueryOrder();
+    void roundTripsEntry();
+    void freshnessFollowsMaxAge();
+    void touchKeepsDataAndRefreshesValidators();
+    void pruneDropsOldest();
+    void jobsRunInOrderOnPool();
+
+private:
+    QString m_dir;
+};
+
+void ResponseCacheTest::init()
+{
+    m_dir = QDir::tempPath() + QString::fromLatin1("/podin-responsecache-%1")
+        .arg(QCoreApplication::applicationPid());
+    ResponseCache(m_dir).clear();
+}
+
+void ResponseCacheTest::cleanup()
+{
+    ResponseCache(m_dir).clear();
+    QDir().rmdir(m_dir);
+}
+
+void ResponseCacheTest::canonicalKeyIgnoresQueryOrder()
+{
+    QCOMPARE(keyFor("https://API.podcastindex.org/api/1.0/search/byterm?q=linux&max=10"),
+             keyFor("https://api.podcastindex.org/api/1.0/search/byterm?max=10&q=linux"));
+    QVERIFY(keyFor("https://api.podcastindex.org/api/1.0/search/byterm?q=linux&max=10")
+            != keyFor("https://api.podcastindex.org/api/1.0/search/byterm?q=linux&max=20"));
+    QVERIFY(keyFor("https://api.podcastindex.org/api/1.0/podcasts/byfeedid?id=1")
+            != keyFor("https://api.podcastindex.org/api/1.0/episodes/byfeedid?id=1"));
+}
+
+void ResponseCacheTest::roundTripsEntry()
+{
+    ResponseCache cache(m_dir);
+    const QString key = keyFor("https://api.podcastindex.org/api/1.0/search/byterm?q=qt");
+    ResponseCache::Entry entry;
+    QVERIFY(!cache.load(key, &entry));
+
+    entry.etag = "\"abc\"";
+    entry.lastModified = "Tue, 01 Sep 2026 10:00:00 GMT";
+    entry.fetchedAt = 1000;
+    entry.data = feedList(3);
+    QVERIFY(cache.store(key, entry));
+
+    // A second instance (next app start) reads the same file.
+    ResponseCache reopened(m_dir);
+    ResponseCache::Entry loaded;
+    QVERIFY(reopened.load(key, &loaded));
+    QCOMPARE(loaded.etag, entry.etag);
+    QCOMPARE(loaded.lastModified, entry.lastModified);
+    QCOMPARE(loaded.fetchedAt, entry.fetchedAt);
+    QCOMPARE(loaded.data.toList().size(), 3);
+    QCOMPARE(loaded.data.toList().at(2).toMap().value(QString::fromLatin1("feedId")).toInt(), 1002);
+    QCOMPARE(reopened.stats().value(QString::fromLatin1("entries")).toInt(), 1);
+
+    reopened.remove(key);
+    QVERIFY(!reopened.load(key, &loaded));
+}
+
+void ResponseCacheTest::freshnessFollowsMaxAge()
+{
+    ResponseCache::Entry entry;
+    entry.fetchedAt = 1000;
+    QVERIFY(entry.isFresh(60, 1000));
+    QVERIFY(entry.isFresh(60, 1059));
+    QVERIFY(!entry.isFresh(60, 1060));
+    QVERIFY(!entry.isFresh(0, 1000));
+    // Clock moved backwards.
+    QVERIFY(!entry.isFresh(60, 999));
+}
+
+void ResponseCacheTest::touchKeepsDataAndRefreshesValidators()
+{
+    ResponseCache cache(m_dir);
+    const QString key = keyFor("https://api.podcastindex.org/api/1.0/podcasts/byfeedid?id=42");
+    ResponseCache::Entry entry;
+    entry.etag = "\"v1\"";
+    entry.lastModified = "Tue, 01 Sep 2026 10:00:00 GMT";
+    entry.fetchedAt = 1000;
+    entry.data = feedList(1).first();
+    QVERIFY(cache.store(key, entry));
+
+    // 304 with a new ETag and no Last-Modified.
+    QVERIFY(cache.touch(key, "\"v2\"", QByteArray(), 5000));
+    ResponseCache::Entry loaded;
+    QVERIFY(cache.load(key, &loaded));
+    QCOMPARE(loaded.etag, QByteArray("\"v2\""));
+    QCOMPARE(loaded.lastModified, entry.lastModified);
+    QCOMPARE(loaded.fetchedAt, uint(5000));
+    QCOMPARE(loaded.data.toMap().value(QString::fromLatin1("feedId")).toInt(), 1000);
+
+    QVERIFY(!cache.touch(keyFor("https://api.podcastindex.org/api/1.0/podcasts/byfeedid?id=43"),
+                         "\"x\"", QByteArray(), 5000));
+}
+
+void ResponseCacheTest::pruneDropsOldest()
+{
+    ResponseCache cache(m_dir, 8);
+    ResponseCache::Entry entry;
+    entry.fetchedAt = 1000;
+    entry.data = feedList(1);
+    for (int i = 0; i < 9; ++i) {
+        const QString key = ResponseCache::canonicalKey(
+            QUrl(QString::fromLatin1("https://api.podcastindex.org/api/1.0/podcasts/byfeedid?id=%1").arg(i)));
+        QVERIFY(cache.store(key, entry));
+        // File times have one-second resolution on some file systems.
+        if (i == 0) {
+            QTest::qWait(1100);
+        }
+    }
+    // Ninth entry went over the budget of 8; down to 6.
+    QCOMPARE(cache.stats().value(QString::fromLatin1("entries")).toInt(), 6);
+    ResponseCache::Entry loaded;
+    QVERIFY(!cache.load(keyFor("https://api.podcastindex.org/api/1.0/podcasts/byfeedid?id=0"), &loaded));
+}
+
+void ResponseCacheTest::jobsRunInOrderOnPool()
+{
+    ResponseCache cache(m_dir);
+    QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    const QString key = keyFor("https://api.podcastindex.org/api/1.0/episodes/byfeedid?id=7&max=10");
+    ResponseCache::Entry entry;
+    entry.etag = "\"e1\"";
+    entry.fetchedAt = 1000;
+    entry.data = feedList(2);
+
+    QList<ResponseCacheJob *> jobs;
+    jobs << new ResponseCacheJob(&cache, ResponseCacheJob::Load, 1, key)
+         << new ResponseCacheJob(&cache, ResponseCacheJob::Store, 0, key, entry)
+         << new ResponseCacheJob(&cache, ResponseCacheJob::Load, 2, key)
+         << new ResponseCacheJob(&cache, ResponseCacheJob::Clear, 0)
+         << new ResponseCacheJob(&cache, ResponseCacheJob::Count, 0);
+    QList<QSignalSpy *> spies;
+    for (int i = 0; i < jobs.size(); ++i) {
+        jobs.at(i)->setAutoDelete(false);
+        spies << new QSignalSpy(jobs.at(i), SIGNAL(finished(int,bool,ResponseCache::Entry,int)));
+        pool.start(jobs.at(i));
+    }
+    pool.waitForDone();
+
+    for (int i = 0; i < spies.size(); ++i) {
+        QCOMPARE(spies.at(i)->count(), 1);
+    }
+    // Queued before the store: a miss.
+    QCOMPARE(spies.at(0)->at(0).at(0).toInt(), 1);
+    QVERIFY(!spies.at(0)->at(0).at(1).toBool());
+    QVERIFY(spies.at(1)->at(0).at(1).toBool());
+    QCOMPARE(spies.at(1)->at(0).at(3).toInt(), 1);
+    const ResponseCache::Entry loaded = spies.at(2)->at(0).at(2).value<ResponseCache::Entry>();
+    QVERIFY(spies.at(2)->at(0).at(1).toBool());
+    QCOMPARE(loaded.etag, entry.etag);
+    QCOMPARE(loaded.data.toList().size(), 2);
+    QCOMPARE(spies.at(4)->at(0).at(3).toInt(), 0);
+
+    qDeleteAll(spies);
+    qDeleteAll(jobs);
+}
+
+QTEST_MAIN(ResponseCacheTest)
+#include "tst_responsecache.moc"
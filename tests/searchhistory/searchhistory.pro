@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = searchhistory-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_searchhistory.cpp \
+    ../../src/SearchHistory.cpp
+HEADERS += \
+    ../../src/SearchHistory.h
@@ -0,0 +1,112 @@
+#include <QtTest/QtTest>
+#include <QtCore/QVariant>
+
+#include "SearchHistory.h"
+
+namespace {
+QStringList terms(const SearchHistory &history)
+{
+    QStringList list;
+    for (int i = 0; i < history.count(); ++i) {
+        list << history.termAt(i);
+    }
+    return list;
+}
+}
+
+class SearchHistoryTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void addIsNewestFirst();
+    void readdMovesToFront();
+    void fullRingDropsOldest();
+    void removeClosesGap();
+    void suggestionsByPrefix();
+    void roundTripsVariantList();
+};
+
+void SearchHistoryTest::addIsNewestFirst()
+{
+    SearchHistory history;
+    history.add(QString::fromLatin1("alpha"), 1);
+    history.add(QString::fromLatin1("bravo"), 2);
+    history.add(QString::fromLatin1("  "), 3);
+    QCOMPARE(terms(history), QStringList() << QString::fromLatin1("bravo")
+                                           << QString::fromLatin1("alpha"));
+}
+
+void SearchHistoryTest::readdMovesToFront()
+{
+    SearchHistory history;
+    history.add(QString::fromLatin1("alpha"), 1);
+    history.add(QString::fromLatin1("bravo"), 2);
+    history.add(QString::fromLatin1("ALPHA"), 3);
+    QCOMPARE(history.count(), 2);
+    QCOMPARE(terms(history), QStringList() << QString::fromLatin1("ALPHA")
+                                           << QString::fromLatin1("bravo"));
+}
+
+void SearchHistoryTest::fullRingDropsOldest()
+{
+    SearchHistory history;
+    for (int i = 0; i < SearchHistory::Capacity + 5; ++i) {
+        history.add(QString::fromLatin1("term %1").arg(i), i);
+    }
+    QCOMPARE(history.count(), int(SearchHistory::Capacity));
+    QCOMPARE(history.termAt(0), QString::fromLatin1("term %1").arg(SearchHistory::Capacity + 4));
+    QCOMPARE(history.termAt(SearchHistory::Capacity - 1), QString::fromLatin1("term 5"));
+    QVERIFY(history.suggestions(QString::fromLatin1("term 4"), 10).isEmpty());
+}
+
+void SearchHistoryTest::removeClosesGap()
+{
+    SearchHistory history;
+    history.add(QString::fromLatin1("alpha"), 1);
+    history.add(QString::fromLatin1("bravo"), 2);
+    history.add(QString::fromLatin1("charlie"), 3);
+    QVERIFY(history.remove(QString::fromLatin1("Bravo")));
+    QVERIFY(!history.remove(QString::fromLatin1("delta")));
+    QCOMPARE(terms(history), QStringList() << QString::fromLatin1("charlie")
+                                           << QString::fromLatin1("alpha"));
+    history.add(QString::fromLatin1("delta"), 4);
+    QCOMPARE(history.termAt(0), QString::fromLatin1("delta"));
+    QCOMPARE(history.termAt(2), QString::fromLatin1("alpha"));
+}
+
+void SearchHistoryTest::suggestionsByPrefix()
+{
+    SearchHistory history;
+    history.add(QString::fromLatin1("gcores"), 1);
+    history.add(QString::fromLatin1("Gadget Lab"), 2);
+    history.add(QString::fromLatin1("history"), 3);
+    history.add(QString::fromLatin1("games"), 4);
+
+    QCOMPARE(history.suggestions(QString::fromLatin1("G"), 5),
+             QStringList() << QString::fromLatin1("games")
+                           << QString::fromLatin1("Gadget Lab")
+                           << QString::fromLatin1("gcores"));
+    QCOMPARE(history.suggestions(QString::fromLatin1("ga"), 1),
+             QStringList() << QString::fromLatin1("games"));
+    // A complete term is not suggested back to itself.
+    QVERIFY(history.suggestions(QString::fromLatin1("History"), 5).isEmpty());
+    QVERIFY(history.suggestions(QString(), 5).isEmpty());
+}
+
+void SearchHistoryTest::roundTripsVariantList()
+{
+    SearchHistory history;
+    history.add(QString::fromLatin1("alpha"), 10);
+    history.add(QString::fromLatin1("bravo"), 20);
+
+    SearchHistory restored;
+    restored.setEntries(history.toVariantList());
+    QCOMPARE(terms(restored), terms(history));
+    QCOMPARE(restored.toVariantList().first().toMap().value(QString::fromLatin1("searchedAt")).toInt(), 20);
+    QCOMPARE(restored.suggestions(QString::fromLatin1("al"), 5),
+             QStringList() << QString::fromLatin1("alpha"));
+}
+
+QTEST_MAIN(SearchHistoryTest)
+#include "tst_searchhistory.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = searchresults-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_searchresults.cpp \
+    ../../src/SearchResultsModel.cpp
+HEADERS += \
+    ../../src/SearchResultsModel.h
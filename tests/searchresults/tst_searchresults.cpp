@@ -0,0 +1,105 @@
+#include <QtTest/QtTest>
+#include <QtCore/QVariant>
+
+#include "SearchResultsModel.h"
+
+namespace {
+QVariantMap feed(int feedId)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("feedId"), feedId);
+    entry.insert(QString::fromLatin1("title"), QString::fromLatin1("Feed %1").arg(feedId));
+    entry.insert(QString::fromLatin1("guid"), QString::fromLatin1("guid-%1").arg(feedId));
+    return entry;
+}
+
+QVariantList feeds(int first, int last)
+{
+    QVariantList list;
+    for (int feedId = first; feedId <= last; ++feedId) {
+        list << feed(feedId);
+    }
+    return list;
+}
+}
+
+class SearchResultsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void setDropsDuplicates();
+    void appendInsertsOnlyNewRows();
+    void appendOfKnownFeedsIsNoop();
+    void clearResets();
+};
+
+void SearchResultsTest::setDropsDuplicates()
+{
+    SearchResultsModel model;
+    model.setResults(QVariantList() << feed(1) << feed(2) << feed(1) << feed(0) << feed(3));
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(model.feedIds(), QVariantList() << 1 << 2 << 3);
+    QCOMPARE(model.data(model.index(1), SearchResultsModel::TitleRole).toString(),
+             QString::fromLatin1("Feed 2"));
+    QVERIFY(model.contains(3));
+    QVERIFY(!model.contains(4));
+}
+
+void SearchResultsTest::appendInsertsOnlyNewRows()
+{
+    SearchResultsModel model;
+    model.setResults(feeds(1, 10));
+
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy reset(&model, SIGNAL(modelReset()));
+    QSignalSpy counted(&model, SIGNAL(countChanged()));
+    // A later page that repeats a feed shown on the first one (the ranking
+    // moved between requests) and one within itself.
+    QVariantList page = feeds(11, 20);
+    page.insert(3, feed(4));
+    page << feed(12);
+    QCOMPARE(model.appendResults(page), 10);
+
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(counted.count(), 1);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.at(0).at(1).toInt(), 10);
+    QCOMPARE(inserted.at(0).at(2).toInt(), 19);
+    QCOMPARE(model.count(), 20);
+    QCOMPARE(model.get(3).value(QString::fromLatin1("feedId")).toInt(), 4);
+    QCOMPARE(model.get(13).value(QString::fromLatin1("feedId")).toInt(), 14);
+}
+
+void SearchResultsTest::appendOfKnownFeedsIsNoop()
+{
+    SearchResultsModel model;
+    model.setResults(feeds(1, 10));
+
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy counted(&model, SIGNAL(countChanged()));
+    // A cached "Load More" response holds every page, including this one.
+    QCOMPARE(model.appendResults(feeds(1, 10)), 0);
+
+    QCOMPARE(inserted.count(), 0);
+    QCOMPARE(counted.count(), 0);
+    QCOMPARE(model.count(), 10);
+}
+
+void SearchResultsTest::clearResets()
+{
+    SearchResultsModel model;
+    model.setResults(feeds(1, 3));
+
+    QSignalSpy counted(&model, SIGNAL(countChanged()));
+    model.clear();
+    model.clear();
+
+    QCOMPARE(counted.count(), 1);
+    QCOMPARE(model.count(), 0);
+    QVERIFY(!model.contains(1));
+    QCOMPARE(model.appendResults(feeds(1, 2)), 2);
+}
+
+QTEST_MAIN(SearchResultsTest)
+#include "tst_searchresults.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = statementprofiler-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_statementprofiler.cpp \
+    ../../src/StatementProfiler.cpp
+HEADERS += \
+    ../../src/StatementProfiler.h
@@ -0,0 +1,113 @@
+#include <QtTest/QtTest>
+#include <QtCore/QVariant>
+
+#include "StatementProfiler.h"
+
+namespace {
+QVariantMap rowFor(const QVariantList &stats, const QString &sql)
+{
+    for (int i = 0; i < stats.size(); ++i) {
+        const QVariantMap row = stats.at(i).toMap();
+        if (row.value(QString::fromLatin1("sql")).toString() == sql) {
+            return row;
+        }
+    }
+    return QVariantMap();
+}
+}
+
+class StatementProfilerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void aggregatesPerStatement();
+    void p95UsesRecentWindow();
+    void sortsByTotal();
+    void logsSlowStatements();
+    void timerUsesAttachedConnection();
+};
+
+void StatementProfilerTest::aggregatesPerStatement()
+{
+    StatementProfiler profiler;
+    profiler.setSlowThresholdMs(0);
+    const QString sql = QString::fromLatin1("SELECT 1");
+    for (int i = 1; i <= 20; ++i) {
+        profiler.record(sql, i * 1000);
+    }
+    const QVariantMap row = rowFor(profiler.snapshot(), sql);
+    QCOMPARE(row.value(QString::fromLatin1("count")).toInt(), 20);
+    QCOMPARE(row.value(QString::fromLatin1("totalMs")).toDouble(), 210.0);
+    QCOMPARE(row.value(QString::fromLatin1("maxMs")).toDouble(), 20.0);
+    QCOMPARE(row.value(QString::fromLatin1("p95Ms")).toDouble(), 19.0);
+
+    profiler.reset();
+    QVERIFY(profiler.snapshot().isEmpty());
+}
+
+void StatementProfilerTest::p95UsesRecentWindow()
+{
+    StatementProfiler profiler;
+    profiler.setSlowThresholdMs(0);
+    const QString sql = QString::fromLatin1("UPDATE t SET x = ?");
+    const int window = StatementProfiler::SampleWindow;
+    // An early outlier falls out of the window; max still remembers it.
+    profiler.record(sql, 500000);
+    for (int i = 0; i < window; ++i) {
+        profiler.record(sql, 2000);
+    }
+    const QVariantMap row = rowFor(profiler.snapshot(), sql);
+    QCOMPARE(row.value(QString::fromLatin1("count")).toInt(), window + 1);
+    QCOMPARE(row.value(QString::fromLatin1("p95Ms")).toDouble(), 2.0);
+    QCOMPARE(row.value(QString::fromLatin1("maxMs")).toDouble(), 500.0);
+}
+
+void StatementProfilerTest::sortsByTotal()
+{
+    StatementProfiler profiler;
+    profiler.setSlowThresholdMs(0);
+    profiler.record(QString::fromLatin1("SELECT a"), 1000);
+    profiler.record(QString::fromLatin1("SELECT b"), 3000);
+    profiler.record(QString::fromLatin1("SELECT a"), 1000);
+    const QVariantList stats = profiler.snapshot();
+    QCOMPARE(stats.size(), 2);
+    QCOMPARE(stats.at(0).toMap().value(QString::fromLatin1("sql")).toString(), QString::fromLatin1("SELECT b"));
+}
+
+void StatementProfilerTest::logsSlowStatements()
+{
+    StatementProfiler profiler;
+    profiler.setSlowThresholdMs(10);
+    QTest::ignoreMessage(QtWarningMsg, "Slow statement (12.5 ms): SELECT slow FROM t");
+    profiler.record(QString::fromLatin1("SELECT slow\n    FROM t"), 12500);
+    profiler.record(QString::fromLatin1("SELECT fast"), 9000);
+}
+
+void StatementProfilerTest::timerUsesAttachedConnection()
+{
+    StatementProfiler profiler;
+    profiler.setSlowThresholdMs(0);
+    const QString connection = QString::fromLatin1("profiler_test");
+    const QString sql = QString::fromLatin1("PRAGMA user_version");
+    StatementProfiler::attach(connection, &profiler);
+    QCOMPARE(StatementProfiler::forConnection(connection), &profiler);
+    {
+        StatementTimer timer(connection, sql);
+    }
+    {
+        // Nothing attached under this name: not recorded anywhere.
+        StatementTimer timer(QString::fromLatin1("other"), sql);
+    }
+    QCOMPARE(rowFor(profiler.snapshot(), sql).value(QString::fromLatin1("count")).toInt(), 1);
+
+    StatementProfiler replacement;
+    StatementProfiler::attach(connection, &replacement);
+    StatementProfiler::detach(connection, &profiler);
+    QCOMPARE(StatementProfiler::forConnection(connection), &replacement);
+    StatementProfiler::detach(connection, &replacement);
+    QVERIFY(!StatementProfiler::forConnection(connection));
+}
+
+QTEST_MAIN(StatementProfilerTest)
+#include "tst_statementprofiler.moc"
@@ -0,0 +1,18 @@
+TEMPLATE = app
+TARGET = storagebench-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core gui sql testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_storagebench.cpp \
+    ../../src/StorageWorker.cpp \
+    ../../src/StatementCache.cpp \
+    ../../src/StatementProfiler.cpp \
+    ../../src/Opml.cpp
+HEADERS += \
+    ../../src/StorageWorker.h \
+    ../../src/StatementCache.h \
+    ../../src/StatementProfiler.h \
+    ../../src/Opml.h
@@ -0,0 +1,521 @@
+#include <QtTest/QtTest>
+#include <QtCore/QCache>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QVariant>
+#include <QtGui/QDesktopServices>
+#include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include "StorageManager.h"
+#include "StorageWorker.h"
+
+namespace {
+const char *const kConnectionName = "podin";
+const char *const kEpisodeId = "bench-episode";
+const int kSimulatedEpisodes = 5000;
+const int kEpisodeListSize = 100;
+// History deep enough that OFFSET paging has to walk thousands of rows.
+const int kHistorySize = 5000;
+const int kHistoryPageDepth = 4000;
+const int kHistoryPageSize = 20;
+// Cached episodes behind the local search benchmark.
+const int kSearchFeeds = 10;
+const int kSearchEpisodesPerFeed = 200;
+// A two-hour session: a progress save per simulated 10 s tick (the worst
+// case, far denser than the 5 min journal flush), plus a cache refresh
+// every 60 ticks and a pause every 180.
+const int kSessionTicks = 720;
+const int kCacheRefreshEvery = 60;
+const int kPauseEvery = 180;
+
+// Bytes currently allocated on the heap, or -1 where we cannot tell.
+qint64 heapInUse()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+    return static_cast<qint64>(mallinfo().uordblks);
+#else
+    return -1;
+#endif
+}
+
+// Replicates the pre-cache code path: connection lookup, fresh QSqlQuery and
+// prepare() on every call. Kept here as the "before" baseline.
+QVariantMap uncachedLoadEpisodeState(const QString &episodeId)
+{
+    QVariantMap state;
+    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
+    QSqlQuery query(db);
+    query.prepare(QLatin1String("SELECT played_position_ms, play_state FROM episodes WHERE episode_id = ?"));
+    query.addBindValue(episodeId);
+    if (query.exec() && query.next()) {
+        state.insert(QString::fromLatin1("positionMs"), query.value(0).toInt());
+        state.insert(QString::fromLatin1("playState"), query.value(1).toInt());
+    }
+    return state;
+}
+
+QVariantList progressEntry(const QString &episodeId, int positionMs, int playState)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("episodeId"), episodeId);
+    entry.insert(QString::fromLatin1("feedId"), 1);
+    entry.insert(QString::fromLatin1("title"), QString::fromLatin1("Benchmark episode"));
+    entry.insert(QString::fromLatin1("audioUrl"), QString::fromLatin1("http://example.com/bench.mp3"));
+    entry.insert(QString::fromLatin1("durationSeconds"), 3600);
+    entry.insert(QString::fromLatin1("positionMs"), positionMs);
+    entry.insert(QString::fromLatin1("lastPlayedAt"), static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
+    entry.insert(QString::fromLatin1("enclosureType"), QString::fromLatin1("audio/mpeg"));
+    entry.insert(QString::fromLatin1("publishedAt"), 0);
+    entry.insert(QString::fromLatin1("playState"), playState);
+    return QVariantList() << entry;
+}
+
+// The OFFSET paging the keyset cursor replaced, kept as the baseline.
+QVariantList offsetRecentEpisodes(int offset, int limit)
+{
+    QVariantList page;
+    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
+    QSqlQuery query(db);
+    query.prepare(QLatin1String("SELECT episode_id, last_played_at FROM episodes "
+                                "ORDER BY last_played_at DESC, episode_id DESC LIMIT ? OFFSET ?"));
+    query.addBindValue(limit);
+    query.addBindValue(offset);
+    if (query.exec()) {
+        while (query.next()) {
+            page << query.value(0);
+        }
+    }
+    return page;
+}
+
+bool uncachedSaveEpisodeProgress(const QString &episodeId, int positionMs, int playState)
+{
+    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
+    QSqlQuery query(db);
+    query.prepare(QLatin1String("INSERT OR REPLACE INTO episodes "
+                                "(episode_id, feed_id, title, audio_url, duration_seconds, "
+                                "played_position_ms, last_played_at, enclosure_type, published_at, play_state) "
+                                "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
+    query.addBindValue(episodeId);
+    query.addBindValue(1);
+    query.addBindValue(QString::fromLatin1("Benchmark episode"));
+    query.addBindValue(QString::fromLatin1("http://example.com/bench.mp3"));
+    query.addBindValue(3600);
+    query.addBindValue(positionMs);
+    query.addBindValue(static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()));
+    query.addBindValue(QString::fromLatin1("audio/mpeg"));
+    query.addBindValue(0);
+    query.addBindValue(playState);
+    return query.exec();
+}
+}
+
+class StorageBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void loadEpisodeStateUncached();
+    void loadEpisodeStateCached();
+    void saveEpisodeProgressUncached();
+    void saveEpisodeProgressCached();
+    void lastSavedProgressMemory();
+    void loadEpisodeListPerRow();
+    void loadEpisodeListBatched();
+    void loadEpisodeListJoined();
+    void recentEpisodesOffset();
+    void recentEpisodesKeyset();
+    void localSearch();
+    void playbackSessionWriteLatency_data();
+    void playbackSessionWriteLatency();
+    void pruneInSteps();
+
+private:
+    QStringList seedEpisodeList(int count);
+    bool seedHistory();
+
+private:
+    // Driven synchronously on the test thread; no StorageManager thread hop,
+    // so the numbers are pure SQLite + statement overhead.
+    QScopedPointer<StorageWorker> m_worker;
+};
+
+void StorageBench::initTestCase()
+{
+    // Keep the benchmark database away from the real app data.
+    QCoreApplication::setOrganizationName(QString::fromLatin1("PodinTests"));
+    QCoreApplication::setApplicationName(QString::fromLatin1("storagebench"));
+    const QString dataDir = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+    QVERIFY2(!dataDir.isEmpty(), "No DataLocation available");
+    QFile::remove(QDir(dataDir).filePath(QLatin1String("podin.db")));
+
+    m_worker.reset(new StorageWorker);
+    m_worker->open();
+
+    // Seed a row so reads hit the table, not an empty result.
+    QVERIFY(m_worker->writeProgress(progressEntry(QString::fromLatin1(kEpisodeId), 1000, 2)));
+}
+
+void StorageBench::cleanupTestCase()
+{
+    m_worker->close();
+    m_worker.reset();
+}
+
+void StorageBench::loadEpisodeStateUncached()
+{
+    const QString episodeId = QString::fromLatin1(kEpisodeId);
+    QVariantMap state;
+    QBENCHMARK {
+        state = uncachedLoadEpisodeState(episodeId);
+    }
+    QCOMPARE(state.value(QString::fromLatin1("positionMs")).toInt(), 1000);
+}
+
+void StorageBench::loadEpisodeStateCached()
+{
+    const QString episodeId = QString::fromLatin1(kEpisodeId);
+    QVariantMap state;
+    QBENCHMARK {
+        state = m_worker->readEpisodeState(episodeId);
+    }
+    QCOMPARE(state.value(QString::fromLatin1("positionMs")).toInt(), 1000);
+}
+
+void StorageBench::saveEpisodeProgressUncached()
+{
+    const QString episodeId = QString::fromLatin1("bench-uncached");
+    int positionMs = 0;
+    QBENCHMARK {
+        positionMs += 1000;
+        QVERIFY(uncachedSaveEpisodeProgress(episodeId, positionMs, 2));
+    }
+}
+
+void StorageBench::saveEpisodeProgressCached()
+{
+    // One-entry batch: the same work a pause/stop flush does.
+    const QString episodeId = QString::fromLatin1("bench-cached");
+    int positionMs = 0;
+    QBENCHMARK {
+        positionMs += 1000;
+        QVERIFY(m_worker->writeProgress(progressEntry(episodeId, positionMs, 2)));
+    }
+    const QVariantMap state = m_worker->readEpisodeState(episodeId);
+    QCOMPARE(state.value(QString::fromLatin1("positionMs")).toInt(), positionMs);
+    QCOMPARE(state.value(QString::fromLatin1("durationSeconds")).toInt(), 3600);
+}
+
+void StorageBench::lastSavedProgressMemory()
+{
+    // Each episode is saved a few times (play, pause, stop) the way a long
+    // listening session would, first into the old unbounded hash, then into
+    // the bounded LRU StorageManager uses now.
+    qint64 before = heapInUse();
+    qint64 unboundedBytes = -1;
+    int unboundedEntries = 0;
+    {
+        QHash<QString, QPair<int,int> > unbounded;
+        for (int i = 0; i < kSimulatedEpisodes; ++i) {
+            const QString episodeId = QString::number(1000000 + i);
+            for (int state = 1; state <= 3; ++state) {
+                unbounded.insert(episodeId, qMakePair(i * 1000, state % 3));
+            }
+        }
+        unboundedEntries = unbounded.size();
+        if (before >= 0) {
+            unboundedBytes = heapInUse() - before;
+        }
+    }
+
+    before = heapInUse();
+    qint64 lruBytes = -1;
+    int lruEntries = 0;
+    {
+        QCache<QString, QPair<int,int> > lru(StorageManager::LastSavedProgressCapacity);
+        for (int i = 0; i < kSimulatedEpisodes; ++i) {
+            const QString episodeId = QString::number(1000000 + i);
+            for (int state = 1; state <= 3; ++state) {
+                lru.object(episodeId);
+                lru.insert(episodeId, new QPair<int,int>(i * 1000, state % 3));
+            }
+        }
+        lruEntries = lru.size();
+        if (before >= 0) {
+            lruBytes = heapInUse() - before;
+        }
+    }
+
+    qDebug() << "lastSavedProgress after" << kSimulatedEpisodes << "episodes:"
+             << "unbounded hash" << unboundedEntries << "entries," << unboundedBytes << "bytes;"
+             << "LRU" << lruEntries << "entries," << lruBytes << "bytes"
+             << "(-1 = heap size not available on this platform)";
+
+    QCOMPARE(unboundedEntries, kSimulatedEpisodes);
+    QCOMPARE(lruEntries, static_cast<int>(StorageManager::LastSavedProgressCapacity));
+    if (unboundedBytes >= 0 && lruBytes >= 0) {
+        QVERIFY(lruBytes < unboundedBytes);
+    }
+}
+
+QStringList StorageBench::seedEpisodeList(int count)
+{
+    QStringList ids;
+    QVariantList entries;
+    for (int i = 0; i < count; ++i) {
+        const QString episodeId = QString::fromLatin1("list-%1").arg(i);
+        ids << episodeId;
+        // Every other episode has been played, like a typical feed.
+        if (i % 2 == 0) {
+            entries << progressEntry(episodeId, 1000 + i, 2);
+        }
+    }
+    if (!m_worker->writeProgress(entries)) {
+        return QStringList();
+    }
+    return ids;
+}
+
+void StorageBench::loadEpisodeListPerRow()
+{
+    // Baseline: one lookup per visible row.
+    const QStringList ids = seedEpisodeList(kEpisodeListSize);
+    QVERIFY(!ids.isEmpty());
+    int found = 0;
+    QBENCHMARK {
+        found = 0;
+        for (int i = 0; i < ids.size(); ++i) {
+            if (m_worker->readEpisodeState(ids.at(i)).value(QString::fromLatin1("positionMs")).toInt() > 0) {
+                ++found;
+            }
+        }
+    }
+    QCOMPARE(found, kEpisodeListSize / 2);
+}
+
+void StorageBench::loadEpisodeListBatched()
+{
+    const QStringList ids = seedEpisodeList(kEpisodeListSize);
+    QVERIFY(!ids.isEmpty());
+    QVariantMap states;
+    QBENCHMARK {
+        states = m_worker->readEpisodeStates(ids);
+    }
+    QCOMPARE(states.size(), kEpisodeListSize / 2);
+}
+
+void StorageBench::loadEpisodeListJoined()
+{
+    // Above the temp-table threshold the lookup switches to a join.
+    const int count = 2000;
+    const QStringList ids = seedEpisodeList(count);
+    QVERIFY(!ids.isEmpty());
+    QVariantMap states;
+    QBENCHMARK {
+        states = m_worker->readEpisodeStates(ids);
+    }
+    QCOMPARE(states.size(), count / 2);
+}
+
+bool StorageBench::seedHistory()
+{
+    // Distinct last_played_at per row, oldest first.
+    const int base = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()) - kHistorySize;
+    QVariantList entries;
+    for (int i = 0; i < kHistorySize; ++i) {
+        QVariantMap entry = progressEntry(QString::fromLatin1("history-%1").arg(i, 5, 10, QLatin1Char('0')),
+                                          1000 + i, 1).first().toMap();
+        entry.insert(QString::fromLatin1("lastPlayedAt"), base + i);
+        entries << entry;
+    }
+    return m_worker->writeProgress(entries);
+}
+
+void StorageBench::recentEpisodesOffset()
+{
+    QVERIFY(seedHistory());
+    QVariantList page;
+    QBENCHMARK {
+        page = offsetRecentEpisodes(kHistoryPageDepth, kHistoryPageSize);
+    }
+    QCOMPARE(page.size(), kHistoryPageSize);
+}
+
+void StorageBench::recentEpisodesKeyset()
+{
+    QVERIFY(seedHistory());
+    // Cursor of the last row of the page before kHistoryPageDepth, as the
+    // model would hold it after scrolling that far.
+    const QVariantList before = offsetRecentEpisodes(kHistoryPageDepth - 1, 1);
+    QCOMPARE(before.size(), 1);
+    const QString cursorId = before.first().toString();
+    QSqlQuery lookup(QSqlDatabase::database(QLatin1String(kConnectionName)));
+    lookup.prepare(QLatin1String("SELECT last_played_at FROM episodes WHERE episode_id = ?"));
+    lookup.addBindValue(cursorId);
+    QVERIFY(lookup.exec() && lookup.next());
+    const int cursorPlayedAt = lookup.value(0).toInt();
+
+    QVariantList page;
+    QBENCHMARK {
+        page = m_worker->readRecentEpisodes(cursorPlayedAt, cursorId, kHistoryPageSize, false);
+    }
+    QCOMPARE(page.size(), kHistoryPageSize);
+    // Same rows the OFFSET query returns for that depth.
+    const QVariantList expected = offsetRecentEpisodes(kHistoryPageDepth, kHistoryPageSize);
+    QCOMPARE(page.first().toMap().value(QString::fromLatin1("episodeId")), expected.first());
+    QCOMPARE(page.last().toMap().value(QString::fromLatin1("episodeId")), expected.last());
+}
+
+void StorageBench::localSearch()
+{
+    for (int feed = 1; feed <= kSearchFeeds; ++feed) {
+        m_worker->subscribe(1000 + feed, QString::fromLatin1("Search feed %1").arg(feed),
+                            QString(), QString(), QString());
+        QVariantList episodes;
+        for (int i = 0; i < kSearchEpisodesPerFeed; ++i) {
+            QVariantMap episode;
+            episode.insert(QString::fromLatin1("id"), QString::fromLatin1("search-%1-%2").arg(feed).arg(i));
+            episode.insert(QString::fromLatin1("title"), QString::fromLatin1("Episode %1 of feed %2").arg(i).arg(feed));
+            episode.insert(QString::fromLatin1("description"),
+                           QString::fromLatin1("Show notes for episode %1, about topic%2").arg(i).arg(i % 50));
+            episodes << episode;
+        }
+        QVERIFY(m_worker->writeCachedEpisodes(1000 + feed, episodes));
+    }
+
+    QVariantList results;
+    QBENCHMARK {
+        results = m_worker->readLocalSearch(QString::fromLatin1("topic7"));
+    }
+    // Only episode descriptions mention topics.
+    QVERIFY(!results.isEmpty());
+    QCOMPARE(results.first().toMap().value(QString::fromLatin1("kind")).toString(),
+             QString::fromLatin1("episode"));
+
+    results = m_worker->readLocalSearch(QString::fromLatin1("search FEED 3"));
+    QVERIFY(!results.isEmpty());
+    QCOMPARE(results.first().toMap().value(QString::fromLatin1("feedId")).toInt(), 1003);
+
+    // Every word has to match, in any order.
+    results = m_worker->readLocalSearch(QString::fromLatin1("feed search"));
+    QVERIFY(!results.isEmpty());
+    results = m_worker->readLocalSearch(QString::fromLatin1("feed nomatch"));
+    QVERIFY(results.isEmpty());
+}
+
+void StorageBench::playbackSessionWriteLatency_data()
+{
+    QTest::addColumn<bool>("tuned");
+    QTest::newRow("defaults") << false;
+    QTest::newRow("tuned") << true;
+}
+
+void StorageBench::playbackSessionWriteLatency()
+{
+    QFETCH(bool, tuned);
+
+    // "defaults" is what the connection ran with before the tuning profile:
+    // FULL sync and SQLite's automatic checkpoint every 1000 pages.
+    QSqlDatabase db = QSqlDatabase::database(QLatin1String(kConnectionName));
+    QSqlQuery pragma(db);
+    QVERIFY(pragma.exec(QLatin1String(tuned ? "PRAGMA synchronous=NORMAL" : "PRAGMA synchronous=FULL")));
+    QVERIFY(pragma.exec(QLatin1String(tuned ? "PRAGMA wal_autocheckpoint=0" : "PRAGMA wal_autocheckpoint=1000")));
+    m_worker->checkpoint();
+
+    QVariantList cacheList;
+    for (int i = 0; i < 10; ++i) {
+        QVariantMap episode;
+        episode.insert(QString::fromLatin1("id"), QString::number(9000 + i));
+        episode.insert(QString::fromLatin1("title"), QString::fromLatin1("Cached episode %1").arg(i));
+        episode.insert(QString::fromLatin1("description"), QString(400, QLatin1Char('x')));
+        cacheList << episode;
+    }
+
+    QList<qint64> latenciesMs;
+    QElapsedTimer timer;
+    for (int tick = 0; tick < kSessionTicks; ++tick) {
+        timer.start();
+        QVERIFY(m_worker->writeProgress(progressEntry(QString::fromLatin1("session"), tick * 10000, 1)));
+        latenciesMs << timer.elapsed();
+
+        if (tick % kCacheRefreshEvery == 0) {
+            // Changing descriptions force real row rewrites.
+            QVariantMap first = cacheList.first().toMap();
+            first.insert(QString::fromLatin1("description"), QString::number(tick));
+            cacheList[0] = first;
+            timer.start();
+            QVERIFY(m_worker->writeCachedEpisodes(4242, cacheList));
+            latenciesMs << timer.elapsed();
+        }
+        if (tuned && tick % kPauseEvery == kPauseEvery - 1) {
+            // What StorageManager does once playback is paused; not a
+            // playback-time write, so it is not counted.
+            m_worker->checkpoint();
+        }
+    }
+
+    // QElapsedTimer has millisecond resolution on Qt 4.7.
+    qSort(latenciesMs);
+    const qint64 worstMs = latenciesMs.last();
+    const qint64 p95Ms = latenciesMs.at(latenciesMs.size() * 95 / 100);
+    qDebug() << (tuned ? "tuned:" : "defaults:") << latenciesMs.size() << "writes, p95"
+             << p95Ms << "ms, worst" << worstMs << "ms";
+    QTest::setBenchmarkResult(worstMs, QTest::WalltimeMilliseconds);
+}
+
+void StorageBench::pruneInSteps()
+{
+    // All last played 60 days ago: past the finished and unsubscribed
+    // retention, within the 180-day limit for anything else.
+    const int longAgo = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()) - 60 * 24 * 60 * 60;
+    QVariantList entries;
+    // More finished rows than one delete chunk holds.
+    for (int i = 0; i < 450; ++i) {
+        QVariantMap entry = progressEntry(QString::fromLatin1("prune-finished-%1").arg(i), 3600 * 1000, 0)
+            .first().toMap();
+        entry.insert(QString::fromLatin1("lastPlayedAt"), longAgo);
+        entries << entry;
+    }
+    // Feed 777 is not subscribed.
+    const char *const kUnsubscribed[] = { "prune-halfway", "prune-unstarted", "prune-done" };
+    const int kPositionsMs[] = { 1800 * 1000, 0, 3600 * 1000 };
+    for (int i = 0; i < 3; ++i) {
+        QVariantMap entry = progressEntry(QString::fromLatin1(kUnsubscribed[i]), kPositionsMs[i], 2)
+            .first().toMap();
+        entry.insert(QString::fromLatin1("feedId"), 777);
+        entry.insert(QString::fromLatin1("lastPlayedAt"), longAgo);
+        entries << entry;
+    }
+    QVERIFY(m_worker->writeProgress(entries));
+
+    QSignalSpy steps(m_worker.data(), SIGNAL(pruneStepFinished(bool)));
+    do {
+        m_worker->pruneStep();
+        QVERIFY(steps.size() < 100);
+    } while (steps.last().at(0).toBool());
+
+    // A deleted row reads back as the zero default.
+    const QString duration = QString::fromLatin1("durationSeconds");
+    QCOMPARE(m_worker->readEpisodeState(QString::fromLatin1("prune-finished-0")).value(duration).toInt(), 0);
+    QCOMPARE(m_worker->readEpisodeState(QString::fromLatin1("prune-finished-449")).value(duration).toInt(), 0);
+    QCOMPARE(m_worker->readEpisodeState(QString::fromLatin1(kUnsubscribed[0]))
+             .value(QString::fromLatin1("positionMs")).toInt(), kPositionsMs[0]);
+    QCOMPARE(m_worker->readEpisodeState(QString::fromLatin1(kUnsubscribed[1])).value(duration).toInt(), 0);
+    QCOMPARE(m_worker->readEpisodeState(QString::fromLatin1(kUnsubscribed[2])).value(duration).toInt(), 0);
+    // Played just now.
+    QCOMPARE(m_worker->readEpisodeState(QString::fromLatin1(kEpisodeId)).value(duration).toInt(), 3600);
+}
+
+QTEST_MAIN(StorageBench)
+#include "tst_storagebench.moc"
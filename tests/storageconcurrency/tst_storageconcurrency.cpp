@@ -0,0 +1,217 @@
+#include <QtTest/QtTest>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVariant>
+#include <QtGui/QDesktopServices>
+
+#include <stdio.h>
+
+#include "StatementProfiler.h"
+#include "StorageWorker.h"
+
+namespace {
+// A history list long enough that one read takes real time.
+const int kHistorySize = 3000;
+const int kReadPageSize = 1000;
+// Writer load: journal-sized progress batches back to back, with an
+// episode cache refresh now and then.
+const int kWriteRounds = 300;
+const int kProgressBatchSize = 20;
+const int kCacheRefreshEvery = 25;
+// Reads never wait for the writer under WAL; anything near SQLite's busy
+// timeout (5 s in QSQLITE) means they did.
+const qint64 kMaxReadLatencyMs = 250;
+
+QAtomicInt gStorageErrors;
+QtMsgHandler gPreviousHandler = 0;
+
+void countStorageErrors(QtMsgType type, const char *msg)
+{
+    // logError() and StatementCache report failures, SQLITE_BUSY included,
+    // as "Storage error (...)" warnings.
+    if (type == QtWarningMsg && qstrncmp(msg, "Storage error", 13) == 0) {
+        gStorageErrors.ref();
+    }
+    if (gPreviousHandler) {
+        gPreviousHandler(type, msg);
+    } else {
+        fprintf(stderr, "%s\n", msg);
+    }
+}
+
+QVariantMap progressEntry(const QString &episodeId, int positionMs, int lastPlayedAt)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("episodeId"), episodeId);
+    entry.insert(QString::fromLatin1("feedId"), 1);
+    entry.insert(QString::fromLatin1("title"), QString::fromLatin1("Stress episode"));
+    entry.insert(QString::fromLatin1("audioUrl"), QString::fromLatin1("http://example.com/stress.mp3"));
+    entry.insert(QString::fromLatin1("durationSeconds"), 3600);
+    entry.insert(QString::fromLatin1("positionMs"), positionMs);
+    entry.insert(QString::fromLatin1("lastPlayedAt"), lastPlayedAt);
+    entry.insert(QString::fromLatin1("enclosureType"), QString::fromLatin1("audio/mpeg"));
+    entry.insert(QString::fromLatin1("publishedAt"), 0);
+    entry.insert(QString::fromLatin1("playState"), 1);
+    return entry;
+}
+
+// Runs the history query on a read-only connection in its own thread, as
+// StorageManager's reader does, until told to stop.
+class ReadLoop : public QThread
+{
+public:
+    explicit ReadLoop(const QString &path)
+        : m_path(path)
+        , m_shortReads(0)
+    {
+    }
+
+    void stop()
+    {
+        m_stop.fetchAndStoreOrdered(1);
+    }
+
+    QList<qint64> latenciesUs() const { return m_latenciesUs; }
+    int shortReads() const { return m_shortReads; }
+    QString newestEpisodeId() const { return m_newestEpisodeId; }
+
+protected:
+    void run()
+    {
+        StorageWorker reader(StorageWorker::ReadOnly);
+        reader.openReadOnly(m_path);
+        QElapsedTimer timer;
+        while (!m_stop) {
+            timer.start();
+            const QVariantList page = reader.readRecentEpisodes(0x7fffffff, QString(), kReadPageSize, false);
+            m_latenciesUs << StatementProfiler::elapsedUs(timer);
+            if (page.size() < kReadPageSize) {
+                ++m_shortReads;
+            }
+        }
+        // Everything the writer committed is visible by now.
+        const QVariantList newest = reader.readRecentEpisodes(0x7fffffff, QString(), 1, false);
+        if (!newest.isEmpty()) {
+            m_newestEpisodeId = newest.first().toMap().value(QString::fromLatin1("episodeId")).toString();
+        }
+        reader.close();
+    }
+
+private:
+    QString m_path;
+    QAtomicInt m_stop;
+    QList<qint64> m_latenciesUs;
+    int m_shortReads;
+    QString m_newestEpisodeId;
+};
+}
+
+class StorageConcurrencyTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void readsDuringWrites();
+
+private:
+    QString m_dbPath;
+    QScopedPointer<StorageWorker> m_writer;
+};
+
+void StorageConcurrencyTest::initTestCase()
+{
+    QCoreApplication::setOrganizationName(QString::fromLatin1("PodinTests"));
+    QCoreApplication::setApplicationName(QString::fromLatin1("storageconcurrency"));
+    const QString dataDir = QDesktopServices::storageLocation(QDesktopServices::DataLocation);
+    QVERIFY2(!dataDir.isEmpty(), "No DataLocation available");
+    m_dbPath = QDir::toNativeSeparators(QDir(dataDir).filePath(QLatin1String("podin.db")));
+    QFile::remove(m_dbPath);
+    QFile::remove(m_dbPath + QLatin1String("-wal"));
+    QFile::remove(m_dbPath + QLatin1String("-shm"));
+
+    m_writer.reset(new StorageWorker(StorageWorker::ReadWrite));
+    m_writer->open();
+
+    const int base = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t()) - kHistorySize;
+    QVariantList entries;
+    for (int i = 0; i < kHistorySize; ++i) {
+        entries << progressEntry(QString::fromLatin1("history-%1").arg(i, 5, 10, QLatin1Char('0')), 1000, base + i);
+    }
+    QVERIFY(m_writer->writeProgress(entries));
+
+    gPreviousHandler = qInstallMsgHandler(countStorageErrors);
+}
+
+void StorageConcurrencyTest::cleanupTestCase()
+{
+    qInstallMsgHandler(gPreviousHandler);
+    m_writer->close();
+    m_writer.reset();
+}
+
+void StorageConcurrencyTest::readsDuringWrites()
+{
+    ReadLoop readLoop(m_dbPath);
+    readLoop.start();
+
+    QVariantList cacheList;
+    for (int i = 0; i < 50; ++i) {
+        QVariantMap episode;
+        episode.insert(QString::fromLatin1("id"), QString::number(7000 + i));
+        episode.insert(QString::fromLatin1("title"), QString::fromLatin1("Cached episode %1").arg(i));
+        episode.insert(QString::fromLatin1("description"), QString(400, QLatin1Char('x')));
+        cacheList << episode;
+    }
+
+    const int now = static_cast<int>(QDateTime::currentDateTimeUtc().toTime_t());
+    QString lastWritten;
+    QElapsedTimer writeTimer;
+    writeTimer.start();
+    for (int round = 0; round < kWriteRounds; ++round) {
+        QVariantList batch;
+        for (int i = 0; i < kProgressBatchSize; ++i) {
+            lastWritten = QString::fromLatin1("live-%1-%2").arg(round, 4, 10, QLatin1Char('0')).arg(i, 2, 10, QLatin1Char('0'));
+            batch << progressEntry(lastWritten, round * 1000, now + round);
+        }
+        QVERIFY(m_writer->writeProgress(batch));
+        if (round % kCacheRefreshEvery == 0) {
+            QVariantMap first = cacheList.first().toMap();
+            first.insert(QString::fromLatin1("description"), QString::number(round));
+            cacheList[0] = first;
+            QVERIFY(m_writer->writeCachedEpisodes(4242, cacheList));
+        }
+        if (round % 100 == 99) {
+            m_writer->checkpoint();
+        }
+    }
+    const qint64 writeMs = writeTimer.elapsed();
+
+    readLoop.stop();
+    QVERIFY(readLoop.wait(30000));
+
+    QList<qint64> latencies = readLoop.latenciesUs();
+    QVERIFY2(!latencies.isEmpty(), "Reader never ran");
+    qSort(latencies);
+    const qint64 p95Us = latencies.at(latencies.size() * 95 / 100);
+    const qint64 worstUs = latencies.last();
+    qDebug() << kWriteRounds << "write transactions in" << writeMs << "ms;"
+             << latencies.size() << "reads of" << kReadPageSize << "rows, p95"
+             << p95Us / 1000.0 << "ms, worst" << worstUs / 1000.0 << "ms";
+
+    QCOMPARE(int(gStorageErrors), 0);
+    QCOMPARE(readLoop.shortReads(), 0);
+    QVERIFY2(worstUs < kMaxReadLatencyMs * 1000,
+             qPrintable(QString::fromLatin1("worst read took %1 ms").arg(worstUs / 1000.0)));
+    // Lexically the last of the newest round; the reader sees the final commit.
+    QCOMPARE(readLoop.newestEpisodeId(), lastWritten);
+}
+
+QTEST_MAIN(StorageConcurrencyTest)
+#include "tst_storageconcurrency.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = subscriptionmodel-test
+CONFIG += qt console testcase
+CONFIG -= app_bundle
+CONFIG -= debug_and_release
+CONFIG += release
+QT += core testlib
+INCLUDEPATH += ../../src
+SOURCES += tst_subscriptionmodel.cpp \
+    ../../src/SubscriptionListModel.cpp
+HEADERS += \
+    ../../src/SubscriptionListModel.h
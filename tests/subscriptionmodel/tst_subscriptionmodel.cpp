@@ -0,0 +1,122 @@
+#include <QtTest/QtTest>
+#include <QtCore/QVariant>
+
+#include "SubscriptionListModel.h"
+
+namespace {
+QVariantMap subscription(int feedId, const QString &title)
+{
+    QVariantMap entry;
+    entry.insert(QString::fromLatin1("feedId"), feedId);
+    entry.insert(QString::fromLatin1("title"), title);
+    entry.insert(QString::fromLatin1("image"), QString::fromLatin1("http://example.com/%1.png").arg(feedId));
+    return entry;
+}
+
+QStringList titles(const SubscriptionListModel &model)
+{
+    QStringList list;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        list << model.data(model.index(row), SubscriptionListModel::TitleRole).toString();
+    }
+    return list;
+}
+}
+
+class SubscriptionModelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void loadSortsByTitle();
+    void insertIsSingleRow();
+    void updateKeepsRow();
+    void updateMovesRenamedRow();
+    void removeIsSingleRow();
+};
+
+void SubscriptionModelTest::loadSortsByTitle()
+{
+    SubscriptionListModel model;
+    model.setSubscriptions(QVariantList()
+                           << subscription(3, QString::fromLatin1("Charlie"))
+                           << subscription(1, QString::fromLatin1("Alpha"))
+                           << subscription(2, QString::fromLatin1("Bravo")));
+    QCOMPARE(model.count(), 3);
+    QCOMPARE(titles(model), QStringList() << QString::fromLatin1("Alpha")
+                                          << QString::fromLatin1("Bravo")
+                                          << QString::fromLatin1("Charlie"));
+    QVERIFY(model.contains(2));
+    QVERIFY(!model.contains(4));
+}
+
+void SubscriptionModelTest::insertIsSingleRow()
+{
+    SubscriptionListModel model;
+    model.setSubscriptions(QVariantList()
+                           << subscription(1, QString::fromLatin1("Alpha"))
+                           << subscription(3, QString::fromLatin1("Charlie")));
+
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy reset(&model, SIGNAL(modelReset()));
+    model.insertOrUpdate(subscription(2, QString::fromLatin1("Bravo")));
+
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.at(0).at(1).toInt(), 1);
+    QCOMPARE(inserted.at(0).at(2).toInt(), 1);
+    QCOMPARE(model.get(1).value(QString::fromLatin1("feedId")).toInt(), 2);
+}
+
+void SubscriptionModelTest::updateKeepsRow()
+{
+    SubscriptionListModel model;
+    model.setSubscriptions(QVariantList() << subscription(1, QString::fromLatin1("Alpha")));
+
+    QSignalSpy inserted(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy changed(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+    QVariantMap updated = subscription(1, QString::fromLatin1("Alpha"));
+    updated.insert(QString::fromLatin1("image"), QString::fromLatin1("http://example.com/new.png"));
+    model.insertOrUpdate(updated);
+
+    QCOMPARE(inserted.count(), 0);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(model.count(), 1);
+    QCOMPARE(model.get(0).value(QString::fromLatin1("image")).toString(),
+             QString::fromLatin1("http://example.com/new.png"));
+}
+
+void SubscriptionModelTest::updateMovesRenamedRow()
+{
+    SubscriptionListModel model;
+    model.setSubscriptions(QVariantList()
+                           << subscription(1, QString::fromLatin1("Alpha"))
+                           << subscription(2, QString::fromLatin1("Bravo")));
+    model.insertOrUpdate(subscription(1, QString::fromLatin1("Zulu")));
+
+    QCOMPARE(model.count(), 2);
+    QCOMPARE(titles(model), QStringList() << QString::fromLatin1("Bravo")
+                                          << QString::fromLatin1("Zulu"));
+}
+
+void SubscriptionModelTest::removeIsSingleRow()
+{
+    SubscriptionListModel model;
+    model.setSubscriptions(QVariantList()
+                           << subscription(1, QString::fromLatin1("Same"))
+                           << subscription(2, QString::fromLatin1("Same"))
+                           << subscription(3, QString::fromLatin1("Same")));
+
+    QSignalSpy removed(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    model.remove(2);
+    model.remove(42);
+
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), 1);
+    QCOMPARE(model.count(), 2);
+    QVERIFY(!model.contains(2));
+    QCOMPARE(model.get(1).value(QString::fromLatin1("feedId")).toInt(), 3);
+}
+
+QTEST_MAIN(SubscriptionModelTest)
+#include "tst_subscriptionmodel.moc"